@@ -10,6 +10,7 @@ with-shvwebsockets {
 
 CONFIG += C++11
 CONFIG += hide_symbols
+include( $$PWD/../libshvchainpack/rpcvalueflatmap.pri )
 
 TEMPLATE = lib
 TARGET = shvbroker
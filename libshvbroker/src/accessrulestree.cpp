@@ -0,0 +1,164 @@
+#include "accessrulestree.h"
+
+#include <shv/core/string.h>
+
+namespace acl = shv::iotqt::acl;
+
+namespace shv {
+namespace broker {
+
+//================================================================
+// AccessRulesTree
+//================================================================
+AccessRulesTree::Node *AccessRulesTree::nodeForPath(const std::string &path, bool empty_path_is_segment)
+{
+	// plain split on '/' with empty parts kept, this is consistent with ShvPath::startsWithPath()
+	Node *node = &m_root;
+	if(path.empty() && !empty_path_is_segment)
+		return node;
+	size_t start = 0;
+	while(true) {
+		size_t ix = path.find('/', start);
+		std::string segment = path.substr(start, (ix == std::string::npos)? std::string::npos: ix - start);
+		std::unique_ptr<Node> &child = node->children[segment];
+		if(!child)
+			child.reset(new Node());
+		node = child.get();
+		if(ix == std::string::npos)
+			break;
+		start = ix + 1;
+	}
+	return node;
+}
+
+void AccessRulesTree::addRoleRules(int role_weight, const acl::AclRoleAccessRules &rules)
+{
+	static const std::string ASTERISKS = "**";
+	static const std::string SLASH_ASTERISKS = "/**";
+	if(m_weightGroup < 0 || role_weight != m_lastWeight) {
+		m_weightGroup++;
+		m_lastWeight = role_weight;
+	}
+	for(const acl::AclAccessRule &rule : rules) {
+		if(!rule.isValid())
+			continue;
+		const size_t rule_ix = m_rules.size();
+		const std::string &pattern = rule.pathPattern;
+		const uint64_t has_method = rule.method.empty()? 0: 1;
+		if(pattern == ASTERISKS || shv::core::String::endsWith(pattern, SLASH_ASTERISKS)) {
+			m_rules.push_back(CompiledRule{rule, m_weightGroup, (static_cast<uint64_t>(pattern.size()) << 1) | has_method});
+			// trim "/**"
+			std::string prefix = pattern.substr(0, (pattern.size() > ASTERISKS.size())? pattern.size() - SLASH_ASTERISKS.size(): 0);
+			if(!prefix.empty() && prefix.back() == '/') {
+				// 'a//**' matches paths starting with 'a/', it means 'a' descendants
+				prefix.pop_back();
+				nodeForPath(prefix, true)->descendantRules.push_back(rule_ix);
+			}
+			else {
+				nodeForPath(prefix, false)->wildCardRules.push_back(rule_ix);
+			}
+		}
+		else {
+			m_rules.push_back(CompiledRule{rule, m_weightGroup, (static_cast<uint64_t>(1) << 63) | has_method});
+			nodeForPath(pattern, false)->exactRules.push_back(rule_ix);
+		}
+	}
+}
+
+acl::AclAccessRule AccessRulesTree::mostSpecificRule(const std::string &shv_path, const std::string &method) const
+{
+	const CompiledRule *best = nullptr;
+	size_t best_ix = 0;
+	auto check_rules = [this, &method, &best, &best_ix](const std::vector<size_t> &rule_indexes) {
+		for(size_t ix : rule_indexes) {
+			const CompiledRule &cr = m_rules[ix];
+			if(!cr.rule.method.empty() && cr.rule.method != method)
+				continue;
+			// roles with higher weight win, then more specific rule, then rule defined first
+			if(best) {
+				if(cr.weightGroup > best->weightGroup)
+					continue;
+				if(cr.weightGroup == best->weightGroup) {
+					if(cr.specificity < best->specificity)
+						continue;
+					if(cr.specificity == best->specificity && ix > best_ix)
+						continue;
+				}
+			}
+			best = &cr;
+			best_ix = ix;
+		}
+	};
+	const Node *node = &m_root;
+	check_rules(node->wildCardRules);
+	if(!shv_path.empty()) {
+		std::string segment;
+		size_t start = 0;
+		while(true) {
+			check_rules(node->descendantRules);
+			size_t ix = shv_path.find('/', start);
+			segment.assign(shv_path, start, (ix == std::string::npos)? std::string::npos: ix - start);
+			auto it = node->children.find(segment);
+			if(it == node->children.end())
+				return best? best->rule: acl::AclAccessRule();
+			node = it->second.get();
+			check_rules(node->wildCardRules);
+			if(ix == std::string::npos)
+				break;
+			start = ix + 1;
+		}
+	}
+	check_rules(node->exactRules);
+	return best? best->rule: acl::AclAccessRule();
+}
+
+//================================================================
+// AccessRuleCache
+//================================================================
+constexpr size_t AccessRuleCache::DEFAULT_CAPACITY;
+
+size_t AccessRuleCache::KeyHash::operator()(const Key &k) const
+{
+	std::hash<std::string> hash_fn;
+	size_t h = hash_fn(k.rolesKey);
+	h = h * 31 + hash_fn(k.shvPath);
+	h = h * 31 + hash_fn(k.method);
+	return h;
+}
+
+const acl::AclAccessRule *AccessRuleCache::object(const std::string &roles_key, const std::string &shv_path, const std::string &method)
+{
+	auto it = m_index.find(Key{roles_key, shv_path, method});
+	if(it == m_index.end())
+		return nullptr;
+	// move to front
+	m_entries.splice(m_entries.begin(), m_entries, it->second);
+	return &it->second->second;
+}
+
+void AccessRuleCache::insert(const std::string &roles_key, const std::string &shv_path, const std::string &method, const acl::AclAccessRule &rule)
+{
+	Key key{roles_key, shv_path, method};
+	auto it = m_index.find(key);
+	if(it != m_index.end()) {
+		it->second->second = rule;
+		m_entries.splice(m_entries.begin(), m_entries, it->second);
+		return;
+	}
+	if(m_capacity == 0)
+		return;
+	while(m_index.size() >= m_capacity) {
+		m_index.erase(m_entries.back().first);
+		m_entries.pop_back();
+	}
+	m_entries.emplace_front(std::move(key), rule);
+	m_index[m_entries.front().first] = m_entries.begin();
+}
+
+void AccessRuleCache::clear()
+{
+	m_index.clear();
+	m_entries.clear();
+}
+
+}}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <shv/iotqt/acl/aclroleaccessrules.h>
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace shv {
+namespace broker {
+
+/// Access rules of flatten roles compiled into a path segment trie.
+/// Rule lookup walks the request path segments only, result is the same as evaluating
+/// AclAccessRule::isPathMethodMatch() and AclAccessRule::isMoreSpecificThan()
+/// for all rules of the highest weight roles.
+class AccessRulesTree
+{
+public:
+	/// roles must be added in flatten roles order, it is weight DESC
+	void addRoleRules(int role_weight, const shv::iotqt::acl::AclRoleAccessRules &rules);
+
+	/// most specific rule matching shv_path and method, invalid rule if nothing matches
+	shv::iotqt::acl::AclAccessRule mostSpecificRule(const std::string &shv_path, const std::string &method) const;
+	size_t ruleCount() const {return m_rules.size();}
+private:
+	struct CompiledRule
+	{
+		shv::iotqt::acl::AclAccessRule rule;
+		/// index of roles group with the same weight, 0 has the highest weight
+		int weightGroup;
+		/// exact path is more specific than any wild card, longer wild card pattern is more specific than shorter one
+		/// method specified makes rule more specific in both cases
+		uint64_t specificity;
+	};
+	struct Node
+	{
+		std::map<std::string, std::unique_ptr<Node>> children;
+		/// indexes to m_rules
+		/// pattern path is equal to node path
+		std::vector<size_t> exactRules;
+		/// node path and all its descendants, 'a/b/**'
+		std::vector<size_t> wildCardRules;
+		/// node descendants only, pattern with trailing slash like 'a/b//**'
+		std::vector<size_t> descendantRules;
+	};
+	Node* nodeForPath(const std::string &path, bool empty_path_is_segment);
+private:
+	Node m_root;
+	std::vector<CompiledRule> m_rules;
+	int m_weightGroup = -1;
+	int m_lastWeight = 0;
+};
+
+/// LRU cache of resolved access rules
+class AccessRuleCache
+{
+public:
+	AccessRuleCache(size_t capacity = DEFAULT_CAPACITY) : m_capacity(capacity) {}
+
+	static constexpr size_t DEFAULT_CAPACITY = 10000;
+
+	const shv::iotqt::acl::AclAccessRule* object(const std::string &roles_key, const std::string &shv_path, const std::string &method);
+	void insert(const std::string &roles_key, const std::string &shv_path, const std::string &method, const shv::iotqt::acl::AclAccessRule &rule);
+	void clear();
+	size_t size() const {return m_index.size();}
+private:
+	struct Key
+	{
+		std::string rolesKey;
+		std::string shvPath;
+		std::string method;
+
+		bool operator==(const Key &o) const {return rolesKey == o.rolesKey && shvPath == o.shvPath && method == o.method;}
+	};
+	struct KeyHash
+	{
+		size_t operator()(const Key &k) const;
+	};
+	using Entry = std::pair<Key, shv::iotqt::acl::AclAccessRule>;
+	/// most recently used first
+	std::list<Entry> m_entries;
+	std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_index;
+	size_t m_capacity;
+};
+
+}}
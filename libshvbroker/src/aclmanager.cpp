@@ -13,6 +13,7 @@
 #define logAclManagerI() nCInfo("AclManager")
 
 namespace cp = shv::chainpack;
+namespace acl = shv::iotqt::acl;
 
 namespace shv {
 namespace broker {
@@ -23,6 +24,7 @@ static std::string sha1_hex(const std::string &s)
 	hash.addData(s.data(), (int)s.length());
 	return std::string(hash.result().toHex().constData());
 }
+const auto ROLE_KEY_PREFIX = std::string("_Role#Key:");
 }
 //================================================================
 // AclManagerBase
@@ -88,6 +90,7 @@ void AclManager::setUser(const std::string &user_name, const shv::iotqt::acl::Ac
 	aclSetUser(user_name, u);
 	m_cache.aclUsers.clear();
 	m_cache.userFlattenRoles.clear();
+	clearAccessRuleCache();
 }
 
 std::vector<std::string> AclManager::roles()
@@ -117,6 +120,7 @@ void AclManager::setRole(const std::string &role_name, const shv::iotqt::acl::Ac
 	aclSetRole(role_name, v);
 	m_cache.aclRoles.clear();
 	m_cache.userFlattenRoles.clear();
+	clearAccessRuleCache();
 }
 
 std::vector<std::string> AclManager::accessRoles()
@@ -147,6 +151,7 @@ void AclManager::setAccessRoleRules(const std::string &role_name, const shv::iot
 {
 	aclSetAccessRoleRules(role_name, v);
 	m_cache.aclPathsRoles.clear();
+	clearAccessRuleCache();
 }
 
 chainpack::UserLoginResult AclManager::checkPassword(const chainpack::UserLoginContext &login_context)
@@ -300,7 +305,7 @@ std::vector<AclManager::FlattenRole> AclManager::userFlattenRoles(const std::str
 
 std::vector<AclManager::FlattenRole> AclManager::flattenRole(const std::string &role)
 {
-	std::string key = "_Role#Key:" + role;
+	std::string key = ROLE_KEY_PREFIX + role;
 	if(m_cache.userFlattenRoles.find(key) == m_cache.userFlattenRoles.end()) {
 		std::map<std::string, AclManager::FlattenRole> unique_roles;
 		auto gg = flattenRole_helper(role, 1);
@@ -317,6 +322,43 @@ std::vector<AclManager::FlattenRole> AclManager::flattenRole(const std::string &
 	}
 	return m_cache.userFlattenRoles[key];
 }
+acl::AclAccessRule AclManager::userAccessRule(const std::string &user_name, const std::string &shv_path, const std::string &method)
+{
+	return cachedAccessRule(user_name, false, shv_path, method);
+}
+
+acl::AclAccessRule AclManager::roleAccessRule(const std::string &role_name, const std::string &shv_path, const std::string &method)
+{
+	return cachedAccessRule(ROLE_KEY_PREFIX + role_name, true, shv_path, method);
+}
+
+acl::AclAccessRule AclManager::cachedAccessRule(const std::string &roles_key, bool is_role, const std::string &shv_path, const std::string &method)
+{
+	const acl::AclAccessRule *cached_rule = m_cache.accessRules.object(roles_key, shv_path, method);
+	if(cached_rule) {
+		m_accessRuleCacheHitCount++;
+		return *cached_rule;
+	}
+	m_accessRuleCacheMissCount++;
+	auto it = m_cache.accessRulesTrees.find(roles_key);
+	if(it == m_cache.accessRulesTrees.end()) {
+		AccessRulesTree tree;
+		const std::vector<FlattenRole> flatten_roles = is_role? flattenRole(roles_key.substr(ROLE_KEY_PREFIX.size())): userFlattenRoles(roles_key);
+		for(const FlattenRole &flatten_role : flatten_roles)
+			tree.addRoleRules(flatten_role.weight, accessRoleRules(flatten_role.name));
+		logAclManagerD() << "access rules compiled for:" << roles_key << "rule count:" << tree.ruleCount();
+		it = m_cache.accessRulesTrees.emplace(roles_key, std::move(tree)).first;
+	}
+	acl::AclAccessRule rule = it->second.mostSpecificRule(shv_path, method);
+	m_cache.accessRules.insert(roles_key, shv_path, method, rule);
+	return rule;
+}
+
+void AclManager::clearAccessRuleCache()
+{
+	m_cache.accessRulesTrees.clear();
+	m_cache.accessRules.clear();
+}
 /*
 static cp::RpcValue merge_maps(const cp::RpcValue &m_base, const cp::RpcValue &m_over)
 {
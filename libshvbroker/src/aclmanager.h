@@ -1,6 +1,7 @@
 #pragma once
 
 #include "shvbrokerglobal.h"
+#include "accessrulestree.h"
 
 #include <shv/iotqt/acl/aclrole.h>
 #include <shv/iotqt/acl/aclroleaccessrules.h>
@@ -58,6 +59,15 @@ public:
 
 	chainpack::RpcValue userProfile(const std::string &user_name);
 
+	/// most specific access rule of user flatten roles with the highest weight
+	/// rules are compiled per user and resolved rules are cached until ACL is changed or reloaded
+	shv::iotqt::acl::AclAccessRule userAccessRule(const std::string &user_name, const std::string &shv_path, const std::string &method);
+	shv::iotqt::acl::AclAccessRule roleAccessRule(const std::string &role_name, const std::string &shv_path, const std::string &method);
+
+	size_t accessRuleCacheHitCount() const {return m_accessRuleCacheHitCount;}
+	size_t accessRuleCacheMissCount() const {return m_accessRuleCacheMissCount;}
+	size_t accessRuleCacheSize() const {return m_cache.accessRules.size();}
+
 	virtual chainpack::UserLoginResult checkPassword(const chainpack::UserLoginContext &login_context);
 
 	virtual void reload();
@@ -85,6 +95,8 @@ protected:
 		m_cache = Cache();
 	}
 	std::map<std::string, FlattenRole> flattenRole_helper(const std::string &role_name, int nest_level);
+	shv::iotqt::acl::AclAccessRule cachedAccessRule(const std::string &roles_key, bool is_role, const std::string &shv_path, const std::string &method);
+	void clearAccessRuleCache();
 protected:
 	BrokerApp * m_brokerApp;
 	struct Cache
@@ -95,7 +107,12 @@ protected:
 		std::map<std::string, std::pair<shv::iotqt::acl::AclRoleAccessRules, bool>> aclPathsRoles;
 
 		std::map<std::string, std::vector<FlattenRole>> userFlattenRoles;
+
+		std::map<std::string, AccessRulesTree> accessRulesTrees;
+		AccessRuleCache accessRules;
 	} m_cache;
+	size_t m_accessRuleCacheHitCount = 0;
+	size_t m_accessRuleCacheMissCount = 0;
 };
 
 class SHVBROKER_DECL_EXPORT AclManagerConfigFiles : public AclManager
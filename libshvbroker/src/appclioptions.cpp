@@ -28,6 +28,22 @@ AppCliOptions::AppCliOptions()
 	addOption("server.ssl.cert").setType(cp::RpcValue::Type::String).setNames("--server-ssl-cert")
 			.setComment("List of SSL certificate files").setDefaultValue("wss.crt");
 	addOption("server.publicIP").setType(cp::RpcValue::Type::String).setNames("--pip", "--server-public-ip").setComment("Server public IP address");
+	addOption("server.sendQueue.highWatermarkBytes").setType(cp::RpcValue::Type::Int).setNames("--send-queue-high-watermark-bytes")
+			.setComment("Client connection send queue size in bytes, which triggers overflow policy, 0 means unlimited")
+			.setDefaultValue(64 * 1024 * 1024);
+	addOption("server.sendQueue.highWatermarkMessages").setType(cp::RpcValue::Type::Int).setNames("--send-queue-high-watermark-messages")
+			.setComment("Client connection send queue length, which triggers overflow policy, 0 means unlimited")
+			.setDefaultValue(0);
+	addOption("server.sendQueue.lowWatermarkBytes").setType(cp::RpcValue::Type::Int).setNames("--send-queue-low-watermark-bytes")
+			.setComment("Client connection send queue is reduced to this size in bytes on overflow, 0 means half of high watermark")
+			.setDefaultValue(0);
+	addOption("server.sendQueue.lowWatermarkMessages").setType(cp::RpcValue::Type::Int).setNames("--send-queue-low-watermark-messages")
+			.setComment("Client connection send queue is reduced to this length on overflow, 0 means half of high watermark")
+			.setDefaultValue(0);
+	addOption("server.sendQueue.overflowPolicy").setType(cp::RpcValue::Type::String).setNames("--send-queue-overflow-policy")
+			.setComment("Client connection send queue overflow policy, one of: dropOldestSignals, coalesceSignals, disconnect. "
+						"Signals are dropped or coalesced only, requests and responses are always sent.")
+			.setDefaultValue("coalesceSignals");
 	addOption("sqlconfig.enabled").setType(cp::RpcValue::Type::Bool).setNames("--sql-config-enabled")
 			.setComment("SQL config enabled")
 			.setDefaultValue(false);
@@ -30,6 +30,11 @@ public:
 	CLIOPTION_GETTER_SETTER2(std::string, "server.ssl.key", s, setS, erverSslKeyFile)
 	CLIOPTION_GETTER_SETTER2(std::string, "server.ssl.cert", s, setS, erverSslCertFiles)
 	CLIOPTION_GETTER_SETTER2(std::string, "server.publicIP", p, setP, ublicIP)
+	CLIOPTION_GETTER_SETTER2(int, "server.sendQueue.highWatermarkBytes", s, setS, endQueueHighWatermarkBytes)
+	CLIOPTION_GETTER_SETTER2(int, "server.sendQueue.highWatermarkMessages", s, setS, endQueueHighWatermarkMessages)
+	CLIOPTION_GETTER_SETTER2(int, "server.sendQueue.lowWatermarkBytes", s, setS, endQueueLowWatermarkBytes)
+	CLIOPTION_GETTER_SETTER2(int, "server.sendQueue.lowWatermarkMessages", s, setS, endQueueLowWatermarkMessages)
+	CLIOPTION_GETTER_SETTER2(std::string, "server.sendQueue.overflowPolicy", s, setS, endQueueOverflowPolicy)
 
 	//CLIOPTION_GETTER_SETTER2(std::string, "etc.acl.fstab", f, setF, stabFile)
 	//CLIOPTION_GETTER_SETTER2(std::string, "etc.acl.users", u, setU, sersFile)
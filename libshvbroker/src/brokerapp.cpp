@@ -40,6 +40,7 @@
 #include <QTimer>
 #include <QUdpSocket>
 
+#include <algorithm>
 #include <ctime>
 #include <fstream>
 
@@ -451,53 +452,56 @@ void BrokerApp::startWebSocketServers()
 
 rpc::ClientConnectionOnBroker *BrokerApp::clientConnectionById(int connection_id)
 {
-	shvLogFuncFrame() << "conn id:" << connection_id;
-
-	rpc::ClientConnectionOnBroker *conn = nullptr;
-	if (m_sslServer) {
-		conn = sslServer()->connectionById(connection_id);
-		shvDebug() << "SSL connection:" << conn;
-	}
-	if (!conn && m_tcpServer) {
-		conn = tcpServer()->connectionById(connection_id);
-		shvDebug() << "TCP connection:" << conn;
-	}
-#ifdef WITH_SHV_WEBSOCKETS
-	if(!conn && m_webSocketServer) {
-		conn = m_webSocketServer->connectionById(connection_id);
-		shvDebug() << "ws connection:" << conn;
-	}
-	if(!conn && m_webSocketSslServer) {
-		conn = m_webSocketSslServer->connectionById(connection_id);
-		shvDebug() << "wss connection:" << conn;
-	}
-#endif
-	return conn;
+	auto it = m_connectionRegistry.find(connection_id);
+	if(it == m_connectionRegistry.end())
+		return nullptr;
+	return it->second.clientConnection;
 }
 
 std::vector<int> BrokerApp::clientConnectionIds()
 {
 	std::vector<int> ids;
-	if(m_tcpServer) {
-		ids = m_tcpServer->connectionIds();
-	}
-	if(m_sslServer) {
-		std::vector<int> ids2 = m_sslServer->connectionIds();
-		ids.insert( ids.end(), ids2.begin(), ids2.end() );
-	}
-#ifdef WITH_SHV_WEBSOCKETS
-	if(m_webSocketServer) {
-		std::vector<int> ids2 = m_webSocketServer->connectionIds();
-		ids.insert( ids.end(), ids2.begin(), ids2.end() );
-	}
-	if(m_webSocketSslServer) {
-		std::vector<int> ids2 = m_webSocketSslServer->connectionIds();
-		ids.insert( ids.end(), ids2.begin(), ids2.end() );
+	ids.reserve(m_connectionRegistry.size());
+	for(const auto &kv : m_connectionRegistry) {
+		if(kv.second.clientConnection)
+			ids.push_back(kv.first);
 	}
-#endif
+	std::sort(ids.begin(), ids.end());
 	return ids;
 }
 
+void BrokerApp::registerClientConnection(rpc::ClientConnectionOnBroker *conn)
+{
+	int id = conn->connectionId();
+	shvDebug() << "registering client connection id:" << id;
+	RegisteredConnection &rc = m_connectionRegistry[id];
+	rc.handle = conn;
+	rc.clientConnection = conn;
+	// servers forget connection on aboutToBeDeleted(), destroyed() covers connections deleted directly
+	connect(conn, &rpc::ClientConnectionOnBroker::aboutToBeDeleted, this, &BrokerApp::unregisterConnection);
+	connect(conn, &QObject::destroyed, this, [this, id]() {
+		unregisterConnection(id);
+	});
+}
+
+void BrokerApp::registerMasterBrokerConnection(rpc::MasterBrokerConnection *conn)
+{
+	int id = conn->connectionId();
+	RegisteredConnection &rc = m_connectionRegistry[id];
+	rc.handle = conn;
+	rc.masterBrokerConnection = conn;
+	m_masterBrokerConnections << conn;
+	connect(conn, &QObject::destroyed, this, [this, id, conn]() {
+		m_masterBrokerConnections.removeOne(conn);
+		unregisterConnection(id);
+	});
+}
+
+void BrokerApp::unregisterConnection(int connection_id)
+{
+	m_connectionRegistry.erase(connection_id);
+}
+
 void BrokerApp::lazyInit()
 {
 	initDbConfigSqlConnection();
@@ -639,16 +643,6 @@ void BrokerApp::propagateSubscriptionsToMasterBroker()
 chainpack::AccessGrant BrokerApp::accessGrantForRequest(rpc::CommonRpcClientHandle *conn, const std::string &rq_shv_path, const std::string &method, const shv::chainpack::RpcValue &rq_grant)
 {
 	logAclResolveM() << "==== accessGrantForShvPath user:" << conn->loggedUserName() << "requested path:" << rq_shv_path << "method:" << method << "request grant:" << rq_grant.toCpon();
-#ifdef USE_SHV_PATHS_GRANTS_CACHE
-	PathGrantCache *user_path_grants = m_userPathGrantCache.object(user_name);
-	if(user_path_grants) {
-		cp::Rpc::AccessGrant *pg = user_path_grants->object(shv_path);
-		if(pg) {
-			logAclD() << "\t cache hit:" << pg->grant << "weight:" << pg->weight;
-			return *pg;
-		}
-	}
-#endif
 	bool is_request_from_master_broker = conn->isMasterBrokerConnection();
 	auto request_grant = cp::AccessGrant::fromRpcValue(rq_grant);
 	if(is_request_from_master_broker) {
@@ -656,37 +650,41 @@ chainpack::AccessGrant BrokerApp::accessGrantForRequest(rpc::CommonRpcClientHand
 			// access resolved by master broker already, forward use this
 			return request_grant;
 		}
-	}
-	else {
-		if(request_grant.isValid()) {
-			logAclResolveM() << "Client defined grants in RPC request are not implemented yet and will be ignored.";
-		}
-	}
-	std::vector<AclManager::FlattenRole> flatten_user_roles;
-	if(is_request_from_master_broker) {
 		// set masterBroker role to requests from master broker without access grant specified
 		// This is used mainly for service calls as (un)subscribe propagation to slave brokers etc.
 		if(rq_shv_path == cp::Rpc::DIR_BROKER_APP) {
 			// master broker has always rd grant to .broker/app path
 			return cp::AccessGrant(cp::Rpc::ROLE_WRITE);
 		}
-		flatten_user_roles = aclManager()->flattenRole(cp::Rpc::ROLE_MASTER_BROKER);
 	}
 	else {
-		flatten_user_roles = aclManager()->userFlattenRoles(conn->loggedUserName());
+		if(request_grant.isValid()) {
+			logAclResolveM() << "Client defined grants in RPC request are not implemented yet and will be ignored.";
+		}
+	}
+	acl::AclAccessRule most_specific_rule;
+	if(rq_shv_path == CURRENT_CLIENT_SHV_PATH) {
+		// client has WR grant on currentClient node
+		most_specific_rule.grant = cp::AccessGrant{cp::Rpc::ROLE_WRITE};
+	}
+	else if(is_request_from_master_broker) {
+		most_specific_rule = aclManager()->roleAccessRule(cp::Rpc::ROLE_MASTER_BROKER, rq_shv_path, method);
+	}
+	else {
+		// most specific path grant for role with highest weight, rules are precompiled by ACL manager
+		most_specific_rule = aclManager()->userAccessRule(conn->loggedUserName(), rq_shv_path, method);
 	}
-	//logAclResolveM() << "user:" << conn->loggedUserName() << "flatten roles:";
-	//for(const AclManager::FlattenRole &flatten_role : flatten_user_roles) {
-	//	logAclResolveM() << "\t" << flatten_role.name << "\tweight:" << flatten_role.weight << "\tnest level:" << flatten_role.nestLevel;
-	//}
-	if(true) {
-		logAclResolveM() << "no match found, searched rules:" << [this, &flatten_user_roles]() -> string
+	if(!most_specific_rule.isValid()) {
+		logAclResolveM() << "no match found, permission denied! searched rules:" << [this, conn, is_request_from_master_broker]() -> string
 		{
+			std::vector<AclManager::FlattenRole> flatten_user_roles = is_request_from_master_broker
+					? aclManager()->flattenRole(cp::Rpc::ROLE_MASTER_BROKER)
+					: aclManager()->userFlattenRoles(conn->loggedUserName());
 			string tbl = "\n--------------------------------------------------------";
 			tbl += "\nrole\tweight\tpattern\tmethod\tgrant";
 			tbl += "\n--------------------------------------------------------";
 			for(const AclManager::FlattenRole &role : flatten_user_roles) {
-				const acl::AclRoleAccessRules &role_rules = aclManager()->accessRoleRules(role.name);
+				const acl::AclRoleAccessRules role_rules = aclManager()->accessRoleRules(role.name);
 				for(const acl::AclAccessRule &access_rule : role_rules) {
 					tbl += '\n';
 					tbl += role.name + "'";
@@ -698,54 +696,6 @@ chainpack::AccessGrant BrokerApp::accessGrantForRequest(rpc::CommonRpcClientHand
 			}
 			return tbl;
 		}();
-
-	}
-	// find most specific path grant for role with highest weight
-	// user_flattent_grants are sorted by weight DESC
-	acl::AclAccessRule most_specific_rule;
-	if(rq_shv_path == CURRENT_CLIENT_SHV_PATH) {
-		// client has WR grant on currentClient node
-		most_specific_rule.grant = cp::AccessGrant{cp::Rpc::ROLE_WRITE};
-	}
-	else {
-		// roles are sorted in weight DESC
-		int old_weight = std::numeric_limits<int>::max();
-		for(const AclManager::FlattenRole &flatten_role : flatten_user_roles) {
-			if(flatten_role.weight != old_weight) {
-				if(most_specific_rule.isValid()) {
-					// roles with lower weight have lower priority, skip them
-					break;
-				}
-				old_weight = flatten_role.weight;
-			}
-			logAclResolveM() << "----- checking role:" << flatten_role.name << "with weight:" << flatten_role.weight << "nest level:" << flatten_role.nestLevel;
-			const acl::AclRoleAccessRules &role_rules = aclManager()->accessRoleRules(flatten_role.name);
-			if(role_rules.empty()) {
-				logAclResolveM() << "\t no paths defined.";
-			}
-			else for(const acl::AclAccessRule &access_rule : role_rules) {
-				// rules are sorted as most specific first
-				logAclResolveM() << "rule:" << access_rule.toRpcValue().toCpon();
-				if(access_rule.isPathMethodMatch(rq_shv_path, method)) {
-					if(access_rule.isMoreSpecificThan(most_specific_rule)) {
-						logAclResolveM() << "\t+++HIT more specific rule found" << most_specific_rule.toRpcValue().toCpon();
-						most_specific_rule = access_rule;
-					}
-					else if(!most_specific_rule.isMoreSpecificThan(access_rule)) {
-						// the same specific rules, this is problem
-						logAclResolveW() << "the same specific rules found!";
-						logAclResolveW() << "\t" << access_rule.toRpcValue().toCpon();
-						logAclResolveW() << "\t" << most_specific_rule.toRpcValue().toCpon();
-					}
-					else {
-						logAclResolveM() << "\t---HIT but rule is not more specific than:" << most_specific_rule.toRpcValue().toCpon();
-					}
-				}
-			}
-		}
-	}
-	if(!most_specific_rule.isValid()) {
-		logAclResolveM() << "no match found, permission denied!";
 	}
 	logAclResolveM() << "access user:" << conn->loggedUserName()
 				 << "shv_path:" << rq_shv_path
@@ -779,6 +729,9 @@ void BrokerApp::onClientLogin(int connection_id)
 		ClientShvNode *client_app_node = new ClientShvNode("app", conn, client_id_node);
 		// delete whole client tree, when client is destroyed
 		connect(conn, &rpc::ClientConnectionOnBroker::destroyed, client_id_node, &ClientShvNode::deleteLater);
+		connect(conn, &rpc::ClientConnectionOnBroker::destroyed, this, [this, connection_id]() {
+			m_subscriptionIndex.removeConnection(connection_id);
+		});
 
 		conn->setParent(client_app_node);
 		{
@@ -1064,7 +1017,7 @@ void BrokerApp::onRpcDataReceived(int connection_id, shv::chainpack::Rpc::Protoc
 		else {
 			//logSigResolveD() << client_connection->connectionId() << "forwarding signal to client on mount point:" << mp << "as:" << full_shv_path;
 			cp::RpcMessage::setShvPath(meta, full_shv_path);
-			bool sig_sent = sendNotifyToSubscribers(meta, data);
+			bool sig_sent = sendNotifyToSubscribers(meta, std::move(data));
 			if(!sig_sent && client_connection && client_connection->isSlaveBrokerConnection()) {
 				logSubscriptionsD() << "Rejecting unsubscribed signal, shv_path:" << full_shv_path << "method:" << cp::RpcMessage::method(meta).asString();
 				cp::RpcRequest rq;
@@ -1127,26 +1080,33 @@ std::string BrokerApp::brokerClientAppPath(int client_id)
 	return brokerClientDirPath(client_id) + "/app";
 }
 
-bool BrokerApp::sendNotifyToSubscribers(const shv::chainpack::RpcValue::MetaData &meta_data, const std::string &data)
+bool BrokerApp::sendNotifyToSubscribers(const shv::chainpack::RpcValue::MetaData &meta_data, std::string &&data)
 {
-	// send it to all clients for now
 	bool subs_sent = false;
-	for(rpc::CommonRpcClientHandle *conn : allClientConnections()) {
-		if(conn->isConnectedAndLoggedIn()) {
-			const cp::RpcValue shv_path = cp::RpcMessage::shvPath(meta_data);
-			const cp::RpcValue method = cp::RpcMessage::method(meta_data);
-			int subs_ix = conn->isSubscribed(shv_path.toString(), method.asString());
+	const std::string shv_path = cp::RpcMessage::shvPath(meta_data).asString();
+	const std::string method = cp::RpcMessage::method(meta_data).asString();
+	// signal data are shared by all the subscribers, only meta data are packed for each of them
+	std::shared_ptr<const std::string> shared_data;
+	// meta data copy used for subscribers with translated signal path
+	cp::RpcValue::MetaData translated_meta_data;
+	for(int connection_id : m_subscriptionIndex.subscribedConnections(shv_path, method)) {
+		rpc::CommonRpcClientHandle *conn = commonClientConnectionById(connection_id);
+		if(conn && conn->isConnectedAndLoggedIn()) {
+			int subs_ix = conn->isSubscribed(shv_path, method);
 			if(subs_ix >= 0) {
 				//shvDebug() << "\t broadcasting to connection id:" << id;
+				if(!shared_data)
+					shared_data = std::make_shared<const std::string>(std::move(data));
 				const rpc::ClientConnectionOnBroker::Subscription &subs = conn->subscriptionAt((size_t)subs_ix);
-				std::string new_path = conn->toSubscribedPath(subs, shv_path.asString());
-				if(new_path == shv_path.asString()) {
-					conn->sendRawData(meta_data, std::string(data));
+				std::string new_path = conn->toSubscribedPath(subs, shv_path);
+				if(new_path == shv_path) {
+					conn->sendRawData(meta_data, shared_data);
 				}
 				else {
-					shv::chainpack::RpcValue::MetaData md2(meta_data);
-					cp::RpcMessage::setShvPath(md2, new_path);
-					conn->sendRawData(md2, std::string(data));
+					if(translated_meta_data.isEmpty())
+						translated_meta_data = meta_data;
+					cp::RpcMessage::setShvPath(translated_meta_data, new_path);
+					conn->sendRawData(translated_meta_data, shared_data);
 				}
 				subs_sent = true;
 			}
@@ -1162,20 +1122,11 @@ void BrokerApp::sendNotifyToSubscribers(const std::string &shv_path, const std::
 	sig.setShvPath(shv_path);
 	sig.setMethod(method);
 	sig.setParams(params);
-	// send it to all clients for now
-	for(rpc::CommonRpcClientHandle *conn : allClientConnections()) {
-		if(conn->isConnectedAndLoggedIn()) {
-			int subs_ix = conn->isSubscribed(shv_path, method);
-			if(subs_ix >= 0) {
-				//shvDebug() << "\t broadcasting to connection id:" << id;
-				const rpc::ClientConnectionOnBroker::Subscription &subs = conn->subscriptionAt((size_t)subs_ix);
-				std::string new_path = conn->toSubscribedPath(subs, shv_path);
-				if(new_path != shv_path)
-					sig.setShvPath(new_path);
-				conn->sendMessage(sig);
-			}
-		}
-	}
+	// pack signal data once, they will be shared by all the subscribers
+	cp::RpcValue::MetaData meta_data = sig.metaData();
+	cp::RpcMessage::setProtocolType(meta_data, cp::Rpc::ProtocolType::ChainPack);
+	std::string data = sig.value().metaStripped().toChainPack();
+	sendNotifyToSubscribers(meta_data, std::move(data));
 }
 
 void BrokerApp::addSubscription(int client_id, const std::string &shv_path, const std::string &method)
@@ -1185,7 +1136,15 @@ void BrokerApp::addSubscription(int client_id, const std::string &shv_path, cons
 	if(!connection_handle)
 		SHV_EXCEPTION("Cannot create subscription, invalid connection ID.");
 	rpc::CommonRpcClientHandle::Subscription subs = connection_handle->createSubscription(shv_path, method);
+	{
+		int ix = connection_handle->findSubscription(subs);
+		if(ix >= 0) {
+			const rpc::CommonRpcClientHandle::Subscription &old_subs = connection_handle->subscriptionAt((size_t)ix);
+			m_subscriptionIndex.removeSubscription(client_id, old_subs.localPath, old_subs.method);
+		}
+	}
 	connection_handle->addSubscription(subs);
+	m_subscriptionIndex.addSubscription(client_id, subs.localPath, subs.method);
 	//rpc::ClientConnection *cli = dynamic_cast<rpc::ClientConnection*>(connection_handle);
 	shv::core::utils::ServiceProviderPath spp(subs.localPath);
 	//logSubscriptionsD() << "addSubscription path:" << subs.localPath << "method:" << subs.method << "for client:" << cli;
@@ -1219,6 +1178,11 @@ bool BrokerApp::removeSubscription(int client_id, const std::string &shv_path, c
 		SHV_EXCEPTION("Connot remove subscription, client doesn't exist.");
 	//logSubscriptionsD() << "addSubscription connection id:" << client_id << "path:" << path << "method:" << method;
 	rpc::CommonRpcClientHandle::Subscription subs(string(), shv_path, method);
+	int ix = conn->findSubscription(subs);
+	if(ix >= 0) {
+		const rpc::CommonRpcClientHandle::Subscription &removed_subs = conn->subscriptionAt((size_t)ix);
+		m_subscriptionIndex.removeSubscription(client_id, removed_subs.localPath, removed_subs.method);
+	}
 	return conn->removeSubscription(subs);
 }
 
@@ -1227,7 +1191,11 @@ bool BrokerApp::rejectNotSubscribedSignal(int client_id, const std::string &path
 	logSubscriptionsD() << "signal rejected, shv_path:" << path << "method:" << method;
 	rpc::MasterBrokerConnection *conn = masterBrokerConnectionById(client_id);
 	if(conn) {
-		return conn->rejectNotSubscribedSignal(conn->masterExportedToLocalPath(path), method);
+		rpc::CommonRpcClientHandle::Subscription removed_subs;
+		if(conn->rejectNotSubscribedSignal(conn->masterExportedToLocalPath(path), method, &removed_subs)) {
+			m_subscriptionIndex.removeSubscription(client_id, removed_subs.localPath, removed_subs.method);
+			return true;
+		}
 	}
 	return false;
 }
@@ -1255,6 +1223,7 @@ void BrokerApp::createMasterBrokerConnections()
 		shvInfo() << "creating master broker connection:" << kv.first;
 		rpc::MasterBrokerConnection *bc = new rpc::MasterBrokerConnection(this);
 		bc->setObjectName(QString::fromStdString(kv.first));
+		registerMasterBrokerConnection(bc);
 		int id = bc->connectionId();
 		connect(bc, &rpc::MasterBrokerConnection::brokerConnectedChanged, this, [id, this](bool is_connected) {
 			this->onConnectedToMasterBrokerChanged(id, is_connected);
@@ -1266,35 +1235,33 @@ void BrokerApp::createMasterBrokerConnections()
 
 QList<rpc::MasterBrokerConnection *> BrokerApp::masterBrokerConnections() const
 {
-	return findChildren<rpc::MasterBrokerConnection*>(QString(), Qt::FindDirectChildrenOnly);
+	return m_masterBrokerConnections;
 }
 
 rpc::MasterBrokerConnection *BrokerApp::masterBrokerConnectionById(int connection_id)
 {
-	for(rpc::MasterBrokerConnection *bc : masterBrokerConnections()) {
-		if(bc->connectionId() == connection_id)
-			return bc;
-	}
-	return nullptr;
+	auto it = m_connectionRegistry.find(connection_id);
+	if(it == m_connectionRegistry.end())
+		return nullptr;
+	return it->second.masterBrokerConnection;
 }
 
 std::vector<rpc::CommonRpcClientHandle *> BrokerApp::allClientConnections()
 {
 	std::vector<rpc::CommonRpcClientHandle *> ret;
+	ret.reserve(m_connectionRegistry.size());
 	for (int i : clientConnectionIds())
 		ret.push_back(clientConnectionById(i));
-	QList<rpc::MasterBrokerConnection *> mbc = masterBrokerConnections();
-	std::copy(mbc.begin(), mbc.end(), std::back_inserter(ret));
+	std::copy(m_masterBrokerConnections.begin(), m_masterBrokerConnections.end(), std::back_inserter(ret));
 	return ret;
 }
 
 rpc::CommonRpcClientHandle *BrokerApp::commonClientConnectionById(int connection_id)
 {
-	rpc::CommonRpcClientHandle *ret = clientConnectionById(connection_id);
-	if(ret)
-		return ret;
-	ret = masterBrokerConnectionById(connection_id);
-	return ret;
+	auto it = m_connectionRegistry.find(connection_id);
+	if(it == m_connectionRegistry.end())
+		return nullptr;
+	return it->second.handle;
 }
 
 QSqlDatabase BrokerApp::sqlConfigConnection()
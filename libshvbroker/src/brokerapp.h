@@ -1,19 +1,9 @@
 #pragma once
 
-#ifdef USE_SHV_PATHS_GRANTS_CACHE
-#include <string>
-
-inline unsigned qHash(const std::string &s) noexcept //Q_DECL_NOEXCEPT_EXPR(noexcept(qHash(s)))
-{
-	std::hash<std::string> hash_fn;
-	return hash_fn(s);
-}
-#include <QCache>
-#endif
-
 #include "shvbrokerglobal.h"
 #include "appclioptions.h"
 #include "tunnelsecretlist.h"
+#include "subscriptionindex.h"
 #include "aclmanager.h"
 
 #include <shv/iotqt/node/shvnode.h>
@@ -24,6 +14,7 @@ inline unsigned qHash(const std::string &s) noexcept //Q_DECL_NOEXCEPT_EXPR(noex
 #include <QDateTime>
 
 #include <set>
+#include <unordered_map>
 
 class QSocketNotifier;
 class QSqlDatabase;
@@ -63,7 +54,7 @@ public:
 
 	void onRpcDataReceived(int connection_id, shv::chainpack::Rpc::ProtocolType protocol_type, shv::chainpack::RpcValue::MetaData &&meta, std::string &&data);
 
-	rpc::MasterBrokerConnection* mainMasterBrokerConnection() { return masterBrokerConnections().value(0); }
+	rpc::MasterBrokerConnection* mainMasterBrokerConnection() { return m_masterBrokerConnections.value(0); }
 
 	void addSubscription(int client_id, const std::string &path, const std::string &method);
 	bool removeSubscription(int client_id, const std::string &shv_path, const std::string &method);
@@ -79,6 +70,10 @@ public:
 
 	rpc::CommonRpcClientHandle* commonClientConnectionById(int connection_id);
 
+	/// client and slave broker connections register itself on creation
+	/// and they are unregistered automatically before deletion
+	void registerClientConnection(rpc::ClientConnectionOnBroker *conn);
+
 	QSqlDatabase sqlConfigConnection();
 
 	AclManager *aclManager();
@@ -120,6 +115,9 @@ private:
 
 	std::vector<rpc::CommonRpcClientHandle *> allClientConnections();
 
+	void registerMasterBrokerConnection(rpc::MasterBrokerConnection *conn);
+	void unregisterConnection(int connection_id);
+
 	std::string resolveMountPoint(const shv::chainpack::RpcValue::Map &device_opts);
 
 	void onRootNodeSendRpcMesage(const shv::chainpack::RpcMessage &msg);
@@ -127,7 +125,7 @@ private:
 	void onClientConnected(int client_id);
 
 	void sendNotifyToSubscribers(const std::string &shv_path, const std::string &method, const shv::chainpack::RpcValue &params);
-	bool sendNotifyToSubscribers(const shv::chainpack::RpcValue::MetaData &meta_data, const std::string &data);
+	bool sendNotifyToSubscribers(const shv::chainpack::RpcValue::MetaData &meta_data, std::string &&data);
 
 	static std::string brokerClientDirPath(int client_id);
 	static std::string brokerClientAppPath(int client_id);
@@ -146,11 +144,17 @@ protected:
 #endif
 	shv::iotqt::node::ShvNodeTree *m_nodesTree = nullptr;
 	TunnelSecretList m_tunnelSecretList;
-#ifdef USE_SHV_PATHS_GRANTS_CACHE
-	using PathGrantCache = QCache<std::string, shv::chainpack::Rpc::AccessGrant>;
-	using UserPathGrantCache = QCache<std::string, PathGrantCache>;
-	UserPathGrantCache m_userPathGrantCache;
-#endif
+	SubscriptionIndex m_subscriptionIndex;
+	struct RegisteredConnection
+	{
+		rpc::CommonRpcClientHandle *handle = nullptr;
+		rpc::ClientConnectionOnBroker *clientConnection = nullptr;
+		rpc::MasterBrokerConnection *masterBrokerConnection = nullptr;
+	};
+	/// connection id -> connection, all client, slave broker and master broker connections
+	std::unordered_map<int, RegisteredConnection> m_connectionRegistry;
+	/// master broker connections in creation order, the first one is the main master broker connection
+	QList<rpc::MasterBrokerConnection*> m_masterBrokerConnections;
 	AclManager *m_aclManager = nullptr;
 #ifdef Q_OS_UNIX
 private:
@@ -67,6 +67,44 @@ public:
 private:
 	std::vector<cp::MetaMethod> m_metaMethods;
 };
+
+static const char M_HIT_COUNT[] = "hitCount";
+static const char M_MISS_COUNT[] = "missCount";
+static const char M_SIZE[] = "size";
+class BrokerAclCacheNode : public shv::iotqt::node::MethodsTableNode
+{
+	using Super = shv::iotqt::node::MethodsTableNode;
+public:
+	BrokerAclCacheNode(shv::iotqt::node::ShvNode *parent = nullptr)
+		: Super("aclCache", &m_metaMethods, parent)
+		, m_metaMethods {
+			{cp::Rpc::METH_DIR, cp::MetaMethod::Signature::RetParam, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_BROWSE},
+			{cp::Rpc::METH_LS, cp::MetaMethod::Signature::RetParam, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_READ},
+			{M_HIT_COUNT, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::IsGetter, cp::Rpc::ROLE_READ},
+			{M_MISS_COUNT, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::IsGetter, cp::Rpc::ROLE_READ},
+			{M_SIZE, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::IsGetter, cp::Rpc::ROLE_READ},
+		}
+	{ }
+
+	shv::chainpack::RpcValue callMethod(const StringViewList &shv_path, const std::string &method, const shv::chainpack::RpcValue &params) override
+	{
+		if(shv_path.empty()) {
+			AclManager *mng = BrokerApp::instance()->aclManager();
+			if(method == M_HIT_COUNT) {
+				return static_cast<cp::RpcValue::UInt>(mng->accessRuleCacheHitCount());
+			}
+			if(method == M_MISS_COUNT) {
+				return static_cast<cp::RpcValue::UInt>(mng->accessRuleCacheMissCount());
+			}
+			if(method == M_SIZE) {
+				return static_cast<cp::RpcValue::UInt>(mng->accessRuleCacheSize());
+			}
+		}
+		return Super::callMethod(shv_path, method, params);
+	}
+private:
+	std::vector<cp::MetaMethod> m_metaMethods;
+};
 }
 
 static const char M_RELOAD_CONFIG[] = "reloadConfig";
@@ -96,6 +134,7 @@ BrokerAppNode::BrokerAppNode(shv::iotqt::node::ShvNode *parent)
 	}
 {
 	new BrokerLogNode(this);
+	new BrokerAclCacheNode(this);
 }
 
 chainpack::RpcValue BrokerAppNode::callMethodRq(const chainpack::RpcRequest &rq)
@@ -17,6 +17,7 @@ static const char M_USER_ROLES[] = "userRoles";
 static const char M_USER_PROFILE[] = "userProfile";
 static const char M_IDLE_TIME[] = "idleTime";
 static const char M_IDLE_TIME_MAX[] = "idleTimeMax";
+static const char M_WRITE_STATS[] = "writeStats";
 
 //=================================================================================
 // MasterBrokerConnectionNode
@@ -31,6 +32,7 @@ static std::vector<cp::MetaMethod> meta_methods {
 	{M_DROP_CLIENT, cp::MetaMethod::Signature::VoidVoid, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_SERVICE},
 	{M_IDLE_TIME, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_SERVICE, "Connection inactivity time in msec."},
 	{M_IDLE_TIME_MAX, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_SERVICE, "Maximum connection inactivity time in msec, before it is closed by server."},
+	{M_WRITE_STATS, cp::MetaMethod::Signature::RetVoid, cp::MetaMethod::Flag::None, cp::Rpc::ROLE_SERVICE, "Send queue length, limits, overflow and socket write statistics."},
 };
 
 ClientConnectionNode::ClientConnectionNode(int client_id, shv::iotqt::node::ShvNode *parent)
@@ -89,6 +91,29 @@ shv::chainpack::RpcValue ClientConnectionNode::callMethod(const shv::iotqt::node
 				return cli->idleTimeMax();
 			SHV_EXCEPTION("Invalid client id: " + std::to_string(m_clientId));
 		}
+		if(method == M_WRITE_STATS) {
+			rpc::ClientConnectionOnBroker *cli = BrokerApp::instance()->clientById(m_clientId);
+			if(cli) {
+				const cp::RpcDriver::WriteStats &stats = cli->writeStats();
+				const cp::RpcDriver::SendQueueLimits &limits = cli->sendQueueLimits();
+				cp::RpcValue::Map ret;
+				ret["sendQueueLength"] = static_cast<uint64_t>(cli->sendQueueLength());
+				ret["sendQueueBytes"] = static_cast<uint64_t>(cli->sendQueueBytes());
+				ret["highWatermarkBytes"] = static_cast<uint64_t>(limits.highWatermarkBytes);
+				ret["highWatermarkMessages"] = static_cast<uint64_t>(limits.highWatermarkMessages);
+				ret["lowWatermarkBytes"] = static_cast<uint64_t>(limits.lowWatermarkBytes);
+				ret["lowWatermarkMessages"] = static_cast<uint64_t>(limits.lowWatermarkMessages);
+				ret["overflowPolicy"] = cp::RpcDriver::sendQueueOverflowPolicyToString(limits.overflowPolicy);
+				ret["droppedMessages"] = stats.droppedMessages;
+				ret["coalescedMessages"] = stats.coalescedMessages;
+				ret["writeCount"] = stats.writeCount;
+				ret["messagesWritten"] = stats.messagesWritten;
+				ret["bytesWritten"] = stats.bytesWritten;
+				ret["bytesPerWrite"] = stats.writeCount? stats.bytesWritten / stats.writeCount: 0;
+				return ret;
+			}
+			SHV_EXCEPTION("Invalid client id: " + std::to_string(m_clientId));
+		}
 		if(method == M_DROP_CLIENT) {
 			rpc::ClientConnectionOnBroker *cli = BrokerApp::instance()->clientById(m_clientId);
 			if(cli) {
@@ -16,6 +16,8 @@
 #include <QTcpSocket>
 #include <QTimer>
 
+#include <algorithm>
+
 #define logSubscriptionsD() nCDebug("Subscr").color(NecroLog::Color::Yellow)
 #define logSubsResolveD() nCDebug("SubsRes").color(NecroLog::Color::LightGreen)
 
@@ -29,11 +31,31 @@ namespace shv {
 namespace broker {
 namespace rpc {
 
+namespace {
+cp::RpcDriver::SendQueueLimits send_queue_limits(AppCliOptions *opts)
+{
+	cp::RpcDriver::SendQueueLimits limits;
+	limits.highWatermarkBytes = static_cast<size_t>(std::max(opts->sendQueueHighWatermarkBytes(), 0));
+	limits.highWatermarkMessages = static_cast<size_t>(std::max(opts->sendQueueHighWatermarkMessages(), 0));
+	limits.lowWatermarkBytes = static_cast<size_t>(std::max(opts->sendQueueLowWatermarkBytes(), 0));
+	limits.lowWatermarkMessages = static_cast<size_t>(std::max(opts->sendQueueLowWatermarkMessages(), 0));
+	bool ok;
+	limits.overflowPolicy = cp::RpcDriver::sendQueueOverflowPolicyFromString(opts->sendQueueOverflowPolicy(), &ok);
+	if(!ok)
+		shvWarning() << "Invalid send queue overflow policy:" << opts->sendQueueOverflowPolicy()
+					 << "using:" << cp::RpcDriver::sendQueueOverflowPolicyToString(limits.overflowPolicy);
+	return limits;
+}
+}
+
 ClientConnectionOnBroker::ClientConnectionOnBroker(shv::iotqt::rpc::Socket *socket, QObject *parent)
 	: Super(socket, parent)
 {
 	shvDebug() << __FUNCTION__;
 	connect(this, &ClientConnectionOnBroker::socketConnectedChanged, this, &ClientConnectionOnBroker::onSocketConnectedChanged);
+	BrokerApp *app = BrokerApp::instance();
+	setSendQueueLimits(send_queue_limits(app->cliOptions()));
+	app->registerClientConnection(this);
 }
 
 ClientConnectionOnBroker::~ClientConnectionOnBroker()
@@ -43,6 +65,12 @@ ClientConnectionOnBroker::~ClientConnectionOnBroker()
 	//shvWarning() << __FUNCTION__;
 }
 
+void ClientConnectionOnBroker::onSendQueueOverflow()
+{
+	shvWarning() << "Client id:" << connectionId() << "user:" << userName() << "send queue overflow, closing connection.";
+	abortSocket();
+}
+
 void ClientConnectionOnBroker::onSocketConnectedChanged(bool is_connected)
 {
 	if(!is_connected) {
@@ -182,6 +210,15 @@ void ClientConnectionOnBroker::sendRawData(const shv::chainpack::RpcValue::MetaD
 	Super::sendRawData(meta_data, std::move(data));
 }
 
+void ClientConnectionOnBroker::sendRawData(const shv::chainpack::RpcValue::MetaData &meta_data, const std::shared_ptr<const std::string> &data)
+{
+	logRpcMsg() << SND_LOG_ARROW
+				<< "client id:" << connectionId()
+				<< "protocol_type:" << (int)protocolType() << shv::chainpack::Rpc::protocolTypeToString(protocolType())
+				<< RpcDriver::dataToPrettyCpon(shv::chainpack::RpcMessage::protocolType(meta_data), meta_data, *data);
+	Super::sendRawData(meta_data, data);
+}
+
 ClientConnectionOnBroker::Subscription ClientConnectionOnBroker::createSubscription(const std::string &shv_path, const std::string &method)
 {
 	logSubscriptionsD() << "Create client subscription for path:" << shv_path << "method:" << method;
@@ -47,6 +47,7 @@ public:
 
 	void sendMessage(const shv::chainpack::RpcMessage &rpc_msg) override;
 	void sendRawData(const shv::chainpack::RpcValue::MetaData &meta_data, std::string &&data) override;
+	void sendRawData(const shv::chainpack::RpcValue::MetaData &meta_data, const std::shared_ptr<const std::string> &data) override;
 
 	Subscription createSubscription(const std::string &shv_path, const std::string &method) override;
 	std::string toSubscribedPath(const Subscription &subs, const std::string &signal_path) const override;
@@ -60,6 +61,7 @@ private:
 	QVector<int> callerIdsToList(const shv::chainpack::RpcValue &caller_ids);
 
 	void processLoginPhase() override;
+	void onSendQueueOverflow() override;
 private:
 	QTimer *m_idleWatchDogTimer = nullptr;
 	std::string m_mountPoint;
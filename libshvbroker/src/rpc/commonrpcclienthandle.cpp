@@ -120,20 +120,18 @@ unsigned CommonRpcClientHandle::addSubscription(const CommonRpcClientHandle::Sub
 	logSubscriptionsD() << "adding subscription for connection id:" << connectionId()
 						<< "local path:" << subs.localPath
 						<< "subscribed path:" << subs.subscribedPath << "method:" << subs.method;
-	//auto it = std::find(m_subscriptions.begin(), m_subscriptions.end(), subs);
-	auto it = std::find_if(m_subscriptions.begin(), m_subscriptions.end(),
-					 [&subs](const Subscription &s) { return subs.cmpSubscribed(s); });
-
-	if(it == m_subscriptions.end()) {
+	int ix = findSubscription(subs);
+	if(ix < 0) {
 		logSubscriptionsD() << "new subscription";
 		m_subscriptions.push_back(subs);
 		//std::sort(m_subscriptions.begin(), m_subscriptions.end());
 		return m_subscriptions.size() - 1;
 	}
 	else {
-		logSubscriptionsD() << "subscription exists:" << "subscribed path:" << it->subscribedPath << "method:" << it->method;
-		*it = subs;
-		return (it - m_subscriptions.begin());
+		Subscription &s = m_subscriptions[(size_t)ix];
+		logSubscriptionsD() << "subscription exists:" << "subscribed path:" << s.subscribedPath << "method:" << s.method;
+		s = subs;
+		return (unsigned)ix;
 	}
 }
 
@@ -142,20 +140,28 @@ bool CommonRpcClientHandle::removeSubscription(const CommonRpcClientHandle::Subs
 	logSubscriptionsD() << "request to remove subscription for connection id:" << connectionId()
 						<< "local path:" << subs.localPath
 						<< "subscribed path:" << subs.subscribedPath << "method:" << subs.method;
-	//auto it = std::find(m_subscriptions.begin(), m_subscriptions.end(), subs);
-	auto it = std::find_if(m_subscriptions.begin(), m_subscriptions.end(),
-					 [&subs](const Subscription &s) { return subs.cmpSubscribed(s); });
-	if(it == m_subscriptions.end()) {
+	int ix = findSubscription(subs);
+	if(ix < 0) {
 		logSubscriptionsD() << "subscription not found";
 		return false;
 	}
 	else {
+		auto it = m_subscriptions.begin() + ix;
 		logSubscriptionsD() << "removed subscription local path:" << it->localPath
 							<< "subscribed path:" << it->subscribedPath << "method:" << it->method;
 		m_subscriptions.erase(it);
 		return true;
 	}
 }
+
+int CommonRpcClientHandle::findSubscription(const CommonRpcClientHandle::Subscription &subs) const
+{
+	auto it = std::find_if(m_subscriptions.begin(), m_subscriptions.end(),
+					 [&subs](const Subscription &s) { return subs.cmpSubscribed(s); });
+	if(it == m_subscriptions.end())
+		return -1;
+	return (int)(it - m_subscriptions.begin());
+}
 /*
 bool CommonRpcClientHandle::removeSubscription(const std::string &rel_path, const std::string &method)
 {
@@ -194,7 +200,7 @@ int CommonRpcClientHandle::isSubscribed(const std::string &shv_path, const std::
 	return -1;
 }
 
-bool CommonRpcClientHandle::rejectNotSubscribedSignal(const std::string &path, const std::string &method)
+bool CommonRpcClientHandle::rejectNotSubscribedSignal(const std::string &path, const std::string &method, Subscription *removed_subs)
 {
 	logSubscriptionsD() << "unsubscribing rejected signal, shv_path:" << path << "method:" << method;
 	int most_explicit_subs_ix = -1;
@@ -215,6 +221,8 @@ bool CommonRpcClientHandle::rejectNotSubscribedSignal(const std::string &path, c
 	}
 	if(most_explicit_subs_ix >= 0) {
 		logSubscriptionsD() << "\t found subscription:" << m_subscriptions.at(most_explicit_subs_ix).toString();
+		if(removed_subs)
+			*removed_subs = m_subscriptions.at(most_explicit_subs_ix);
 		m_subscriptions.erase(m_subscriptions.begin() + most_explicit_subs_ix);
 		return true;
 	}
@@ -2,6 +2,8 @@
 
 #include <shv/chainpack/rpcmessage.h>
 
+#include <memory>
+
 namespace shv { namespace core { class StringView; }}
 
 namespace shv {
@@ -36,17 +38,20 @@ public:
 	unsigned addSubscription(const Subscription &subs);
 	//virtual bool removeSubscription(const std::string &shv_path, const std::string &method) = 0;
 	bool removeSubscription(const Subscription &subs);
+	/// @return index of subscription with the same subscribed path and method or -1
+	int findSubscription(const Subscription &subs) const;
 	int isSubscribed(const std::string &shv_path, const std::string &method) const;
 	virtual std::string toSubscribedPath(const Subscription &subs, const std::string &abs_path) const = 0;
 	size_t subscriptionCount() const {return m_subscriptions.size();}
 	const Subscription& subscriptionAt(size_t ix) const {return m_subscriptions.at(ix);}
-	bool rejectNotSubscribedSignal(const std::string &path, const std::string &method);
+	bool rejectNotSubscribedSignal(const std::string &path, const std::string &method, Subscription *removed_subs = nullptr);
 
 	virtual std::string loggedUserName() = 0;
 	virtual bool isSlaveBrokerConnection() const = 0;
 	virtual bool isMasterBrokerConnection() const = 0;
 
 	virtual void sendRawData(const shv::chainpack::RpcValue::MetaData &meta_data, std::string &&data) = 0;
+	virtual void sendRawData(const shv::chainpack::RpcValue::MetaData &meta_data, const std::shared_ptr<const std::string> &data) = 0;
 	virtual void sendMessage(const shv::chainpack::RpcMessage &rpc_msg) = 0;
 protected:
 	std::vector<Subscription> m_subscriptions;
@@ -79,6 +79,15 @@ void MasterBrokerConnection::sendRawData(const shv::chainpack::RpcValue::MetaDat
 	Super::sendRawData(meta_data, std::move(data));
 }
 
+void MasterBrokerConnection::sendRawData(const shv::chainpack::RpcValue::MetaData &meta_data, const std::shared_ptr<const std::string> &data)
+{
+	logRpcMsg() << SND_LOG_ARROW
+				<< "client id:" << connectionId()
+				<< "protocol_type:" << (int)protocolType() << shv::chainpack::Rpc::protocolTypeToString(protocolType())
+				<< RpcDriver::dataToPrettyCpon(shv::chainpack::RpcMessage::protocolType(meta_data), meta_data, *data, 0);
+	Super::sendRawData(meta_data, data);
+}
+
 void MasterBrokerConnection::sendMessage(const shv::chainpack::RpcMessage &rpc_msg)
 {
 	Super::sendMessage(rpc_msg);
@@ -27,6 +27,7 @@ public:
 	bool isMasterBrokerConnection() const override {return true;}
 
 	void sendRawData(const shv::chainpack::RpcValue::MetaData &meta_data, std::string &&data) override;
+	void sendRawData(const shv::chainpack::RpcValue::MetaData &meta_data, const std::shared_ptr<const std::string> &data) override;
 	void sendMessage(const shv::chainpack::RpcMessage &rpc_msg) override;
 
 	Subscription createSubscription(const std::string &shv_path, const std::string &method) override;
@@ -4,6 +4,8 @@
 
 #include <QWebSocket>
 
+#include <algorithm>
+
 namespace shv {
 namespace broker {
 namespace rpc {
@@ -18,6 +20,9 @@ WebSocket::WebSocket(QWebSocket *socket, QObject *parent)
 	connect(m_socket, &QWebSocket::disconnected, this, &Socket::disconnected);
 	connect(m_socket, &QWebSocket::textMessageReceived, this, &WebSocket::onTextMessageReceived);
 	connect(m_socket, &QWebSocket::binaryMessageReceived, this, &WebSocket::onBinaryMessageReceived);
+	connect(m_socket, &QWebSocket::bytesWritten, this, [this](qint64 bytes) {
+		m_bytesToWrite = std::max(m_bytesToWrite - bytes, static_cast<qint64>(0));
+	});
 	connect(m_socket, &QWebSocket::bytesWritten, this, &Socket::bytesWritten);
 	connect(m_socket, &QWebSocket::stateChanged, this, &Socket::stateChanged);
 	connect(m_socket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error), this, &Socket::error);
@@ -71,11 +76,19 @@ QByteArray WebSocket::readAll()
 
 qint64 WebSocket::write(const char *data, qint64 data_size)
 {
-	QByteArray ba(data, static_cast<int>(data_size));
-	m_writeBuffer.append(ba);
+	// peer does not read fast enough, leave data in RPC driver send queue, writing continues on bytesWritten()
+	// unsent part of current message is not counted, message bigger than the limit would never be sent otherwise
+	if(m_maxBytesToWrite > 0 && m_bytesToWrite >= m_maxBytesToWrite)
+		return 0;
+	m_writeBuffer.append(data, static_cast<int>(data_size));
 	return data_size;
 }
 
+qint64 WebSocket::bytesToWrite() const
+{
+	return m_bytesToWrite + m_writeBuffer.size();
+}
+
 void WebSocket::writeMessageBegin()
 {
 	shvDebug() << __FUNCTION__;
@@ -88,7 +101,14 @@ void WebSocket::writeMessageEnd()
 	qint64 n = m_socket->sendBinaryMessage(m_writeBuffer);
 	if(n < m_writeBuffer.size())
 		shvError() << "Send message error, only" << n << "bytes written.";
-	m_socket->flush();
+	if(n > 0)
+		m_bytesToWrite += n;
+	m_writeBuffer.clear();
+}
+
+bool WebSocket::flush()
+{
+	return m_socket->flush();
 }
 
 void WebSocket::ignoreSslErrors()
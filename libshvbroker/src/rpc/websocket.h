@@ -25,8 +25,10 @@ public:
 	quint16 peerPort() const override;
 	QByteArray readAll() override;
 	qint64 write(const char *data, qint64 data_size) override;
+	qint64 bytesToWrite() const override;
 	void writeMessageBegin() override;
 	void writeMessageEnd() override;
+	bool flush() override;
 	void ignoreSslErrors() override;
 private:
 	void onTextMessageReceived(const QString &message);
@@ -35,6 +37,9 @@ private:
 	QWebSocket *m_socket = nullptr;
 	QByteArray m_readBuffer;
 	QByteArray m_writeBuffer;
+	/// QWebSocket does not report its pending data, it is counted from sent messages and bytesWritten(),
+	/// frame headers are not included in sent bytes, so the count is slightly lower than real one
+	qint64 m_bytesToWrite = 0;
 };
 
 }}}
@@ -11,7 +11,9 @@ HEADERS += \
     $$PWD/subscriptionsnode.h \
     $$PWD/clientconnectionnode.h \
     $$PWD/clientshvnode.h \
-    $$PWD/tunnelsecretlist.h
+    $$PWD/tunnelsecretlist.h \
+    $$PWD/subscriptionindex.h \
+    $$PWD/accessrulestree.h
 
 SOURCES += \
     $$PWD/aclmanagersqlite.cpp \
@@ -24,7 +26,9 @@ SOURCES += \
     $$PWD/subscriptionsnode.cpp \
     $$PWD/clientconnectionnode.cpp \
     $$PWD/clientshvnode.cpp \
-    $$PWD/tunnelsecretlist.cpp
+    $$PWD/tunnelsecretlist.cpp \
+    $$PWD/subscriptionindex.cpp \
+    $$PWD/accessrulestree.cpp
 
 include ($$PWD/rpc/rpc.pri)
 
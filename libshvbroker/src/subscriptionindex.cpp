@@ -0,0 +1,162 @@
+#include "subscriptionindex.h"
+
+#include <algorithm>
+
+namespace shv {
+namespace broker {
+
+SubscriptionIndex::SubscriptionIndex()
+{
+}
+
+SubscriptionIndex::~SubscriptionIndex()
+{
+}
+
+std::vector<std::string> SubscriptionIndex::splitPath(const std::string &local_path)
+{
+	// plain split on '/' with empty parts kept, this is consistent with ShvPath::startsWithPath(),
+	// which is used to match subscription local path against signal path
+	std::vector<std::string> ret;
+	if(local_path.empty())
+		return ret;
+	size_t start = 0;
+	while(true) {
+		size_t ix = local_path.find('/', start);
+		if(ix == std::string::npos) {
+			ret.push_back(local_path.substr(start));
+			break;
+		}
+		ret.push_back(local_path.substr(start, ix - start));
+		start = ix + 1;
+	}
+	return ret;
+}
+
+void SubscriptionIndex::addSubscription(int connection_id, const std::string &local_path, const std::string &method)
+{
+	Node *node = &m_root;
+	for(const std::string &segment : splitPath(local_path)) {
+		std::unique_ptr<Node> &child = node->children[segment];
+		if(!child)
+			child.reset(new Node());
+		node = child.get();
+	}
+	node->subscribers[method][connection_id]++;
+	m_subscriptionCount++;
+}
+
+void SubscriptionIndex::removeSubscription(int connection_id, const std::string &local_path, const std::string &method)
+{
+	std::vector<std::string> segments = splitPath(local_path);
+	std::vector<Node*> node_path{&m_root};
+	for(const std::string &segment : segments) {
+		auto it = node_path.back()->children.find(segment);
+		if(it == node_path.back()->children.end())
+			return;
+		node_path.push_back(it->second.get());
+	}
+	Node *node = node_path.back();
+	auto it1 = node->subscribers.find(method);
+	if(it1 == node->subscribers.end())
+		return;
+	auto it2 = it1->second.find(connection_id);
+	if(it2 == it1->second.end())
+		return;
+	m_subscriptionCount--;
+	if(--it2->second > 0)
+		return;
+	it1->second.erase(it2);
+	if(it1->second.empty())
+		node->subscribers.erase(it1);
+	// prune empty nodes
+	for(size_t i = segments.size(); i > 0; i--) {
+		if(!node_path[i]->isEmpty())
+			break;
+		node_path[i - 1]->children.erase(segments[i - 1]);
+	}
+}
+
+size_t SubscriptionIndex::removeConnection(Node *node, int connection_id)
+{
+	size_t removed_cnt = 0;
+	for(auto it = node->subscribers.begin(); it != node->subscribers.end(); ) {
+		auto it2 = it->second.find(connection_id);
+		if(it2 != it->second.end()) {
+			removed_cnt += it2->second;
+			it->second.erase(it2);
+		}
+		if(it->second.empty())
+			it = node->subscribers.erase(it);
+		else
+			++it;
+	}
+	for(auto it = node->children.begin(); it != node->children.end(); ) {
+		removed_cnt += removeConnection(it->second.get(), connection_id);
+		if(it->second->isEmpty())
+			it = node->children.erase(it);
+		else
+			++it;
+	}
+	return removed_cnt;
+}
+
+void SubscriptionIndex::removeConnection(int connection_id)
+{
+	m_subscriptionCount -= removeConnection(&m_root, connection_id);
+}
+
+void SubscriptionIndex::clear()
+{
+	m_root.children.clear();
+	m_root.subscribers.clear();
+	m_subscriptionCount = 0;
+}
+
+std::vector<int> SubscriptionIndex::subscribedConnections(const std::string &shv_path, const std::string &method) const
+{
+	std::vector<int> ret;
+	auto add_subscribers = [&ret, &method](const Node *node) {
+		if(node->subscribers.empty())
+			return;
+		auto it = node->subscribers.find(std::string());
+		if(it != node->subscribers.end()) {
+			for(const auto &kv : it->second)
+				ret.push_back(kv.first);
+		}
+		if(!method.empty()) {
+			it = node->subscribers.find(method);
+			if(it != node->subscribers.end()) {
+				for(const auto &kv : it->second)
+					ret.push_back(kv.first);
+			}
+		}
+	};
+	const Node *node = &m_root;
+	add_subscribers(node);
+	if(!shv_path.empty()) {
+		std::string segment;
+		size_t start = 0;
+		while(node) {
+			size_t ix = shv_path.find('/', start);
+			segment.assign(shv_path, start, (ix == std::string::npos)? std::string::npos: ix - start);
+			auto it = node->children.find(segment);
+			if(it == node->children.end())
+				break;
+			node = it->second.get();
+			add_subscribers(node);
+			if(ix == std::string::npos)
+				break;
+			// local path with trailing slash 'a/b/' matches any path below 'a/b', see ShvPath::startsWithPath()
+			auto it2 = node->children.find(std::string());
+			if(it2 != node->children.end())
+				add_subscribers(it2->second.get());
+			start = ix + 1;
+		}
+	}
+	std::sort(ret.begin(), ret.end());
+	ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+	return ret;
+}
+
+}}
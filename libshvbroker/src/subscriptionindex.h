@@ -0,0 +1,45 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace shv {
+namespace broker {
+
+/// Broker wide index of signal subscriptions.
+/// Subscription local paths are stored in a path segment trie, every trie node
+/// keeps subscribed connection IDs per method, empty method means any method.
+/// Signal fan-out walks the signal path segments only.
+class SubscriptionIndex
+{
+public:
+	SubscriptionIndex();
+	~SubscriptionIndex();
+
+	void addSubscription(int connection_id, const std::string &local_path, const std::string &method);
+	void removeSubscription(int connection_id, const std::string &local_path, const std::string &method);
+	void removeConnection(int connection_id);
+	void clear();
+
+	/// sorted IDs of connections having at least one subscription matching signal
+	std::vector<int> subscribedConnections(const std::string &shv_path, const std::string &method) const;
+	size_t subscriptionCount() const {return m_subscriptionCount;}
+private:
+	struct Node
+	{
+		std::map<std::string, std::unique_ptr<Node>> children;
+		/// method -> connection id -> subscription count
+		std::map<std::string, std::map<int, unsigned>> subscribers;
+
+		bool isEmpty() const {return children.empty() && subscribers.empty();}
+	};
+	static std::vector<std::string> splitPath(const std::string &local_path);
+	static size_t removeConnection(Node *node, int connection_id);
+private:
+	Node m_root;
+	size_t m_subscriptionCount = 0;
+};
+
+}}
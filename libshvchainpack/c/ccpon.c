@@ -73,10 +73,10 @@ static size_t uint_to_str_lpad(char *buff, size_t buff_len, uint64_t n, size_t w
 	size_t len = uint_to_str(buff, buff_len, n);
 	if(len < width && width <= buff_len) {
 		size_t i;
-		for (i = 0; i < len; ++i) {
+		for (i = 0; i < len; ++i)
 			buff[width-i-1] = buff[len-i-1];
-			buff[len-i-1] = pad_char;
-		}
+		for (i = 0; i < width - len; ++i)
+			buff[i] = pad_char;
 		return width;
 	}
 	return len;
@@ -4,6 +4,7 @@ QT -= core gui
 
 CONFIG += C++11
 CONFIG += hide_symbols
+include( $$PWD/rpcvalueflatmap.pri )
 
 TEMPLATE = lib
 TARGET = shvchainpack
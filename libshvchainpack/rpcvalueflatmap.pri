@@ -0,0 +1,5 @@
+# qmake CONFIG+=with-rpcvalue-flatmap stores RpcValue::Map and RpcValue::IMap in FlatMap instead of std::map,
+# it changes ABI, so libshvchainpack and all its users must be built with it
+with-rpcvalue-flatmap {
+    DEFINES += SHV_RPCVALUE_FLAT_MAP
+}
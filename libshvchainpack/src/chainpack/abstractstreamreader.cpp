@@ -6,8 +6,18 @@ namespace chainpack {
 size_t unpack_underflow_handler(ccpcp_unpack_context *ctx)
 {
 	AbstractStreamReader *rd = reinterpret_cast<AbstractStreamReader*>(ctx->custom_context);
-	int c = rd->m_in.get();
-	if(c < 0 || rd->m_in.eof()) {
+	if(!rd->m_readAheadBuff.empty()) {
+		// stream buffer is read directly, stream state is not changed on EOF, so tellg() still works
+		std::streamsize n = rd->m_in->rdbuf()->sgetn(rd->m_readAheadBuff.data(), static_cast<std::streamsize>(rd->m_readAheadBuff.size()));
+		if(n <= 0)
+			return 0;
+		ctx->start = rd->m_readAheadBuff.data();
+		ctx->current = ctx->start;
+		ctx->end = ctx->start + n;
+		return static_cast<size_t>(n);
+	}
+	int c = rd->m_in->get();
+	if(c < 0 || rd->m_in->eof()) {
 		// id directory is open then c == -1 but eof() == false, strange
 		return 0;
 	}
@@ -24,7 +34,7 @@ const char *AbstractStreamReader::ParseException::what() const noexcept
 }
 
 AbstractStreamReader::AbstractStreamReader(std::istream &in)
-	: m_in(in)
+	: m_in(&in)
 {
 	// C++ implementation does not require container states stack
 	//ccpcp_container_stack_init(&m_containerStack, m_containerStates, CONTAINER_STATE_CNT, NULL);
@@ -33,10 +43,50 @@ AbstractStreamReader::AbstractStreamReader(std::istream &in)
 	m_inCtx.custom_context = this;
 }
 
+AbstractStreamReader::AbstractStreamReader(std::istream &in, size_t read_ahead_size)
+	: AbstractStreamReader(in)
+{
+	m_readAheadBuff.resize(read_ahead_size);
+}
+
+AbstractStreamReader::AbstractStreamReader(const char *data, size_t length)
+{
+	// whole data are available, no underflow handler is needed
+	ccpcp_unpack_context_init(&m_inCtx, data, length, nullptr, nullptr);
+	m_inCtx.custom_context = this;
+}
+
 AbstractStreamReader::~AbstractStreamReader()
 {
 }
 
+long AbstractStreamReader::readPos()
+{
+	if(m_in) {
+		long pos = m_in->tellg();
+		if(pos < 0)
+			return pos;
+		// bytes taken from stream but not unpacked yet
+		return pos - (m_inCtx.end - m_inCtx.current);
+	}
+	return m_inCtx.current - m_inCtx.start;
+}
+
+std::string AbstractStreamReader::dataNearReadPos()
+{
+	static constexpr long NEAR_DATA_LEN = 40;
+	// bytes taken from stream but not unpacked yet go first
+	long len = m_inCtx.end - m_inCtx.current;
+	std::string ret(m_inCtx.current, len < NEAR_DATA_LEN? len: NEAR_DATA_LEN);
+	if(m_in && static_cast<long>(ret.size()) < NEAR_DATA_LEN) {
+		char buff[NEAR_DATA_LEN];
+		auto n = m_in->readsome(buff, NEAR_DATA_LEN - static_cast<long>(ret.size()));
+		if(n > 0)
+			ret.append(buff, static_cast<size_t>(n));
+	}
+	return ret;
+}
+
 RpcValue AbstractStreamReader::read(std::string *error)
 {
 	RpcValue ret;
@@ -4,6 +4,7 @@
 #include "../../c/ccpcp.h"
 
 #include <istream>
+#include <vector>
 
 namespace shv {
 namespace chainpack {
@@ -27,15 +28,27 @@ public:
 	friend size_t unpack_underflow_handler(ccpcp_unpack_context *ctx);
 public:
 	AbstractStreamReader(std::istream &in);
+	/// read stream in chunks of read_ahead_size bytes instead of byte by byte,
+	/// stream is owned by the reader then, bytes following the last value read might be consumed already
+	AbstractStreamReader(std::istream &in, size_t read_ahead_size);
+	/// read directly from contiguous memory, data must outlive the reader
+	AbstractStreamReader(const char *data, size_t length);
 	virtual ~AbstractStreamReader();
 
 	RpcValue read(std::string *error = nullptr);
 
 	virtual void read(RpcValue::MetaData &meta_data) = 0;
 	virtual void read(RpcValue &val) = 0;
+
+	/// number of bytes consumed so far, -1 if it cannot be determined
+	long readPos();
+protected:
+	/// few bytes following current read position, used in parse error messages
+	std::string dataNearReadPos();
 protected:
-	std::istream &m_in;
+	std::istream *m_in = nullptr;
 	char m_unpackBuff[1];
+	std::vector<char> m_readAheadBuff;
 	//static constexpr size_t CONTAINER_STATE_CNT = 100;
 	//ccpcp_container_state m_containerStates[CONTAINER_STATE_CNT];
 	//ccpcp_container_stack m_containerStack;
@@ -1,26 +1,52 @@
 #include "abstractstreamwriter.h"
 
+#include <algorithm>
+
 namespace shv {
 namespace chainpack {
 
 void pack_overflow_handler(ccpcp_pack_context *ctx, size_t size_hint)
 {
-	(void)size_hint;
 	AbstractStreamWriter *wr = reinterpret_cast<AbstractStreamWriter*>(ctx->custom_context);
-	while(ctx->start < ctx->current) {
-		wr->m_out << *ctx->start++;
+	if(wr->m_outString) {
+		// context buffer is the string itself, ctx->start points to its first byte
+		std::string &out = *wr->m_outString;
+		size_t len = static_cast<size_t>(ctx->current - ctx->start);
+		if(size_hint == 0) {
+			// flush, trim string to packed data length
+			out.resize(len);
+		}
+		else {
+			size_t new_size = std::max(len + size_hint, 2 * out.size());
+			out.resize(std::max(new_size, static_cast<size_t>(AbstractStreamWriter::PACK_BUFF_SIZE)));
+		}
+		ctx->start = &out[0];
+		ctx->current = ctx->start + len;
+		ctx->end = ctx->start + out.size();
+		return;
 	}
+	if(ctx->current > ctx->start)
+		wr->m_out->write(ctx->start, ctx->current - ctx->start);
 	ctx->start = wr->m_packBuff;
 	ctx->current = ctx->start;
 }
 
 AbstractStreamWriter::AbstractStreamWriter(std::ostream &out)
-	: m_out(out)
+	: m_out(&out)
 {
 	ccpcp_pack_context_init(&m_outCtx, m_packBuff, sizeof(m_packBuff), pack_overflow_handler);
 	m_outCtx.custom_context = this;
 }
 
+AbstractStreamWriter::AbstractStreamWriter(std::string &out)
+	: m_outString(&out)
+{
+	// empty context, first write will grow the string
+	ccpcp_pack_context_init(&m_outCtx, &out[0], out.size(), pack_overflow_handler);
+	m_outCtx.current = m_outCtx.end;
+	m_outCtx.custom_context = this;
+}
+
 AbstractStreamWriter::~AbstractStreamWriter()
 {
 	flush();
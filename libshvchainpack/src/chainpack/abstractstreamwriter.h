@@ -13,6 +13,8 @@ class SHVCHAINPACK_DECL_EXPORT AbstractStreamWriter
 	friend void pack_overflow_handler(ccpcp_pack_context *ctx, size_t size_hint);
 public:
 	AbstractStreamWriter(std::ostream &out);
+	/// pack directly to the end of out string, out size is valid after flush()
+	AbstractStreamWriter(std::string &out);
 	virtual ~AbstractStreamWriter();
 
 	virtual void write(const RpcValue::MetaData &meta_data) = 0;
@@ -30,9 +32,11 @@ public:
 	void flush();
 protected:
 	static constexpr bool WRITE_INVALID_AS_NULL = true;
+	static constexpr size_t PACK_BUFF_SIZE = 1024;
 protected:
-	std::ostream &m_out;
-	char m_packBuff[32];
+	std::ostream *m_out = nullptr;
+	std::string *m_outString = nullptr;
+	char m_packBuff[PACK_BUFF_SIZE];
 	ccpcp_pack_context m_outCtx;
 };
 
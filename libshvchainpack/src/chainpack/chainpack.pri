@@ -3,6 +3,7 @@ SOURCES += \
     $$PWD/rpc.cpp \
     $$PWD/rpcmessage.cpp \
     $$PWD/rpcvalue.cpp \
+    $$PWD/rpcvaluearena.cpp \
     $$PWD/rpcdriver.cpp \
     $$PWD/metatypes.cpp \
     $$PWD/exception.cpp \
@@ -19,13 +20,16 @@ SOURCES += \
     $$PWD/metamethod.cpp \
     $$PWD/tunnelctl.cpp \
     $$PWD/irpcconnection.cpp \
-    $$PWD/accessgrant.cpp
+    $$PWD/accessgrant.cpp \
+    $$PWD/rpcframereader.cpp
 
 HEADERS += \
     $$PWD/datachange.h \
     $$PWD/rpc.h \
     $$PWD/rpcmessage.h \
     $$PWD/rpcvalue.h \
+    $$PWD/rpcvaluearena.h \
+    $$PWD/flatmap.h \
     $$PWD/rpcdriver.h \
     $$PWD/metatypes.h \
     $$PWD/exception.h \
@@ -42,7 +46,8 @@ HEADERS += \
     $$PWD/metamethod.h \
     $$PWD/tunnelctl.h \
     $$PWD/irpcconnection.h \
-    $$PWD/accessgrant.h
+    $$PWD/accessgrant.h \
+    $$PWD/rpcframereader.h
 
 unix {
 SOURCES += \
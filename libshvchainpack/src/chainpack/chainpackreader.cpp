@@ -9,15 +9,15 @@ namespace shv {
 namespace chainpack {
 
 #define PARSE_EXCEPTION(msg) {\
-	char buff[40]; \
-	m_in.readsome(buff, sizeof(buff)); \
+	long pos = readPos(); \
+	std::string near_to = dataNearReadPos(); \
 	if(exception_aborts) { \
 		std::clog << __FILE__ << ':' << __LINE__;  \
-		std::clog << ' ' << (msg) << " at pos: " << m_in.tellg() << " near to: " << buff << std::endl; \
+		std::clog << ' ' << (msg) << " at pos: " << pos << " near to: " << near_to << std::endl; \
 		abort(); \
 	} \
 	else { \
-		throw ChainPackReader::ParseException(std::string("ChainPack ") + msg + std::string(" at pos: ") + std::to_string(m_in.tellg()) + " near to: " + buff, m_in.tellg()); \
+		throw ChainPackReader::ParseException(std::string("ChainPack ") + msg + std::string(" at pos: ") + std::to_string(pos) + " near to: " + near_to, pos); \
 	} \
 }
 
@@ -107,9 +107,25 @@ void ChainPackReader::read(RpcValue &val)
 	//	PARSE_EXCEPTION("maximum nesting depth exceeded");
 	//DepthScope{m_depth};
 
-	RpcValue::MetaData md;
-	read(md);
+	// most of values do not have meta data, do not construct them for every value
+	const char *p = ccpcp_unpack_peek_byte(&m_inCtx);
+	if(p && static_cast<uint8_t>(*p) == CP_MetaMap) {
+		RpcValue::MetaData md;
+		read(md);
+		parseValue(val);
+		if(!md.isEmpty()) {
+			if(!val.isValid())
+				PARSE_EXCEPTION("Attempt to set metadata to invalid RPC value.");
+			val.setMetaData(std::move(md));
+		}
+	}
+	else {
+		parseValue(val);
+	}
+}
 
+void ChainPackReader::parseValue(RpcValue &val)
+{
 	unpackNext();
 
 	switch(m_inCtx.item.type) {
@@ -140,14 +156,14 @@ void ChainPackReader::read(RpcValue &val)
 		ccpcp_string *it = &(m_inCtx.item.as.String);
 		std::string str;
 		while(m_inCtx.item.type == CCPCP_ITEM_STRING) {
-			str += std::string(it->chunk_start, it->chunk_size);
+			str.append(it->chunk_start, it->chunk_size);
 			if(it->last_chunk)
 				break;
 			unpackNext();
 			if(m_inCtx.item.type != CCPCP_ITEM_STRING)
 				PARSE_EXCEPTION("Unfinished string");
 		}
-		val = str;
+		val = RpcValue(std::move(str), m_arena);
 		break;
 	}
 	case CCPCP_ITEM_BLOB: {
@@ -161,7 +177,7 @@ void ChainPackReader::read(RpcValue &val)
 			if(m_inCtx.item.type != CCPCP_ITEM_BLOB)
 				PARSE_EXCEPTION("Unfinished blob");
 		}
-		val = blob;
+		val = RpcValue(std::move(blob), m_arena);
 		break;
 	}
 	case CCPCP_ITEM_BOOLEAN: {
@@ -193,11 +209,6 @@ void ChainPackReader::read(RpcValue &val)
 	default:
 		PARSE_EXCEPTION("Invalid type.");
 	}
-	if(!md.isEmpty()) {
-		if(!val.isValid())
-			PARSE_EXCEPTION("Attempt to set metadata to invalid RPC value.");
-		val.setMetaData(std::move(md));
-	}
 }
 
 void ChainPackReader::parseList(RpcValue &val)
@@ -210,9 +221,9 @@ void ChainPackReader::parseList(RpcValue &val)
 			m_inCtx.item.type = CCPCP_ITEM_INVALID;
 			break;
 		}
-		lst.push_back(v);
+		lst.push_back(std::move(v));
 	}
-	val = lst;
+	val = RpcValue(std::move(lst), m_arena);
 }
 
 void ChainPackReader::parseMetaData(RpcValue::MetaData &meta_data)
@@ -245,9 +256,9 @@ void ChainPackReader::parseMap(RpcValue &val)
 		}
 		RpcValue val;
 		read(val);
-		map[key.asString()] = val;
+		map[key.asString()] = std::move(val);
 	}
-	val = map;
+	val = RpcValue(std::move(map), m_arena);
 }
 
 void ChainPackReader::parseIMap(RpcValue &val)
@@ -262,9 +273,50 @@ void ChainPackReader::parseIMap(RpcValue &val)
 		}
 		RpcValue val;
 		read(val);
-		map[key.toInt()] = val;
+		map[key.toInt()] = std::move(val);
 	}
-	val = map;
+	val = RpcValue(std::move(map), m_arena);
+}
+
+void ChainPackReader::skipValue()
+{
+	unpackNext();
+	switch(m_inCtx.item.type) {
+	case CCPCP_ITEM_INVALID:
+		PARSE_EXCEPTION("Unexpected end of data.");
+	case CCPCP_ITEM_CONTAINER_END:
+		PARSE_EXCEPTION("Unexpected container end.");
+	case CCPCP_ITEM_META:
+		skipContainerItems();
+		// value following meta data
+		skipValue();
+		break;
+	case CCPCP_ITEM_LIST:
+	case CCPCP_ITEM_MAP:
+	case CCPCP_ITEM_IMAP:
+		skipContainerItems();
+		break;
+	case CCPCP_ITEM_STRING:
+	case CCPCP_ITEM_BLOB: {
+		const ItemType type = m_inCtx.item.type;
+		while(!m_inCtx.item.as.String.last_chunk) {
+			unpackNext();
+			if(m_inCtx.item.type != type)
+				PARSE_EXCEPTION("Unfinished string");
+		}
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+void ChainPackReader::skipContainerItems()
+{
+	// map keys are skipped as any other value
+	while(peekNext() != CCPCP_ITEM_CONTAINER_END)
+		skipValue();
+	unpackNext();
 }
 
 void ChainPackReader::read(RpcValue::MetaData &meta_data)
@@ -3,6 +3,8 @@
 #include "abstractstreamreader.h"
 #include "chainpack.h"
 
+#include <memory>
+
 namespace shv {
 namespace chainpack {
 
@@ -11,6 +13,8 @@ class SHVCHAINPACK_DECL_EXPORT ChainPackReader : public AbstractStreamReader
 	using Super = AbstractStreamReader;
 public:
 	ChainPackReader(std::istream &in) : Super(in) {}
+	ChainPackReader(std::istream &in, size_t read_ahead_size) : Super(in, read_ahead_size) {}
+	ChainPackReader(const char *data, size_t length) : Super(data, length) {}
 
 	ChainPackReader& operator >>(RpcValue &value);
 	ChainPackReader& operator >>(RpcValue::MetaData &meta_data);
@@ -27,12 +31,22 @@ public:
 
 	ItemType peekNext();
 	ItemType unpackNext();
+	/// move read position behind next value including its meta data, value is not decoded
+	void skipValue();
 	static const char* itemTypeToString(ItemType it);
+
+	/// strings and containers are allocated from arena if it is set
+	const std::shared_ptr<RpcValueArena>& arena() const {return m_arena;}
+	void setArena(const std::shared_ptr<RpcValueArena> &arena) {m_arena = arena;}
 private:
+	void parseValue(RpcValue &val);
 	void parseList(RpcValue &val);
 	void parseMetaData(RpcValue::MetaData &meta_data);
 	void parseMap(RpcValue &val);
 	void parseIMap(RpcValue &val);
+	void skipContainerItems();
+private:
+	std::shared_ptr<RpcValueArena> m_arena;
 };
 
 } // namespace chainpack
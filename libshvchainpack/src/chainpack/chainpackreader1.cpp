@@ -146,23 +146,23 @@ void ChainPackReader1::read(RpcValue::MetaData &meta_data)
 {
 	RpcValue::IMap imap;
 	RpcValue::Map smap;
-	uint8_t type_info = m_in.peek();
+	uint8_t type_info = m_in->peek();
 	if(type_info == ChainPack::PackingSchema::MetaMap) {
-		m_in.get();
+		m_in->get();
 		while(true) {
-			int b = m_in.peek();
+			int b = m_in->peek();
 			if(b == ChainPack::PackingSchema::TERM) {
-				m_in.get();
+				m_in->get();
 				break;
 			}
 			else if(b == ChainPack::STRING_META_KEY_PREFIX) {
-				m_in.get();
-				RpcValue::String key = readData_Blob<RpcValue::String>(m_in);
+				m_in->get();
+				RpcValue::String key = readData_Blob<RpcValue::String>(*m_in);
 				RpcValue cp = read();
 				smap[key] = cp;
 			}
 			else {
-				RpcValue::UInt key = readData_UInt<RpcValue::UInt>(m_in);
+				RpcValue::UInt key = readData_UInt<RpcValue::UInt>(*m_in);
 				RpcValue cp = read();
 				imap[key] = cp;
 			}
@@ -175,7 +175,7 @@ void ChainPackReader1::read(RpcValue &val)
 {
 	RpcValue::MetaData meta_data;
 	read(meta_data);
-	uint8_t type = m_in.get();
+	uint8_t type = m_in->get();
 	if(type < 128) {
 		if(type & 64) {
 			// tiny Int
@@ -222,21 +222,21 @@ RpcValue ChainPackReader1::readData(ChainPack::PackingSchema::Enum type_info, bo
 	else {
 		switch (type_info) {
 		case ChainPack::PackingSchema::Null: { ret = RpcValue(nullptr); break; }
-		case ChainPack::PackingSchema::UInt: { uint64_t u = readData_UInt<uint64_t>(m_in); ret = RpcValue(u); break; }
-		case ChainPack::PackingSchema::Int: { int64_t i = readData_Int<int64_t>(m_in); ret = RpcValue(i); break; }
-		case ChainPack::PackingSchema::Double: { double d = readData_Double(m_in); ret = RpcValue(d); break; }
-		case ChainPack::PackingSchema::Decimal: { RpcValue::Decimal d = readData_Decimal(m_in); ret = RpcValue(d); break; }
+		case ChainPack::PackingSchema::UInt: { uint64_t u = readData_UInt<uint64_t>(*m_in); ret = RpcValue(u); break; }
+		case ChainPack::PackingSchema::Int: { int64_t i = readData_Int<int64_t>(*m_in); ret = RpcValue(i); break; }
+		case ChainPack::PackingSchema::Double: { double d = readData_Double(*m_in); ret = RpcValue(d); break; }
+		case ChainPack::PackingSchema::Decimal: { RpcValue::Decimal d = readData_Decimal(*m_in); ret = RpcValue(d); break; }
 		case ChainPack::PackingSchema::TRUE: { bool b = true; ret = RpcValue(b); break; }
 		case ChainPack::PackingSchema::FALSE: { bool b = false; ret = RpcValue(b); break; }
-		//case ChainPack::TypeInfo::DateTimeEpoch: { RpcValue::DateTime val = readData_DateTimeEpoch(m_in); ret = RpcValue(val); break; }
-		case ChainPack::PackingSchema::DateTime: { RpcValue::DateTime val = readData_DateTime(m_in); ret = RpcValue(val); break; }
-		case ChainPack::PackingSchema::String: { RpcValue::String val = readData_Blob<RpcValue::String>(m_in); ret = RpcValue(val); break; }
-		case ChainPack::PackingSchema::CString: { RpcValue::String val = readData_CString(m_in); ret = RpcValue(val); break; }
-		case ChainPack::PackingSchema::Blob: { RpcValue::String val = readData_Blob<RpcValue::String>(m_in); ret = RpcValue(val); break; }
+		//case ChainPack::TypeInfo::DateTimeEpoch: { RpcValue::DateTime val = readData_DateTimeEpoch(*m_in); ret = RpcValue(val); break; }
+		case ChainPack::PackingSchema::DateTime: { RpcValue::DateTime val = readData_DateTime(*m_in); ret = RpcValue(val); break; }
+		case ChainPack::PackingSchema::String: { RpcValue::String val = readData_Blob<RpcValue::String>(*m_in); ret = RpcValue(val); break; }
+		case ChainPack::PackingSchema::CString: { RpcValue::String val = readData_CString(*m_in); ret = RpcValue(val); break; }
+		case ChainPack::PackingSchema::Blob: { RpcValue::String val = readData_Blob<RpcValue::String>(*m_in); ret = RpcValue(val); break; }
 		case ChainPack::PackingSchema::List: { RpcValue::List val = readData_List(); ret = RpcValue(val); break; }
 		case ChainPack::PackingSchema::Map: { RpcValue::Map val = readData_Map(); ret = RpcValue(val); break; }
 		case ChainPack::PackingSchema::IMap: { RpcValue::IMap val = readData_IMap(); ret = RpcValue(val); break; }
-		case ChainPack::PackingSchema::Bool: { uint8_t t = m_in.get(); ret = RpcValue(t != 0); break; }
+		case ChainPack::PackingSchema::Bool: { uint8_t t = m_in->get(); ret = RpcValue(t != 0); break; }
 		default:
 			SHVCHP_EXCEPTION("Internal error: attempt to read helper type directly. type: " + Utils::toString(type_info) + " " + ChainPack::PackingSchema::name(type_info));
 		}
@@ -248,11 +248,11 @@ RpcValue::List ChainPackReader1::readData_List()
 {
 	RpcValue::List lst;
 	while(true) {
-		int b = m_in.peek();
+		int b = m_in->peek();
 		if(b < 0)
 			SHVCHP_EXCEPTION("Unexpected EOF!");
 		if(b == ChainPack::PackingSchema::TERM) {
-			m_in.get();
+			m_in->get();
 			break;
 		}
 		RpcValue cp = read();
@@ -265,14 +265,14 @@ RpcValue::Map ChainPackReader1::readData_Map()
 {
 	RpcValue::Map ret;
 	while(true) {
-		int b = m_in.peek();
+		int b = m_in->peek();
 		if(b < 0)
 			SHVCHP_EXCEPTION("Unexpected EOF!");
 		if(b == ChainPack::PackingSchema::TERM) {
-			m_in.get();
+			m_in->get();
 			break;
 		}
-		RpcValue::String key = readData_Blob<RpcValue::String>(m_in);
+		RpcValue::String key = readData_Blob<RpcValue::String>(*m_in);
 		RpcValue cp = read();
 		ret[key] = cp;
 	}
@@ -283,12 +283,12 @@ RpcValue::IMap ChainPackReader1::readData_IMap()
 {
 	RpcValue::IMap ret;
 	while(true) {
-		int b = m_in.peek();
+		int b = m_in->peek();
 		if(b == ChainPack::PackingSchema::TERM) {
-			m_in.get();
+			m_in->get();
 			break;
 		}
-		RpcValue::UInt key = readData_UInt<RpcValue::UInt>(m_in);
+		RpcValue::UInt key = readData_UInt<RpcValue::UInt>(*m_in);
 		RpcValue cp = read();
 		ret[key] = cp;
 	}
@@ -322,7 +322,7 @@ RpcValue::List ChainPackReader1::readData_Array(ChainPack::PackingSchema::Enum a
 {
 	//RpcValue::Type type = typeInfoToArrayType(array_type_info);
 	RpcValue::List ret;
-	RpcValue::UInt size = readData_UInt<RpcValue::UInt>(m_in);
+	RpcValue::UInt size = readData_UInt<RpcValue::UInt>(*m_in);
 	ret.reserve(size);
 	for (unsigned i = 0; i < size; ++i) {
 		RpcValue cp = readData(array_type_info, false);
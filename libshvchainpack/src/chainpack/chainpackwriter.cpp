@@ -23,6 +23,12 @@ void ChainPackWriter::write(const RpcValue &value)
 	if(!value.metaData().isEmpty()) {
 		write(value.metaData());
 	}
+	if(value.isRawChainPack()) {
+		// value forwarded unchanged, packed data can be copied
+		std::pair<const char*, size_t> raw = value.rawChainPackData();
+		ccpcp_pack_copy_bytes(&m_outCtx, raw.first, raw.second);
+		return;
+	}
 	switch (value.type()) {
 	case RpcValue::Type::Null: write_p(nullptr); break;
 	case RpcValue::Type::UInt: write_p(value.toUInt64()); break;
@@ -48,10 +54,9 @@ void ChainPackWriter::write(const RpcValue::MetaData &meta_data)
 {
 	if(!meta_data.isEmpty()) {
 		cchainpack_pack_meta_begin(&m_outCtx);
-		const RpcValue::IMap &cim = meta_data.iValues();
-		for (const auto &kv : cim) {
-			writeMapElement(kv.first, kv.second);
-		}
+		meta_data.forEachIValue([this](RpcValue::Int key, const RpcValue &val) {
+			writeMapElement(key, val);
+		});
 		const RpcValue::Map &csm = meta_data.sValues();
 		for (const auto &kv : csm) {
 			writeMapElement(kv.first, kv.second);
@@ -10,6 +10,7 @@ class SHVCHAINPACK_DECL_EXPORT ChainPackWriter : public shv::chainpack::Abstract
 	using Super = AbstractStreamWriter;
 public:
 	ChainPackWriter(std::ostream &out) : Super(out) {}
+	ChainPackWriter(std::string &out) : Super(out) {}
 
 	ChainPackWriter& operator <<(const RpcValue &value) {write(value); return *this;}
 	ChainPackWriter& operator <<(const RpcValue::MetaData &meta_data) {write(meta_data); return *this;}
@@ -10,19 +10,19 @@ namespace shv {
 namespace chainpack {
 
 #define PARSE_EXCEPTION(msg) {\
-	char buff[40]; \
-	m_in.readsome(buff, sizeof(buff)); \
+	long pos = readPos(); \
+	std::string near_to = dataNearReadPos(); \
 	if(exception_aborts) { \
 		std::clog << __FILE__ << ':' << __LINE__;  \
-		std::clog << ' ' << (msg) << " at pos: " << m_in.tellg() << " near to: " << buff << std::endl; \
+		std::clog << ' ' << (msg) << " at pos: " << pos << " near to: " << near_to << std::endl; \
 		abort(); \
 	} \
 	else { \
 		throw CponReader::ParseException(std::string("Cpon ") \
 			+ msg \
-			+ std::string(" at pos: ") + std::to_string(m_in.tellg()) \
+			+ std::string(" at pos: ") + std::to_string(pos) \
 			+ std::string(" line: ") + std::to_string(m_inCtx.parser_line_no) \
-			+ " near to: " + buff, m_in.tellg()); \
+			+ " near to: " + near_to, pos); \
 	} \
 }
 
@@ -15,6 +15,7 @@ class SHVCHAINPACK_DECL_EXPORT CponReader : public AbstractStreamReader
 	using Super = AbstractStreamReader;
 public:
 	CponReader(std::istream &in) : Super(in) {}
+	CponReader(const char *data, size_t length) : Super(data, length) {}
 
 	CponReader& operator >>(RpcValue &value);
 	CponReader& operator >>(RpcValue::MetaData &meta_data);
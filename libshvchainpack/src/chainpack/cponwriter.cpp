@@ -52,16 +52,20 @@ static bool is_oneline_meta(const RpcValue::MetaData &meta)
 {
 	if(meta.size() > 5)
 		return false;
-	for (const auto &kv : meta.iValues()) {
-		switch (kv.second.type()) {
+	bool has_container = false;
+	meta.forEachIValue([&has_container](RpcValue::Int, const RpcValue &val) {
+		switch (val.type()) {
 		case RpcValue::Type::Map:
 		case RpcValue::Type::IMap:
 		case RpcValue::Type::List:
-			return false;
+			has_container = true;
+			break;
 		default:
 			break;
 		}
-	}
+	});
+	if(has_container)
+		return false;
 	for (const auto &kv : meta.sValues()) {
 		switch (kv.second.type()) {
 		case RpcValue::Type::Map:
@@ -83,6 +87,14 @@ CponWriter::CponWriter(std::ostream &out, const CponWriterOptions &opts)
 	m_outCtx.cpon_options.indent = m_opts.indent().empty()? nullptr: m_opts.indent().data();
 }
 
+CponWriter::CponWriter(std::string &out, const CponWriterOptions &opts)
+	: Super(out)
+	, m_opts(opts)
+{
+	m_outCtx.cpon_options.json_output = opts.isJsonFormat();
+	m_outCtx.cpon_options.indent = m_opts.indent().empty()? nullptr: m_opts.indent().data();
+}
+
 void CponWriter::write(const RpcValue &value)
 {
 	if(!value.metaData().isEmpty()) {
@@ -113,49 +125,45 @@ void CponWriter::write(const RpcValue::MetaData &meta_data)
 {
 	if(!meta_data.isEmpty()) {
 		writeMetaBegin(is_oneline_meta(meta_data));
-		const RpcValue::IMap &cim = meta_data.iValues();
-		if(!cim.empty()) {
-			for (const auto &kv : cim) {
-				if(m_opts.isTranslateIds()) {
-					ContainerState &cs = m_containerStates[m_containerStates.size() - 1];
-					ccpon_pack_field_delim(&m_outCtx, cs.elementCount++ == 0, cs.isOneLiner);
-					int nsid = meta_data.metaTypeNameSpaceId();
-					int mtid = meta_data.metaTypeId();
-					int tag = kv.first;
-					const meta::MetaInfo &tag_info = meta::registeredType(nsid, mtid).tagById(tag);
-					if(tag_info.isValid())
-						ccpcp_pack_copy_bytes(&m_outCtx, tag_info.name, ::strlen(tag_info.name));
+		meta_data.forEachIValue([this, &meta_data](RpcValue::Int key, const RpcValue &meta_val) {
+			if(m_opts.isTranslateIds()) {
+				ContainerState &cs = m_containerStates[m_containerStates.size() - 1];
+				ccpon_pack_field_delim(&m_outCtx, cs.elementCount++ == 0, cs.isOneLiner);
+				int nsid = meta_data.metaTypeNameSpaceId();
+				int mtid = meta_data.metaTypeId();
+				int tag = static_cast<int>(key);
+				const meta::MetaInfo &tag_info = meta::registeredType(nsid, mtid).tagById(tag);
+				if(tag_info.isValid())
+					ccpcp_pack_copy_bytes(&m_outCtx, tag_info.name, ::strlen(tag_info.name));
+				else
+					write(tag);
+				ccpon_pack_key_val_delim(&m_outCtx);
+				if(tag == meta::Tag::MetaTypeNameSpaceId) {
+					int id = meta_val.toInt();
+					const meta::MetaNameSpace &type = meta::registeredNameSpace(nsid);
+					const char *n = type.name();
+					if(n[0])
+						ccpcp_pack_copy_bytes(&m_outCtx, n, ::strlen(n));
+					else
+						write(id);
+				}
+				else if(tag == meta::Tag::MetaTypeId) {
+					int id = meta_val.toInt();
+					const meta::MetaType &type = meta::registeredType(nsid, id);
+					const char *n = type.name();
+					if(n[0])
+						ccpcp_pack_copy_bytes(&m_outCtx, n, ::strlen(n));
 					else
-						write(tag);
-					ccpon_pack_key_val_delim(&m_outCtx);
-					RpcValue meta_val = kv.second;
-					if(tag == meta::Tag::MetaTypeNameSpaceId) {
-						int id = meta_val.toInt();
-						const meta::MetaNameSpace &type = meta::registeredNameSpace(nsid);
-						const char *n = type.name();
-						if(n[0])
-							ccpcp_pack_copy_bytes(&m_outCtx, n, ::strlen(n));
-						else
-							write(id);
-					}
-					else if(tag == meta::Tag::MetaTypeId) {
-						int id = meta_val.toInt();
-						const meta::MetaType &type = meta::registeredType(nsid, id);
-						const char *n = type.name();
-						if(n[0])
-							ccpcp_pack_copy_bytes(&m_outCtx, n, ::strlen(n));
-						else
-							write(id);
-					}
-					else {
-						write(meta_val);
-					}
+						write(id);
 				}
 				else {
-					writeMapElement(kv.first, kv.second);
+					write(meta_val);
 				}
 			}
-		}
+			else {
+				writeMapElement(key, meta_val);
+			}
+		});
 		const RpcValue::Map &csm = meta_data.sValues();
 		for (const auto &kv : csm) {
 			writeMapElement(kv.first, kv.second);
@@ -36,6 +36,8 @@ class SHVCHAINPACK_DECL_EXPORT CponWriter : public AbstractStreamWriter
 public:
 	CponWriter(std::ostream &out) : Super(out) {}
 	CponWriter(std::ostream &out, const CponWriterOptions &opts);
+	CponWriter(std::string &out) : Super(out) {}
+	CponWriter(std::string &out, const CponWriterOptions &opts);
 
 	CponWriter& operator <<(const RpcValue &value) {write(value); return *this;}
 	CponWriter& operator <<(const RpcValue::MetaData &meta_data) {write(meta_data); return *this;}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace shv {
+namespace chainpack {
+
+/// Associative container with std::map like interface stored in vectors sorted by key.
+///
+/// Keys and values are stored in separate vectors, lookup is binary search over contiguous keys
+/// and iteration is vector iteration, both are considerably faster than std::map tree walk.
+/// Iteration order is the key order like in std::map, so serialized output stays deterministic.
+/// Insertion and erase are O(n) except insertion at the end, which is O(1),
+/// it is the case when map is decoded from ChainPack or Cpon, keys are sorted there.
+///
+/// Differences from std::map:
+/// * iterator dereference returns std::pair<const Key&, T&> proxy,
+///   key cannot be modified through it, but iterate with 'const auto &' or 'auto &&', not 'auto &'
+/// * iterators and references are invalidated by insertion and erase
+template<typename Key, typename T, typename Compare = std::less<Key>>
+class FlatMap
+{
+	template<bool IsConst> class Iterator;
+public:
+	using key_type = Key;
+	using mapped_type = T;
+	using value_type = std::pair<const Key, T>;
+	using key_compare = Compare;
+	using size_type = size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = std::pair<const Key&, T&>;
+	using const_reference = std::pair<const Key&, const T&>;
+	using iterator = Iterator<false>;
+	using const_iterator = Iterator<true>;
+	using reverse_iterator = std::reverse_iterator<iterator>;
+	using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+private:
+	template<bool IsConst>
+	class Iterator
+	{
+		friend class FlatMap;
+		using Map = typename std::conditional<IsConst, const FlatMap, FlatMap>::type;
+	public:
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type = FlatMap::value_type;
+		using difference_type = FlatMap::difference_type;
+		using reference = typename std::conditional<IsConst, FlatMap::const_reference, FlatMap::reference>::type;
+		/// operator->() returns proxy reference wrapped in this
+		class pointer
+		{
+		public:
+			explicit pointer(const reference &ref) : m_ref(ref) {}
+			const reference* operator->() const { return &m_ref; }
+		private:
+			reference m_ref;
+		};
+	public:
+		Iterator() {}
+		/// iterator to const_iterator conversion
+		template<bool C, typename = typename std::enable_if<IsConst && !C>::type>
+		Iterator(const Iterator<C> &o) : m_map(o.map()), m_ix(o.index()) {}
+
+		reference operator*() const { return reference(m_map->m_keys[m_ix], m_map->m_values[m_ix]); }
+		pointer operator->() const { return pointer(**this); }
+		reference operator[](difference_type n) const { return *(*this + n); }
+
+		Iterator& operator++() { ++m_ix; return *this; }
+		Iterator operator++(int) { Iterator ret = *this; ++m_ix; return ret; }
+		Iterator& operator--() { --m_ix; return *this; }
+		Iterator operator--(int) { Iterator ret = *this; --m_ix; return ret; }
+		Iterator& operator+=(difference_type n) { m_ix = static_cast<size_type>(static_cast<difference_type>(m_ix) + n); return *this; }
+		Iterator& operator-=(difference_type n) { return *this += -n; }
+		Iterator operator+(difference_type n) const { Iterator ret = *this; return ret += n; }
+		Iterator operator-(difference_type n) const { Iterator ret = *this; return ret -= n; }
+		template<bool C>
+		difference_type operator-(const Iterator<C> &o) const { return static_cast<difference_type>(m_ix) - static_cast<difference_type>(o.index()); }
+
+		template<bool C> bool operator==(const Iterator<C> &o) const { return m_ix == o.index(); }
+		template<bool C> bool operator!=(const Iterator<C> &o) const { return m_ix != o.index(); }
+		template<bool C> bool operator<(const Iterator<C> &o) const { return m_ix < o.index(); }
+		template<bool C> bool operator>(const Iterator<C> &o) const { return m_ix > o.index(); }
+		template<bool C> bool operator<=(const Iterator<C> &o) const { return m_ix <= o.index(); }
+		template<bool C> bool operator>=(const Iterator<C> &o) const { return m_ix >= o.index(); }
+
+		Map* map() const { return m_map; }
+		size_type index() const { return m_ix; }
+	private:
+		Iterator(Map *map, size_type ix) : m_map(map), m_ix(ix) {}
+	private:
+		Map *m_map = nullptr;
+		size_type m_ix = 0;
+	};
+public:
+	FlatMap() {}
+	FlatMap(std::initializer_list<value_type> init) : FlatMap(init.begin(), init.end()) {}
+	template<typename InputIt>
+	FlatMap(InputIt first, InputIt last) { insert(first, last); }
+
+	iterator begin() noexcept { return iterator(this, 0); }
+	const_iterator begin() const noexcept { return const_iterator(this, 0); }
+	const_iterator cbegin() const noexcept { return begin(); }
+	iterator end() noexcept { return iterator(this, size()); }
+	const_iterator end() const noexcept { return const_iterator(this, size()); }
+	const_iterator cend() const noexcept { return end(); }
+	reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+	const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+	reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+	const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+
+	bool empty() const noexcept { return m_keys.empty(); }
+	size_type size() const noexcept { return m_keys.size(); }
+	void clear() noexcept { m_keys.clear(); m_values.clear(); }
+	void reserve(size_type n) { m_keys.reserve(n); m_values.reserve(n); }
+	void swap(FlatMap &o) noexcept { m_keys.swap(o.m_keys); m_values.swap(o.m_values); }
+
+	iterator lower_bound(const Key &key) { return iterator(this, lowerBoundIndex(key)); }
+	const_iterator lower_bound(const Key &key) const { return const_iterator(this, lowerBoundIndex(key)); }
+	iterator upper_bound(const Key &key) { return iterator(this, upperBoundIndex(key)); }
+	const_iterator upper_bound(const Key &key) const { return const_iterator(this, upperBoundIndex(key)); }
+	iterator find(const Key &key) { return iterator(this, findIndex(key)); }
+	const_iterator find(const Key &key) const { return const_iterator(this, findIndex(key)); }
+	size_type count(const Key &key) const { return (findIndex(key) == size())? 0: 1; }
+
+	T& at(const Key &key)
+	{
+		size_type ix = findIndex(key);
+		if(ix == size())
+			throw std::out_of_range("FlatMap::at: key not found");
+		return m_values[ix];
+	}
+	const T& at(const Key &key) const
+	{
+		size_type ix = findIndex(key);
+		if(ix == size())
+			throw std::out_of_range("FlatMap::at: key not found");
+		return m_values[ix];
+	}
+	T& operator[](const Key &key) { return (*try_emplace(key).first).second; }
+	T& operator[](Key &&key) { return (*try_emplace(std::move(key)).first).second; }
+
+	/// accepts value_type and any other pair with members convertible to key and value
+	template<typename P>
+	std::pair<iterator, bool> insert(P &&value) { return try_emplace(std::forward<P>(value).first, std::forward<P>(value).second); }
+	std::pair<iterator, bool> insert(const value_type &value) { return try_emplace(value.first, value.second); }
+	template<typename InputIt>
+	void insert(InputIt first, InputIt last)
+	{
+		for(; first != last; ++first)
+			insert(*first);
+	}
+	void insert(std::initializer_list<value_type> init) { insert(init.begin(), init.end()); }
+	template<typename... Args>
+	std::pair<iterator, bool> emplace(Args&&... args) { return insert(value_type(std::forward<Args>(args)...)); }
+	/// hint is not needed, appending of keys in ascending order is fast without it
+	template<typename... Args>
+	iterator emplace_hint(const_iterator hint, Args&&... args) { (void)hint; return emplace(std::forward<Args>(args)...).first; }
+	template<typename K, typename... Args>
+	std::pair<iterator, bool> try_emplace(K &&key, Args&&... args)
+	{
+		size_type ix = insertIndex(key);
+		if(ix < size() && !Compare()(key, m_keys[ix]))
+			return {iterator(this, ix), false};
+		m_keys.emplace(m_keys.begin() + static_cast<difference_type>(ix), std::forward<K>(key));
+		try {
+			m_values.emplace(m_values.begin() + static_cast<difference_type>(ix), std::forward<Args>(args)...);
+		}
+		catch (...) {
+			m_keys.erase(m_keys.begin() + static_cast<difference_type>(ix));
+			throw;
+		}
+		return {iterator(this, ix), true};
+	}
+
+	iterator erase(const_iterator pos) { return erase(pos, std::next(pos)); }
+	iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		const difference_type ix1 = static_cast<difference_type>(first.index());
+		const difference_type ix2 = static_cast<difference_type>(last.index());
+		m_keys.erase(m_keys.begin() + ix1, m_keys.begin() + ix2);
+		m_values.erase(m_values.begin() + ix1, m_values.begin() + ix2);
+		return iterator(this, first.index());
+	}
+	size_type erase(const Key &key)
+	{
+		size_type ix = findIndex(key);
+		if(ix == size())
+			return 0;
+		erase(const_iterator(this, ix));
+		return 1;
+	}
+
+	bool operator==(const FlatMap &o) const { return m_keys == o.m_keys && m_values == o.m_values; }
+	bool operator!=(const FlatMap &o) const { return !operator==(o); }
+	bool operator<(const FlatMap &o) const { return std::lexicographical_compare(begin(), end(), o.begin(), o.end()); }
+private:
+	size_type lowerBoundIndex(const Key &key) const
+	{
+		return static_cast<size_type>(std::lower_bound(m_keys.begin(), m_keys.end(), key, Compare()) - m_keys.begin());
+	}
+	size_type upperBoundIndex(const Key &key) const
+	{
+		return static_cast<size_type>(std::upper_bound(m_keys.begin(), m_keys.end(), key, Compare()) - m_keys.begin());
+	}
+	size_type findIndex(const Key &key) const
+	{
+		size_type ix = lowerBoundIndex(key);
+		return (ix < size() && !Compare()(key, m_keys[ix]))? ix: size();
+	}
+	/// lower bound with fast path for keys inserted in ascending order
+	template<typename K>
+	size_type insertIndex(const K &key) const
+	{
+		if(m_keys.empty() || Compare()(m_keys.back(), key))
+			return size();
+		return lowerBoundIndex(key);
+	}
+private:
+	std::vector<Key> m_keys;
+	std::vector<T> m_values;
+};
+
+} // namespace chainpack
+} // namespace shv
@@ -6,11 +6,15 @@
 #include "cponreader.h"
 #include "chainpackwriter.h"
 #include "chainpackreader.h"
+#include "rpcvaluearena.h"
+#include "../../c/cchainpack.h"
 
 #include <necrolog.h>
 
-#include <sstream>
+#include <algorithm>
 #include <iostream>
+#include <set>
+#include <vector>
 
 #define logRpcRawMsg() nCMessage("RpcRawMsg")
 #define logRpcData() nCMessage("RpcData")
@@ -24,6 +28,9 @@ const char * RpcDriver::SND_LOG_ARROW = "<==S";
 const char * RpcDriver::RCV_LOG_ARROW = "R==>";
 
 int RpcDriver::s_defaultRpcTimeoutMsec = 5000;
+size_t RpcDriver::s_decodeArenaMinDataSize = 64 * 1024;
+size_t RpcDriver::s_lazyDecodeMinDataSize = 64 * 1024;
+size_t RpcDriver::s_writeBatchMaxBytes = 64 * 1024;
 
 RpcDriver::RpcDriver()
 {
@@ -42,7 +49,9 @@ void RpcDriver::sendRpcValue(const RpcValue &msg)
 	logRpcData() << "protocol:" << Rpc::protocolTypeToString(protocolType())
 				 << "packed data:"
 				 << ((protocolType() == Rpc::ProtocolType::ChainPack)? Utils::toHex(packed_data, 0, 250): packed_data.substr(0, 250));
-	enqueueDataToSend(MessageData{std::move(packed_data)});
+	MessageData chunk{std::move(packed_data)};
+	setSignalInfo(chunk, msg.metaData());
+	enqueueDataToSend(std::move(chunk));
 }
 
 void RpcDriver::sendRawData(std::string &&data)
@@ -55,17 +64,86 @@ void RpcDriver::sendRawData(const RpcValue::MetaData &meta_data, std::string &&d
 {
 	logRpcRawMsg() << SND_LOG_ARROW << "protocol:" << Rpc::protocolTypeToString(protocolType()) << "send raw meta + data: " << meta_data.toPrettyString()
 				<< Utils::toHex(data, 0, 250);
-	using namespace std;
-	//shvLogFuncFrame() << msg.toStdString();
-	std::ostringstream os_packed_meta_data;
-	switch (protocolType()) {
+	MessageData chunk = isRawDataRecodingNeeded(meta_data)
+			? recodeRawData(meta_data, data)
+			: MessageData(codeMetaData(protocolType(), meta_data), std::move(data));
+	setSignalInfo(chunk, meta_data);
+	enqueueDataToSend(std::move(chunk));
+}
+
+void RpcDriver::sendRawData(const RpcValue::MetaData &meta_data, const std::shared_ptr<const std::string> &data)
+{
+	logRpcRawMsg() << SND_LOG_ARROW << "protocol:" << Rpc::protocolTypeToString(protocolType()) << "send raw meta + shared data: " << meta_data.toPrettyString()
+				<< Utils::toHex(*data, 0, 250);
+	MessageData chunk = isRawDataRecodingNeeded(meta_data)
+			? recodeRawData(meta_data, *data)
+			: MessageData(codeMetaData(protocolType(), meta_data), data);
+	setSignalInfo(chunk, meta_data);
+	enqueueDataToSend(std::move(chunk));
+}
+
+void RpcDriver::setSignalInfo(MessageData &chunk, const RpcValue::MetaData &meta_data) const
+{
+	// signal info is needed for send queue overflow handling only
+	if(!m_sendQueueLimits.isValid() || !RpcMessage::isSignal(meta_data))
+		return;
+	chunk.isSignal = true;
+	if(m_sendQueueLimits.overflowPolicy == SendQueueOverflowPolicy::CoalesceSignals) {
+		// coalesce key is created on overflow only, not for every message
+		const RpcValue method = RpcMessage::method(meta_data);
+		const std::string &method_str = method.asString();
+		if(method_str == Rpc::SIG_VAL_CHANGED)
+			chunk.coalesceMethod = Rpc::SIG_VAL_CHANGED;
+		else if(method_str == Rpc::SIG_VAL_FASTCHANGED)
+			chunk.coalesceMethod = Rpc::SIG_VAL_FASTCHANGED;
+		if(chunk.coalesceMethod)
+			chunk.coalescePath = RpcMessage::shvPath(meta_data);
+	}
+}
+
+void RpcDriver::setSendQueueLimits(const SendQueueLimits &limits)
+{
+	m_sendQueueLimits = limits;
+	if(m_sendQueueLimits.lowWatermarkBytes == 0 || m_sendQueueLimits.lowWatermarkBytes > m_sendQueueLimits.highWatermarkBytes)
+		m_sendQueueLimits.lowWatermarkBytes = m_sendQueueLimits.highWatermarkBytes / 2;
+	if(m_sendQueueLimits.lowWatermarkMessages == 0 || m_sendQueueLimits.lowWatermarkMessages > m_sendQueueLimits.highWatermarkMessages)
+		m_sendQueueLimits.lowWatermarkMessages = m_sendQueueLimits.highWatermarkMessages / 2;
+}
+
+const char *RpcDriver::sendQueueOverflowPolicyToString(SendQueueOverflowPolicy policy)
+{
+	switch (policy) {
+	case SendQueueOverflowPolicy::DropOldestSignals: return "dropOldestSignals";
+	case SendQueueOverflowPolicy::CoalesceSignals: return "coalesceSignals";
+	case SendQueueOverflowPolicy::Disconnect: return "disconnect";
+	}
+	return "???";
+}
+
+RpcDriver::SendQueueOverflowPolicy RpcDriver::sendQueueOverflowPolicyFromString(const std::string &s, bool *ok)
+{
+	if(ok)
+		*ok = true;
+	for(auto policy : {SendQueueOverflowPolicy::DropOldestSignals, SendQueueOverflowPolicy::CoalesceSignals, SendQueueOverflowPolicy::Disconnect}) {
+		if(s == sendQueueOverflowPolicyToString(policy))
+			return policy;
+	}
+	if(ok)
+		*ok = false;
+	return SendQueueOverflowPolicy::DropOldestSignals;
+}
+
+std::string RpcDriver::codeMetaData(Rpc::ProtocolType protocol_type, const RpcValue::MetaData &meta_data)
+{
+	std::string packed_meta_data;
+	switch (protocol_type) {
 	case Rpc::ProtocolType::Cpon: {
-		CponWriter wr(os_packed_meta_data);
+		CponWriter wr(packed_meta_data);
 		wr << meta_data;
 		break;
 	}
 	case Rpc::ProtocolType::ChainPack: {
-		ChainPackWriter wr(os_packed_meta_data);
+		ChainPackWriter wr(packed_meta_data);
 		wr << meta_data;
 		break;
 	}
@@ -75,26 +153,32 @@ void RpcDriver::sendRawData(const RpcValue::MetaData &meta_data, std::string &&d
 	default:
 		SHVCHP_EXCEPTION("Cannot serialize data without protocol version specified.");
 	}
-	Rpc::ProtocolType packed_data_ver = RpcMessage::protocolType(meta_data);
+	return packed_meta_data;
+}
+
+bool RpcDriver::isRawDataRecodingNeeded(const RpcValue::MetaData &meta_data) const
+{
 	if(protocolType() == Rpc::ProtocolType::JsonRpc) {
 		// JSON RPC must be handled separately
+		return true;
+	}
+	Rpc::ProtocolType packed_data_ver = RpcMessage::protocolType(meta_data);
+	return !(packed_data_ver == Rpc::ProtocolType::Invalid || packed_data_ver == protocolType());
+}
+
+RpcDriver::MessageData RpcDriver::recodeRawData(const RpcValue::MetaData &meta_data, const std::string &data) const
+{
+	Rpc::ProtocolType packed_data_ver = RpcMessage::protocolType(meta_data);
+	if(protocolType() == Rpc::ProtocolType::JsonRpc) {
 		if(packed_data_ver == Rpc::ProtocolType::Invalid)
 			SHVCHP_EXCEPTION("Cannot serialize to JSON-RPC data without protocol version specified.");
-		// recode data;
 		RpcValue val = decodeData(packed_data_ver, data, 0);
 		val.setMetaData(RpcValue::MetaData(meta_data));
-		enqueueDataToSend(MessageData(codeRpcValue(Rpc::ProtocolType::JsonRpc, val)));
-	}
-	else {
-		if(packed_data_ver == Rpc::ProtocolType::Invalid || packed_data_ver == protocolType()) {
-			enqueueDataToSend(MessageData(os_packed_meta_data.str(), std::move(data)));
-		}
-		else {
-			// recode data;
-			RpcValue val = decodeData(packed_data_ver, data, 0);
-			enqueueDataToSend(MessageData(os_packed_meta_data.str(), codeRpcValue(protocolType(), val)));
-		}
+		return MessageData(codeRpcValue(Rpc::ProtocolType::JsonRpc, val));
 	}
+	std::string packed_meta_data = codeMetaData(protocolType(), meta_data);
+	RpcValue val = decodeData(packed_data_ver, data, 0);
+	return MessageData(std::move(packed_meta_data), codeRpcValue(protocolType(), val));
 }
 
 RpcMessage RpcDriver::composeRpcMessage(RpcValue::MetaData &&meta_data, const std::string &data, std::string *errmsg)
@@ -120,8 +204,19 @@ void RpcDriver::enqueueDataToSend(RpcDriver::MessageData &&chunk_to_enqueue)
 	/// LOCK_FOR_SEND lock mutex here in the multithreaded environment
 	lockSendQueueGuard();
 	if(!chunk_to_enqueue.empty()) {
+		m_sendQueueBytes += chunk_to_enqueue.size();
 		m_sendQueue.push_back(std::move(chunk_to_enqueue));
 		logWriteQueue() << "===========> write chunk added, new queue len:" << m_sendQueue.size();
+		if(isSendQueueOverHighWatermark()) {
+			if(m_sendQueueLimits.overflowPolicy == SendQueueOverflowPolicy::Disconnect) {
+				logWriteQueueW() << "send queue overflow, len:" << m_sendQueue.size() << "bytes:" << m_sendQueueBytes << "closing connection";
+				clearSendQueue();
+				unlockSendQueueGuard();
+				onSendQueueOverflow();
+				return;
+			}
+			reduceSendQueue();
+		}
 	}
 	if(!isOpen()) {
 		nError() << "write data error, socket is not open!";
@@ -133,65 +228,144 @@ void RpcDriver::enqueueDataToSend(RpcDriver::MessageData &&chunk_to_enqueue)
 	unlockSendQueueGuard();
 }
 
+bool RpcDriver::isSendQueueOverHighWatermark() const
+{
+	return (m_sendQueueLimits.highWatermarkBytes > 0 && m_sendQueueBytes > m_sendQueueLimits.highWatermarkBytes)
+			|| (m_sendQueueLimits.highWatermarkMessages > 0 && m_sendQueue.size() > m_sendQueueLimits.highWatermarkMessages);
+}
+
+void RpcDriver::reduceSendQueue()
+{
+	const size_t orig_len = m_sendQueue.size();
+	const size_t orig_bytes = m_sendQueueBytes;
+	// partially written message cannot be removed
+	const size_t first_removable = isTopMessageStarted()? 1: 0;
+	size_t queue_len = m_sendQueue.size();
+	auto is_over_low_watermark = [this, &queue_len]() {
+		return (m_sendQueueLimits.highWatermarkBytes > 0 && m_sendQueueBytes > m_sendQueueLimits.lowWatermarkBytes)
+				|| (m_sendQueueLimits.highWatermarkMessages > 0 && queue_len > m_sendQueueLimits.lowWatermarkMessages);
+	};
+	std::vector<bool> removed(m_sendQueue.size(), false);
+	if(m_sendQueueLimits.overflowPolicy == SendQueueOverflowPolicy::CoalesceSignals) {
+		// keep the latest signal for every coalesce key
+		std::set<std::string> keys;
+		for(size_t i = m_sendQueue.size(); i > first_removable; i--) {
+			const MessageData &chunk = m_sendQueue[i - 1];
+			if(!chunk.coalesceMethod || keys.insert(chunk.coalesceMethod + (':' + chunk.coalescePath.asString())).second)
+				continue;
+			removed[i - 1] = true;
+			m_sendQueueBytes -= chunk.size();
+			queue_len--;
+			m_writeStats.coalescedMessages++;
+		}
+	}
+	for(size_t i = first_removable; i < m_sendQueue.size() && is_over_low_watermark(); i++) {
+		const MessageData &chunk = m_sendQueue[i];
+		if(removed[i] || !chunk.isSignal)
+			continue;
+		removed[i] = true;
+		m_sendQueueBytes -= chunk.size();
+		queue_len--;
+		m_writeStats.droppedMessages++;
+	}
+	if(queue_len == orig_len) {
+		logWriteQueueW() << "send queue overflow, len:" << orig_len << "bytes:" << orig_bytes << "no signal to drop";
+		return;
+	}
+	std::deque<MessageData> queue;
+	for(size_t i = 0; i < m_sendQueue.size(); i++) {
+		if(!removed[i])
+			queue.push_back(std::move(m_sendQueue[i]));
+	}
+	m_sendQueue.swap(queue);
+	logWriteQueueW() << "send queue overflow, len:" << orig_len << "bytes:" << orig_bytes
+					 << "reduced to len:" << m_sendQueue.size() << "bytes:" << m_sendQueueBytes
+					 << "policy:" << sendQueueOverflowPolicyToString(m_sendQueueLimits.overflowPolicy);
+}
+
+namespace {
+/// frame header is chainpack packed length of protocol type + data followed by protocol type
+size_t pack_frame_header(char *buff, size_t buff_len, size_t data_len, Rpc::ProtocolType protocol_type)
+{
+	ccpcp_pack_context ctx;
+	ccpcp_pack_context_init(&ctx, buff, buff_len, nullptr);
+	// protocol type is always packed to single byte
+	cchainpack_pack_uint_data(&ctx, data_len + 1);
+	cchainpack_pack_uint_data(&ctx, static_cast<unsigned>(protocol_type));
+	if(ctx.err_no != CCPCP_RC_OK)
+		SHVCHP_EXCEPTION("Design error! Frame header buffer overflow");
+	return static_cast<size_t>(ctx.current - ctx.start);
+}
+}
+
 void RpcDriver::writeQueue()
 {
 	if(m_sendQueue.empty())
 		return;
 	logWriteQueue() << "writeQueue(), queue len:" << m_sendQueue.size();
-	//static int hi_cnt = 0;
-	const MessageData &chunk = m_sendQueue[0];
-	//nInfo() << "M:" << chunk.metaData;
-	//nInfo() << "D:" << chunk.data;
-	if(!m_topMessageDataHeaderWritten) {
-		writeMessageBegin();
-		std::string protocol_type_data;
-		{
-			std::ostringstream os;
-			{ ChainPackWriter wr(os); wr.writeUIntData((unsigned)protocolType());}
-			protocol_type_data = os.str();
-		}
-		{
-			std::ostringstream os;
-			{ ChainPackWriter wr(os); wr.writeUIntData(chunk.size() + protocol_type_data.length()); }
-			std::string packet_len_data = os.str();
-			auto len = writeBytes(packet_len_data.data(), packet_len_data.length());
-			if(len < 0)
-				SHVCHP_EXCEPTION("Write socket error!");
-			if(len < (int)packet_len_data.length())
-				SHVCHP_EXCEPTION("Design error! Chunk length shall be always written at once to the socket");
-		}
-		{
-			auto len = writeBytes(protocol_type_data.data(), protocol_type_data.length());
+	// write queued messages until socket stops accepting data or batch budget is spent, then flush them at once,
+	// rest of the queue is written when socket reports written data
+	// message is never split by batch budget, socket wrappers like WebSocket need whole message to send it
+	uint64_t bytes_written = 0;
+	while(!m_sendQueue.empty()) {
+		if(!isTopMessageStarted() && s_writeBatchMaxBytes > 0 && bytes_written >= s_writeBatchMaxBytes)
+			break;
+		const MessageData &chunk = m_sendQueue[0];
+		if(!m_topMessageDataHeaderWritten) {
+			if(m_topMessageHeaderBytesWrittenSoFar == 0) {
+				writeMessageBegin();
+				m_topMessageHeaderLength = pack_frame_header(m_topMessageHeader, sizeof(m_topMessageHeader), chunk.size(), protocolType());
+			}
+			auto len = writeBytes(m_topMessageHeader + m_topMessageHeaderBytesWrittenSoFar, m_topMessageHeaderLength - m_topMessageHeaderBytesWrittenSoFar);
 			logWriteQueue() << "\twrite header len:" << len;
 			if(len < 0)
 				SHVCHP_EXCEPTION("Write socket error!");
-			if(len != 1)
-				SHVCHP_EXCEPTION("Design error! Protocol version shall be always written at once to the socket");
+			if(len == 0)
+				break;
+			m_topMessageHeaderBytesWrittenSoFar += static_cast<size_t>(len);
+			bytes_written += static_cast<uint64_t>(len);
+			if(m_topMessageHeaderBytesWrittenSoFar < m_topMessageHeaderLength) {
+				// socket accepted part of header only, rest of it is written on next write
+				break;
+			}
+			m_topMessageHeaderBytesWrittenSoFar = 0;
+			m_topMessageDataHeaderWritten = true;
+		}
+		if(m_topMessageDataBytesWrittenSoFar < chunk.metaData.size()) {
+			auto len = writeBytes_helper(chunk.metaData, m_topMessageDataBytesWrittenSoFar, chunk.metaData.size() - m_topMessageDataBytesWrittenSoFar);
+			logWriteQueue() << "\twrite metadata len:" << len;
+			m_topMessageDataBytesWrittenSoFar += len;
+			bytes_written += static_cast<uint64_t>(len);
+		}
+		if(m_topMessageDataBytesWrittenSoFar >= chunk.metaData.size() && m_topMessageDataBytesWrittenSoFar < chunk.size()) {
+			const std::string &payload = chunk.payload();
+			auto len = writeBytes_helper(payload
+										 , m_topMessageDataBytesWrittenSoFar - chunk.metaData.size()
+										 , payload.size() - (m_topMessageDataBytesWrittenSoFar - chunk.metaData.size()));
+			logWriteQueue() << "\twrite data len:" << len;
+			m_topMessageDataBytesWrittenSoFar += len;
+			bytes_written += static_cast<uint64_t>(len);
+		}
+		logWriteQueue() << "----- bytes written so far:" << m_topMessageDataBytesWrittenSoFar
+						<< "remaining:" << (chunk.size() - m_topMessageDataBytesWrittenSoFar)
+						<< "queue len:" << m_sendQueue.size();
+		if(m_topMessageDataBytesWrittenSoFar < chunk.size()) {
+			// socket write buffer is full, continue on next write
+			break;
 		}
-		m_topMessageDataHeaderWritten = true;
-	}
-	if(m_topMessageDataBytesWrittenSoFar < chunk.metaData.size()) {
-		auto len = writeBytes_helper(chunk.metaData, m_topMessageDataBytesWrittenSoFar, chunk.metaData.size() - m_topMessageDataBytesWrittenSoFar);
-		logWriteQueue() << "\twrite metadata len:" << len;
-		m_topMessageDataBytesWrittenSoFar += len;
-	}
-	if(m_topMessageDataBytesWrittenSoFar >= chunk.metaData.size()) {
-		auto len = writeBytes_helper(chunk.data
-									 , m_topMessageDataBytesWrittenSoFar - chunk.metaData.size()
-									 , chunk.data.size() - (m_topMessageDataBytesWrittenSoFar - chunk.metaData.size()));
-		logWriteQueue() << "\twrite data len:" << len;
-		m_topMessageDataBytesWrittenSoFar += len;
-	}
-	logWriteQueue() << "----- bytes written so far:" << m_topMessageDataBytesWrittenSoFar
-					<< "remaining:" << (chunk.size() - m_topMessageDataBytesWrittenSoFar)
-					<< "queue len:" << m_sendQueue.size();
-	if(m_topMessageDataBytesWrittenSoFar == chunk.size()) {
 		m_topMessageDataHeaderWritten = false;
 		m_topMessageDataBytesWrittenSoFar = 0;
+		m_sendQueueBytes -= chunk.size();
 		m_sendQueue.pop_front();
 		writeMessageEnd();
+		m_writeStats.messagesWritten++;
 		logWriteQueue() << "<=========== write chunk finished, new queue len:" << m_sendQueue.size();
 	}
+	if(bytes_written > 0) {
+		m_writeStats.writeCount++;
+		m_writeStats.bytesWritten += bytes_written;
+		flush();
+	}
 }
 
 int64_t RpcDriver::writeBytes_helper(const std::string &str, size_t from, size_t length)
@@ -201,89 +375,77 @@ int64_t RpcDriver::writeBytes_helper(const std::string &str, size_t from, size_t
 	auto len = writeBytes(str.data() + from, length);
 	if(len < 0)
 		SHVCHP_EXCEPTION("Write socket error!");
-	if(len == 0)
-		SHVCHP_EXCEPTION("Design error! At least 1 byte of data shall be always written to the socket");
 	return len;
 }
 
 void RpcDriver::onBytesRead(std::string &&bytes)
 {
 	logRpcData().nospace() << __FUNCTION__ << " " << bytes.length() << " bytes of data read:\n" << shv::chainpack::Utils::hexDump(bytes);
-	m_readData += std::string(std::move(bytes));
-	while(true) {
-		auto old_len = m_readData.size();
-		processReadData();
-		if(old_len == m_readData.size())
-			break;
-	}
+	m_frameReader.addData(std::move(bytes));
+	processReadData();
 }
 
 void RpcDriver::clearBuffers()
+{
+	clearSendQueue();
+	m_frameReader.clear();
+}
+
+void RpcDriver::clearSendQueue()
 {
 	m_sendQueue.clear();
+	m_sendQueueBytes = 0;
 	m_topMessageDataHeaderWritten = false;
+	m_topMessageHeaderBytesWrittenSoFar = 0;
 	m_topMessageDataBytesWrittenSoFar = 0;
-	m_readData.clear();
 }
 
 void RpcDriver::processReadData()
 {
-	const std::string &read_data = m_readData;
-	logRpcData() << __FUNCTION__ << "data len:" << read_data.length();
-
-	using namespace shv::chainpack;
-
-	std::istringstream in(read_data);
+	logRpcData() << __FUNCTION__ << "data len:" << m_frameReader.bufferedSize();
 
-	bool ok;
-	uint64_t chunk_len = ChainPackReader::readUIntData(in, &ok);
-	if(!ok)
-		return;
-
-	size_t read_len = (size_t)in.tellg() + chunk_len;
-
-	Rpc::ProtocolType protocol_type = (Rpc::ProtocolType)ChainPackReader::readUIntData(in, &ok);
-	if(!ok)
-		return;
+	RpcFrameReader::Frame frame;
+	while(m_frameReader.readFrame(frame)) {
+		logRpcData() << "\t message data length:" << frame.size << "remaining buffered data length:" << m_frameReader.bufferedSize();
 
-	logRpcData() << "\t expected message data length:" << read_len << "length available:" << read_data.size();
-	if(read_len > read_data.length())
-		return;
-
-	if(in.tellg() < 0)
-		return;
-
-	if(m_protocolType == Rpc::ProtocolType::Invalid && protocol_type != Rpc::ProtocolType::Invalid) {
-		// if protocol version is not explicitly specified,
-		// it is set from first received message
-		m_protocolType = protocol_type;
-	}
+		if(m_protocolType == Rpc::ProtocolType::Invalid && frame.protocolType != Rpc::ProtocolType::Invalid) {
+			// if protocol version is not explicitly specified,
+			// it is set from first received message
+			m_protocolType = frame.protocolType;
+		}
 
-	try {
-		RpcValue::MetaData meta_data;
-		size_t meta_data_end_pos = decodeMetaData(meta_data, protocol_type, read_data, in.tellg());
-		if(meta_data_end_pos > read_len)
-			throw std::runtime_error("Data header corrupted");
-		std::string msg_data = read_data.substr(meta_data_end_pos, read_len - meta_data_end_pos);
-		logRpcData() << read_len << "bytes of" << m_readData.size() << "processed";
-		m_readData = m_readData.substr(read_len);
-		onRpcDataReceived(protocol_type, std::move(meta_data), std::move(msg_data));
-	}
-	catch (std::exception &e) {
-		nError() << "processReadData error:" << e.what();
-		onProcessReadDataException(e);
+		try {
+			RpcValue::MetaData meta_data;
+			size_t meta_data_end_pos = decodeMetaData(meta_data, frame.protocolType, frame.data, frame.size);
+			if(meta_data_end_pos > frame.size)
+				throw std::runtime_error("Data header corrupted");
+			// frame view is valid till next onBytesRead() call,
+			// copy message data before the message is dispatched
+			std::string msg_data(frame.data + meta_data_end_pos, frame.size - meta_data_end_pos);
+			onRpcDataReceived(frame.protocolType, std::move(meta_data), std::move(msg_data));
+		}
+		catch (std::exception &e) {
+			nError() << "processReadData error:" << e.what();
+			onProcessReadDataException(e);
+			return;
+		}
 	}
 }
 
 size_t RpcDriver::decodeMetaData(RpcValue::MetaData &meta_data, Rpc::ProtocolType protocol_type, const std::string &data, size_t start_pos)
 {
-	size_t meta_data_end_pos = start_pos;
-	std::istringstream in(data);
-	in.seekg(start_pos);
+	if(start_pos > data.size())
+		SHVCHP_EXCEPTION("Invalid meta data start position: " + Utils::toString(start_pos));
+	return start_pos + decodeMetaData(meta_data, protocol_type, data.data() + start_pos, data.size() - start_pos);
+}
+
+size_t RpcDriver::decodeMetaData(RpcValue::MetaData &meta_data, Rpc::ProtocolType protocol_type, const char *data, size_t data_len)
+{
+	size_t meta_data_end_pos = 0;
 
 	switch (protocol_type) {
 	case Rpc::ProtocolType::JsonRpc: {
-		CponReader rd(in);
+		CponReader rd(data, data_len);
 		RpcValue msg;
 		rd.read(msg);
 		if(!msg.isMap()) {
@@ -307,15 +469,15 @@ size_t RpcDriver::decodeMetaData(RpcValue::MetaData &meta_data, Rpc::ProtocolTyp
 		break;
 	}
 	case Rpc::ProtocolType::Cpon: {
-		CponReader rd(in);
+		CponReader rd(data, data_len);
 		rd.read(meta_data);
-		meta_data_end_pos = (in.tellg() < 0)? data.size(): (size_t)in.tellg();
+		meta_data_end_pos = static_cast<size_t>(rd.readPos());
 		break;
 	}
 	case Rpc::ProtocolType::ChainPack: {
-		ChainPackReader rd(in);
+		ChainPackReader rd(data, data_len);
 		rd.read(meta_data);
-		meta_data_end_pos = (in.tellg() < 0)? data.size(): (size_t)in.tellg();
+		meta_data_end_pos = static_cast<size_t>(rd.readPos());
 		break;
 	}
 	default:
@@ -329,14 +491,21 @@ size_t RpcDriver::decodeMetaData(RpcValue::MetaData &meta_data, Rpc::ProtocolTyp
 }
 
 RpcValue RpcDriver::decodeData(Rpc::ProtocolType protocol_type, const std::string &data, size_t start_pos)
+{
+	if(start_pos > data.size()) {
+		nError() << Rpc::protocolTypeToString(protocol_type) << "Decode data error, invalid start position:" << start_pos;
+		return RpcValue();
+	}
+	return decodeData(protocol_type, data.data() + start_pos, data.size() - start_pos);
+}
+
+RpcValue RpcDriver::decodeData(Rpc::ProtocolType protocol_type, const char *data, size_t data_len)
 {
 	RpcValue ret;
-	std::istringstream in(data);
-	in.seekg(start_pos);
 	try {
 		switch (protocol_type) {
 		case Rpc::ProtocolType::JsonRpc: {
-			CponReader rd(in);
+			CponReader rd(data, data_len);
 			rd.read(ret);
 			RpcValue::Map map = ret.toMap();
 			RpcValue::IMap imap;
@@ -359,12 +528,17 @@ RpcValue RpcDriver::decodeData(Rpc::ProtocolType protocol_type, const std::strin
 			break;
 		}
 		case Rpc::ProtocolType::Cpon: {
-			CponReader rd(in);
+			CponReader rd(data, data_len);
 			rd.read(ret);
 			break;
 		}
 		case Rpc::ProtocolType::ChainPack: {
-			ChainPackReader rd(in);
+			ChainPackReader rd(data, data_len);
+			if(s_decodeArenaMinDataSize > 0 && data_len >= s_decodeArenaMinDataSize) {
+				// only strings and containers are allocated from arena, their count is not known in advance,
+				// so arena grows in chunks instead of reserving memory according to data size
+				rd.setArena(std::make_shared<RpcValueArena>());
+			}
 			rd.read(ret);
 			break;
 		}
@@ -375,15 +549,17 @@ RpcValue RpcDriver::decodeData(Rpc::ProtocolType protocol_type, const std::strin
 	}
 	catch(AbstractStreamReader::ParseException &e) {
 		nError() << Rpc::protocolTypeToString(protocol_type) << "Decode data error:" << e.msg();
-		std::string data_piece = data.substr(e.pos() - 10*16, 20*16);
-		nError().nospace() << "Start offset: " << start_pos << " Data: from pos:" << (e.pos() - 10*16) << "\n" << shv::chainpack::Utils::hexDump(data_piece);
+		size_t err_pos = (e.pos() < 0)? 0: std::min(static_cast<size_t>(e.pos()), data_len);
+		size_t piece_start = (err_pos > 10*16)? err_pos - 10*16: 0;
+		std::string data_piece(data + piece_start, std::min<size_t>(20*16, data_len - piece_start));
+		nError().nospace() << "Data: from pos:" << piece_start << "\n" << shv::chainpack::Utils::hexDump(data_piece);
 	}
 	return ret;
 }
 
 std::string RpcDriver::codeRpcValue(Rpc::ProtocolType protocol_type, const RpcValue &val)
 {
-	std::ostringstream os_packed_data;
+	std::string packed_data;
 	switch (protocol_type) {
 	case Rpc::ProtocolType::JsonRpc: {
 		RpcValue::Map json_msg;
@@ -418,30 +594,40 @@ std::string RpcDriver::codeRpcValue(Rpc::ProtocolType protocol_type, const RpcVa
 		}
 		CponWriterOptions opts;
 		opts.setJsonFormat(true);
-		CponWriter wr(os_packed_data, opts);
+		CponWriter wr(packed_data, opts);
 		wr.write(json_msg);
 		break;
 	}
 	case Rpc::ProtocolType::Cpon: {
-		CponWriter wr(os_packed_data);
+		CponWriter wr(packed_data);
 		wr << val;
 		break;
 	}
 	case Rpc::ProtocolType::ChainPack: {
-		ChainPackWriter wr(os_packed_data);
+		ChainPackWriter wr(packed_data);
 		wr << val;
 		break;
 	}
 	default:
 		SHVCHP_EXCEPTION("Cannot serialize data without protocol version specified.");
 	}
-	return os_packed_data.str();
+	return packed_data;
 }
 
 void RpcDriver::onRpcDataReceived(Rpc::ProtocolType protocol_type, RpcValue::MetaData &&md, std::string &&data)
 {
 	//nInfo() << __FILE__ << RCV_LOG_ARROW << md.toStdString() << shv::chainpack::Utils::toHexElided(data, start_pos, 100);
-	RpcValue msg = decodeData(protocol_type, data, 0);
+	RpcValue msg;
+	if(protocol_type == Rpc::ProtocolType::ChainPack && s_lazyDecodeMinDataSize > 0 && data.size() >= s_lazyDecodeMinDataSize) {
+		// big messages are often forwarded untouched, decode only parts accessed
+		std::string err;
+		msg = RpcValue::fromRawChainPack(std::make_shared<const std::string>(std::move(data)), &err);
+		if(!err.empty())
+			nError() << Rpc::protocolTypeToString(protocol_type) << "Decode data error:" << err;
+	}
+	else {
+		msg = decodeData(protocol_type, data, 0);
+	}
 	if(msg.isValid()) {
 		msg.setMetaData(std::move(md));
 		logRpcRawMsg() << RCV_LOG_ARROW << msg.toPrettyString();
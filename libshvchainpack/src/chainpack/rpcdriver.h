@@ -2,11 +2,14 @@
 
 #include "../shvchainpackglobal.h"
 #include "rpcmessage.h"
+#include "rpcframereader.h"
 #include "rpc.h"
 
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <deque>
+#include <memory>
 #include <map>
 
 namespace shv {
@@ -27,32 +30,97 @@ public:
 	void sendRpcValue(const RpcValue &msg);
 	void sendRawData(std::string &&data);
 	virtual void sendRawData(const RpcValue::MetaData &meta_data, std::string &&data);
+	/// data can be shared by more connections, only meta data are packed per connection
+	virtual void sendRawData(const RpcValue::MetaData &meta_data, const std::shared_ptr<const std::string> &data);
 	using MessageReceivedCallback = std::function< void (const RpcValue &msg)>;
 	void setMessageReceivedCallback(const MessageReceivedCallback &callback) {m_messageReceivedCallback = callback;}
 
 	static int defaultRpcTimeoutMsec() {return s_defaultRpcTimeoutMsec;}
 	static void setDefaultRpcTimeoutMsec(int msec) {s_defaultRpcTimeoutMsec = msec;}
 
+	/// ChainPack messages with data of this size or bigger are decoded into per message RpcValueArena,
+	/// it applies also to the lazily decoded raw values when they are decoded as whole, 0 disables arena decoding
+	static size_t decodeArenaMinDataSize() {return s_decodeArenaMinDataSize;}
+	static void setDecodeArenaMinDataSize(size_t size) {s_decodeArenaMinDataSize = size;}
+	/// received ChainPack messages with data of this size or bigger are not decoded,
+	/// they are wrapped by lazily decoded raw RpcValue instead, 0 disables lazy decoding
+	static size_t lazyDecodeMinDataSize() {return s_lazyDecodeMinDataSize;}
+	static void setLazyDecodeMinDataSize(size_t size) {s_lazyDecodeMinDataSize = size;}
+
+	/// number of bytes after which single send queue write stops at next message boundary, 0 means unlimited
+	/// a batch is written when a message is sent or when socket reports written data,
+	/// so slow peer does not get whole send queue pushed to socket buffers at once
+	static size_t writeBatchMaxBytes() {return s_writeBatchMaxBytes;}
+	static void setWriteBatchMaxBytes(size_t size) {s_writeBatchMaxBytes = size;}
+
 	static RpcMessage composeRpcMessage(RpcValue::MetaData &&meta_data, const std::string &data, std::string *errmsg = nullptr);
 
 	static size_t decodeMetaData(RpcValue::MetaData &meta_data, Rpc::ProtocolType protocol_type, const std::string &data, size_t start_pos);
+	/// returns meta data end position relative to data
+	static size_t decodeMetaData(RpcValue::MetaData &meta_data, Rpc::ProtocolType protocol_type, const char *data, size_t data_len);
 	static RpcValue decodeData(Rpc::ProtocolType protocol_type, const std::string &data, size_t start_pos);
+	static RpcValue decodeData(Rpc::ProtocolType protocol_type, const char *data, size_t data_len);
 	static std::string codeRpcValue(Rpc::ProtocolType protocol_type, const RpcValue &val);
 
 	static std::string dataToPrettyCpon(shv::chainpack::Rpc::ProtocolType protocol_type, const shv::chainpack::RpcValue::MetaData &md, const std::string &data, size_t start_pos = 0, size_t data_len = 0);
+
+	struct WriteStats
+	{
+		/// number of send queue writes, messages accepted by socket are written at once up to writeBatchMaxBytes()
+		uint64_t writeCount = 0;
+		uint64_t bytesWritten = 0;
+		uint64_t messagesWritten = 0;
+		/// signals removed from send queue on overflow
+		uint64_t droppedMessages = 0;
+		/// signals replaced by newer signal with the same path in send queue
+		uint64_t coalescedMessages = 0;
+	};
+	const WriteStats& writeStats() const {return m_writeStats;}
+	size_t sendQueueLength() const {return m_sendQueue.size();}
+	size_t sendQueueBytes() const {return m_sendQueueBytes;}
+
+	enum class SendQueueOverflowPolicy {DropOldestSignals, CoalesceSignals, Disconnect};
+	/// send queue is reduced below low watermark when any high watermark is exceeded,
+	/// only signals can be removed from the queue, requests and responses are never dropped
+	struct SendQueueLimits
+	{
+		/// 0 means unlimited
+		size_t highWatermarkBytes = 0;
+		size_t highWatermarkMessages = 0;
+		/// 0 means half of high watermark
+		size_t lowWatermarkBytes = 0;
+		size_t lowWatermarkMessages = 0;
+		SendQueueOverflowPolicy overflowPolicy = SendQueueOverflowPolicy::DropOldestSignals;
+
+		bool isValid() const {return highWatermarkBytes > 0 || highWatermarkMessages > 0;}
+	};
+	const SendQueueLimits& sendQueueLimits() const {return m_sendQueueLimits;}
+	void setSendQueueLimits(const SendQueueLimits &limits);
+	static const char* sendQueueOverflowPolicyToString(SendQueueOverflowPolicy policy);
+	static SendQueueOverflowPolicy sendQueueOverflowPolicyFromString(const std::string &s, bool *ok = nullptr);
 protected:
 	struct MessageData
 	{
 		std::string metaData;
 		std::string data;
+		/// immutable data shared with messages enqueued to other connections, used instead of data if set
+		std::shared_ptr<const std::string> sharedData;
+		/// signal can be dropped on send queue overflow
+		bool isSignal = false;
+		/// chng or fchng signals with the same method and path can be coalesced on send queue overflow,
+		/// method points to Rpc constant, path value is shared with message meta data
+		const char *coalesceMethod = nullptr;
+		RpcValue coalescePath;
 
 		MessageData() {}
 		MessageData(std::string &&meta_data, std::string &&data) : metaData(std::move(meta_data)), data(std::move(data)) {}
+		MessageData(std::string &&meta_data, const std::shared_ptr<const std::string> &shared_data) : metaData(std::move(meta_data)), sharedData(shared_data) {}
 		MessageData(std::string &&data) : data(std::move(data)) {}
 		MessageData(MessageData &&) = default;
 
-		bool empty() const {return metaData.empty() && data.empty();}
-		size_t size() const {return metaData.size() + data.size();}
+		const std::string& payload() const {return sharedData? *sharedData: data;}
+		bool empty() const {return metaData.empty() && payload().empty();}
+		size_t size() const {return metaData.size() + payload().size();}
 	};
 protected:
 	virtual bool isOpen() = 0;
@@ -63,13 +131,13 @@ protected:
 	/// data should be flushed in derived class implementation
 	virtual void writeMessageEnd() = 0;
 	/// write bytes to write buffer (and possibly to socket)
-	/// @return number of writen bytes
+	/// @return number of writen bytes, 0 if write buffer is full
 	virtual int64_t writeBytes(const char *bytes, size_t length) = 0;
 	/// call it when new data arrived
 	virtual void onBytesRead(std::string &&bytes);
-	/// flush write buffer to socket
+	/// flush write buffer to socket, called once after all the messages accepted by writeBytes() are written
 	/// @return true if write buffer length has changed (some data was written to the socket)
-	//virtual bool flush() = 0;
+	virtual bool flush() {return false;}
 
 	virtual void clearBuffers();
 
@@ -79,6 +147,9 @@ protected:
 	virtual void onRpcDataReceived(Rpc::ProtocolType protocol_type, RpcValue::MetaData &&md, std::string &&data);
 	virtual void onRpcValueReceived(const RpcValue &msg);
 	virtual void onProcessReadDataException(std::exception &e) = 0;
+	/// called when send queue exceeds high watermark and overflow policy is Disconnect,
+	/// connection should be closed, send queue is cleared already
+	virtual void onSendQueueOverflow() {}
 
 	void lockSendQueueGuard();
 	void unlockSendQueueGuard();
@@ -86,14 +157,34 @@ private:
 	void processReadData();
 	void writeQueue();
 	int64_t writeBytes_helper(const std::string &str, size_t from, size_t length);
+	static std::string codeMetaData(Rpc::ProtocolType protocol_type, const RpcValue::MetaData &meta_data);
+	bool isRawDataRecodingNeeded(const RpcValue::MetaData &meta_data) const;
+	MessageData recodeRawData(const RpcValue::MetaData &meta_data, const std::string &data) const;
+	void setSignalInfo(MessageData &chunk, const RpcValue::MetaData &meta_data) const;
+	bool isSendQueueOverHighWatermark() const;
+	void reduceSendQueue();
+	/// clears send queue only, read buffer is kept
+	void clearSendQueue();
+	/// top message is partially written, it cannot be removed from queue and batch cannot end before it is finished
+	bool isTopMessageStarted() const {return m_topMessageDataHeaderWritten || m_topMessageHeaderBytesWrittenSoFar > 0;}
 private:
 	MessageReceivedCallback m_messageReceivedCallback = nullptr;
 	std::deque<MessageData> m_sendQueue;
 	bool m_topMessageDataHeaderWritten = false;
+	/// frame header of top message, it is kept till it is written completely, socket can accept part of it only
+	char m_topMessageHeader[2 * 10];
+	size_t m_topMessageHeaderLength = 0;
+	size_t m_topMessageHeaderBytesWrittenSoFar = 0;
 	size_t m_topMessageDataBytesWrittenSoFar = 0;
-	std::string m_readData;
+	size_t m_sendQueueBytes = 0;
+	SendQueueLimits m_sendQueueLimits;
+	WriteStats m_writeStats;
+	RpcFrameReader m_frameReader;
 	Rpc::ProtocolType m_protocolType = Rpc::ProtocolType::Invalid;
 	static int s_defaultRpcTimeoutMsec;
+	static size_t s_decodeArenaMinDataSize;
+	static size_t s_lazyDecodeMinDataSize;
+	static size_t s_writeBatchMaxBytes;
 };
 
 } // namespace chainpack
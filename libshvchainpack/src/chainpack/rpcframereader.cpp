@@ -0,0 +1,68 @@
+#include "rpcframereader.h"
+
+#include "../../c/cchainpack.h"
+
+namespace shv {
+namespace chainpack {
+
+void RpcFrameReader::addData(const char *data, size_t length)
+{
+	compact();
+	m_buffer.append(data, length);
+}
+
+void RpcFrameReader::addData(std::string &&data)
+{
+	compact();
+	if(m_buffer.empty())
+		m_buffer = std::move(data);
+	else
+		m_buffer.append(data);
+}
+
+bool RpcFrameReader::readFrame(RpcFrameReader::Frame &frame)
+{
+	const char *buff_start = m_buffer.data() + m_readPos;
+	const size_t buff_len = bufferedSize();
+	if(buff_len == 0)
+		return false;
+
+	ccpcp_unpack_context ctx;
+	ccpcp_unpack_context_init(&ctx, buff_start, buff_len, nullptr, nullptr);
+
+	bool ok;
+	uint64_t frame_len = cchainpack_unpack_uint_data(&ctx, &ok);
+	if(!ok)
+		return false;
+	if(frame_len > (uint64_t)(ctx.end - ctx.current))
+		return false;
+	const char *frame_end = ctx.current + frame_len;
+
+	// protocol type is not known if it cannot be decoded inside of frame,
+	// the frame is returned anyway to let the caller handle the error
+	ctx.end = frame_end;
+	auto protocol_type = (Rpc::ProtocolType)cchainpack_unpack_uint_data(&ctx, &ok);
+	frame.protocolType = ok? protocol_type: Rpc::ProtocolType::Invalid;
+	frame.data = ok? ctx.current: frame_end;
+	frame.size = static_cast<size_t>(frame_end - frame.data);
+
+	m_readPos += static_cast<size_t>(frame_end - buff_start);
+	return true;
+}
+
+void RpcFrameReader::clear()
+{
+	m_buffer.clear();
+	m_readPos = 0;
+}
+
+void RpcFrameReader::compact()
+{
+	if(m_readPos == 0)
+		return;
+	m_buffer.erase(0, m_readPos);
+	m_readPos = 0;
+}
+
+} // namespace chainpack
+} // namespace shv
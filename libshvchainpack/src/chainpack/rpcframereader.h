@@ -0,0 +1,47 @@
+#pragma once
+
+#include "../shvchainpackglobal.h"
+#include "rpc.h"
+
+#include <string>
+
+namespace shv {
+namespace chainpack {
+
+/// Incremental parser of the RPC byte stream.
+///
+/// Received bytes are appended to the read buffer, complete frames are returned
+/// as views into it. Consumed bytes are discarded only when new data arrives,
+/// so the cost of framing is linear in the number of received bytes
+/// regardless of how many frames are queued in the buffer.
+class SHVCHAINPACK_DECL_EXPORT RpcFrameReader
+{
+public:
+	struct Frame
+	{
+		Rpc::ProtocolType protocolType = Rpc::ProtocolType::Invalid;
+		/// frame payload, meta data followed by data
+		/// valid till next addData() or clear() call
+		const char *data = nullptr;
+		size_t size = 0;
+	};
+public:
+	void addData(const char *data, size_t length);
+	void addData(std::string &&data);
+
+	/// read next complete frame and move read cursor behind it
+	/// @return false if the buffer does not contain complete frame
+	bool readFrame(Frame &frame);
+	void clear();
+
+	size_t bufferedSize() const {return m_buffer.size() - m_readPos;}
+	bool isEmpty() const {return bufferedSize() == 0;}
+private:
+	void compact();
+private:
+	std::string m_buffer;
+	size_t m_readPos = 0;
+};
+
+} // namespace chainpack
+} // namespace shv
@@ -4,10 +4,13 @@
 #include "cponreader.h"
 #include "chainpackwriter.h"
 #include "chainpackreader.h"
+#include "rpcvaluearena.h"
+#include "rpcdriver.h"
 #include "exception.h"
 #include "utils.h"
 
 #include "../../c/ccpon.h"
+#include "../../c/cchainpack.h"
 
 #include <necrolog.h>
 
@@ -18,6 +21,9 @@
 #include <sstream>
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 
 #ifdef DEBUG_RPCVAL
 #define logDebugRpcVal nWarning
@@ -109,6 +115,9 @@ public:
 	virtual void stripMeta() = 0;
 
 	virtual AbstractValueData* copy() = 0;
+
+	virtual bool isRawChainPack() const {return false;}
+	virtual std::pair<const char*, size_t> rawChainPackData() const {return {nullptr, 0};}
 };
 
 //==============================================
@@ -136,7 +145,13 @@ protected:
 		logDebugRpcVal() << "+++" << ++value_data_cnt << RpcValue::typeToName(tag) << this << value;
 #endif
 	}
-	//explicit ValueData(T &&value) : m_value(std::move(value)) {}
+	explicit ValueData(T &&value)
+		: m_value(std::move(value))
+	{
+#ifdef DEBUG_RPCVAL
+		logDebugRpcVal() << "+++" << ++value_data_cnt << RpcValue::typeToName(tag) << this << m_value;
+#endif
+	}
 	// disable copy (because of m_metaData)
 	ValueData(const ValueData &o) = delete;
 	ValueData& operator=(const ValueData &o) = delete;
@@ -345,7 +360,7 @@ class ChainPackList final : public ValueData<RpcValue::Type::List, RpcValue::Lis
 	bool equals(const RpcValue::AbstractValueData * other) const override { return m_value == other->asList(); }
 public:
 	explicit ChainPackList(const RpcValue::List &value) : ValueData(value) {}
-	explicit ChainPackList(RpcValue::List &&value) : ValueData(move(value)) {}
+	explicit ChainPackList(RpcValue::List &&value) : ValueData(std::move(value)) {}
 
 	const RpcValue::List &asList() const override { return m_value; }
 };
@@ -388,7 +403,7 @@ class ChainPackMap final : public ValueData<RpcValue::Type::Map, RpcValue::Map>
 	bool equals(const RpcValue::AbstractValueData * other) const override { return m_value == other->asMap(); }
 public:
 	explicit ChainPackMap(const RpcValue::Map &value) : ValueData(value) {}
-	explicit ChainPackMap(RpcValue::Map &&value) : ValueData(move(value)) {}
+	explicit ChainPackMap(RpcValue::Map &&value) : ValueData(std::move(value)) {}
 
 	const RpcValue::Map &asMap() const override { return m_value; }
 };
@@ -421,6 +436,228 @@ public:
 	ChainPackNull() : ValueData({}) {}
 };
 
+//==============================================
+// lazily decoded ChainPack data
+//==============================================
+class ChainPackRawValue final : public RpcValue::AbstractValueData
+{
+public:
+	ChainPackRawValue(RpcValue::Type type, const std::shared_ptr<const std::string> &data, const char *begin, size_t size)
+		: m_type(type), m_data(data), m_begin(begin), m_size(size) {}
+	ChainPackRawValue(const ChainPackRawValue &o) = delete;
+	ChainPackRawValue& operator=(const ChainPackRawValue &o) = delete;
+	~ChainPackRawValue() override
+	{
+		delete m_metaData;
+	}
+
+	RpcValue::Type type() const override { return m_type; }
+
+	const RpcValue::MetaData &metaData() const override
+	{
+		static RpcValue::MetaData md;
+		if(!m_metaData)
+			return md;
+		return *m_metaData;
+	}
+	void setMetaData(RpcValue::MetaData &&d) override
+	{
+		if(m_metaData)
+			(*m_metaData) = std::move(d);
+		else
+			m_metaData = new RpcValue::MetaData(std::move(d));
+	}
+	void setMetaValue(RpcValue::Int key, const RpcValue &val) override
+	{
+		if(!m_metaData)
+			m_metaData = new RpcValue::MetaData();
+		m_metaData->setValue(key, val);
+	}
+	void setMetaValue(RpcValue::String key, const RpcValue &val) override
+	{
+		if(!m_metaData)
+			m_metaData = new RpcValue::MetaData();
+		m_metaData->setValue(key, val);
+	}
+
+	bool equals(const RpcValue::AbstractValueData *other) const override
+	{
+		switch (m_type) {
+		case RpcValue::Type::String: return asString() == other->asString();
+		case RpcValue::Type::Blob: return asBlob() == other->asBlob();
+		case RpcValue::Type::List: return asList() == other->asList();
+		case RpcValue::Type::Map: return asMap() == other->asMap();
+		case RpcValue::Type::IMap: return asIMap() == other->asIMap();
+		default: return false;
+		}
+	}
+
+	const RpcValue::String &asString() const override { return decoded().asString(); }
+	const RpcValue::Blob &asBlob() const override { return decoded().asBlob(); }
+	const RpcValue::List &asList() const override { return decoded().asList(); }
+	const RpcValue::Map &asMap() const override { return decoded().asMap(); }
+	const RpcValue::IMap &asIMap() const override { return decoded().asIMap(); }
+	size_t count() const override { return decoded().count(); }
+
+	bool has(RpcValue::Int key) const override
+	{
+		if(m_type != RpcValue::Type::IMap || m_isDecoded)
+			return decoded().has(key);
+		if(m_hasItemIndex)
+			return std::any_of(m_items.begin(), m_items.end(), [key](const Item &item) { return item.key.toInt() == key; });
+		const char *item_begin;
+		size_t item_size;
+		return findItem([key](const RpcValue &k) { return k.toInt() == key; }, item_begin, item_size);
+	}
+	bool has(const RpcValue::String &key) const override
+	{
+		if(m_type != RpcValue::Type::Map || m_isDecoded)
+			return decoded().has(key);
+		if(m_hasItemIndex)
+			return std::any_of(m_items.begin(), m_items.end(), [&key](const Item &item) { return item.key.asString() == key; });
+		const char *item_begin;
+		size_t item_size;
+		return findItem([&key](const RpcValue &k) { return k.asString() == key; }, item_begin, item_size);
+	}
+	RpcValue at(RpcValue::Int key) const override
+	{
+		if(m_isDecoded || !(m_type == RpcValue::Type::IMap || (m_type == RpcValue::Type::List && key >= 0)))
+			return decoded().at(key);
+		if(m_hasItemIndex) {
+			for(const Item &item : m_items) {
+				if(item.key.toInt() == key)
+					return RpcValue::fromRawChainPackSpan(m_data, item.begin, item.size);
+			}
+			return RpcValue();
+		}
+		const char *item_begin;
+		size_t item_size;
+		if(findItem([key](const RpcValue &k) { return k.toInt() == key; }, item_begin, item_size))
+			return RpcValue::fromRawChainPackSpan(m_data, item_begin, item_size);
+		return RpcValue();
+	}
+	RpcValue at(const RpcValue::String &key) const override
+	{
+		if(m_isDecoded || m_type != RpcValue::Type::Map)
+			return decoded().at(key);
+		if(m_hasItemIndex) {
+			for(const Item &item : m_items) {
+				if(item.key.asString() == key)
+					return RpcValue::fromRawChainPackSpan(m_data, item.begin, item.size);
+			}
+			return RpcValue();
+		}
+		const char *item_begin;
+		size_t item_size;
+		if(findItem([&key](const RpcValue &k) { return k.asString() == key; }, item_begin, item_size))
+			return RpcValue::fromRawChainPackSpan(m_data, item_begin, item_size);
+		return RpcValue();
+	}
+
+	std::string toStdString() const override { return decoded().toStdString(); }
+	void stripMeta() override
+	{
+		delete m_metaData;
+		m_metaData = nullptr;
+	}
+	AbstractValueData* copy() override
+	{
+		// packed data are immutable, they can be shared
+		ChainPackRawValue *ret = new ChainPackRawValue(m_type, m_data, m_begin, m_size);
+		ret->m_items = m_items;
+		ret->m_hasItemIndex = m_hasItemIndex;
+		if(m_metaData)
+			ret->m_metaData = m_metaData->clone();
+		return ret;
+	}
+
+	bool isRawChainPack() const override { return true; }
+	std::pair<const char*, size_t> rawChainPackData() const override { return {m_begin, m_size}; }
+
+	/// check that value starting at reader position is valid and set its size,
+	/// map items are indexed in the same pass, it is used for top level value of RPC message
+	void validate(ChainPackReader &rd)
+	{
+		const long start = rd.readPos();
+		if(m_type == RpcValue::Type::Map || m_type == RpcValue::Type::IMap) {
+			rd.unpackNext();
+			while(rd.peekNext() != CCPCP_ITEM_CONTAINER_END) {
+				Item item;
+				rd.read(item.key);
+				const long item_start = rd.readPos();
+				rd.skipValue();
+				item.begin = m_begin + (item_start - start);
+				item.size = static_cast<size_t>(rd.readPos() - item_start);
+				m_items.push_back(std::move(item));
+			}
+			rd.unpackNext();
+			m_hasItemIndex = true;
+		}
+		else {
+			rd.skipValue();
+		}
+		m_size = static_cast<size_t>(rd.readPos() - start);
+	}
+private:
+	struct Item
+	{
+		RpcValue key;
+		const char *begin;
+		size_t size;
+	};
+
+	const RpcValue& decoded() const
+	{
+		std::call_once(m_decodeOnce, [this]() {
+			ChainPackReader rd(m_begin, m_size);
+			// lazily decoded messages are big, so they use arena the same way as messages decoded immediately
+			if(RpcDriver::decodeArenaMinDataSize() > 0 && m_size >= RpcDriver::decodeArenaMinDataSize())
+				rd.setArena(std::make_shared<RpcValueArena>());
+			rd.read(m_decoded);
+			m_isDecoded = true;
+		});
+		return m_decoded;
+	}
+	/// find container item without decoding of others, list items are matched by index
+	template<typename Match>
+	bool findItem(Match match, const char *&item_begin, size_t &item_size) const
+	{
+		ChainPackReader rd(m_begin, m_size);
+		// container begin
+		rd.unpackNext();
+		for(RpcValue::Int ix = 0; rd.peekNext() != CCPCP_ITEM_CONTAINER_END; ix++) {
+			bool found;
+			if(m_type == RpcValue::Type::List) {
+				found = match(RpcValue(ix));
+			}
+			else {
+				RpcValue key;
+				rd.read(key);
+				found = match(key);
+			}
+			const long start = rd.readPos();
+			rd.skipValue();
+			if(found) {
+				item_begin = m_begin + start;
+				item_size = static_cast<size_t>(rd.readPos() - start);
+				return true;
+			}
+		}
+		return false;
+	}
+private:
+	RpcValue::Type m_type;
+	std::shared_ptr<const std::string> m_data;
+	const char *m_begin;
+	size_t m_size;
+	RpcValue::MetaData *m_metaData = nullptr;
+	mutable std::once_flag m_decodeOnce;
+	mutable std::atomic<bool> m_isDecoded{false};
+	mutable RpcValue m_decoded;
+	std::vector<Item> m_items;
+	bool m_hasItemIndex = false;
+};
+
 static const RpcValue::String & static_empty_string() { static const RpcValue::String s{}; return s; }
 static const RpcValue::Blob & static_empty_blob() { static const RpcValue::Blob s{}; return s; }
 static const RpcValue::List & static_empty_list() { static const RpcValue::List s{}; return s; }
@@ -452,15 +689,15 @@ RpcValue RpcValue::fromType(RpcValue::Type t) noexcept
 	}
 	return RpcValue();
 }
-RpcValue::RpcValue(std::nullptr_t) noexcept : m_ptr(std::make_shared<ChainPackNull>()) {}
-RpcValue::RpcValue(double value) : m_ptr(std::make_shared<ChainPackDouble>(value)) {}
-RpcValue::RpcValue(RpcValue::Decimal value) : m_ptr(std::make_shared<ChainPackDecimal>(std::move(value))) {}
-RpcValue::RpcValue(int32_t value) : m_ptr(std::make_shared<ChainPackInt>(value)) {}
-RpcValue::RpcValue(uint32_t value) : m_ptr(std::make_shared<ChainPackUInt>(value)) {}
-RpcValue::RpcValue(int64_t value) : m_ptr(std::make_shared<ChainPackInt>(value)) {}
-RpcValue::RpcValue(uint64_t value) : m_ptr(std::make_shared<ChainPackUInt>(value)) {}
-RpcValue::RpcValue(bool value) : m_ptr(std::make_shared<ChainPackBoolean>(value)) {}
-RpcValue::RpcValue(const DateTime &value) : m_ptr(std::make_shared<ChainPackDateTime>(value)) {}
+RpcValue::RpcValue(std::nullptr_t) noexcept : m_ptr(nullptr), m_scalar(Type::Null) {}
+RpcValue::RpcValue(double value) : m_ptr(nullptr), m_scalar(Type::Double) { m_scalar.v.d = value; }
+RpcValue::RpcValue(RpcValue::Decimal value) : m_ptr(nullptr), m_scalar(Type::Decimal) { m_scalar.v.i = value.mantisa(); m_scalar.aux = value.exponent(); }
+RpcValue::RpcValue(int32_t value) : m_ptr(nullptr), m_scalar(Type::Int) { m_scalar.v.i = value; }
+RpcValue::RpcValue(uint32_t value) : m_ptr(nullptr), m_scalar(Type::UInt) { m_scalar.v.u = value; }
+RpcValue::RpcValue(int64_t value) : m_ptr(nullptr), m_scalar(Type::Int) { m_scalar.v.i = value; }
+RpcValue::RpcValue(uint64_t value) : m_ptr(nullptr), m_scalar(Type::UInt) { m_scalar.v.u = value; }
+RpcValue::RpcValue(bool value) : m_ptr(nullptr), m_scalar(Type::Bool) { m_scalar.v.b = value; }
+RpcValue::RpcValue(const DateTime &value) : m_ptr(nullptr), m_scalar(Type::DateTime) { m_scalar.v.i = value.msecsSinceEpoch(); m_scalar.aux = value.utcOffsetMin(); }
 
 RpcValue::RpcValue(const RpcValue::Blob &value) : m_ptr(std::make_shared<ChainPackBlob>(value)) {}
 RpcValue::RpcValue(RpcValue::Blob &&value) : m_ptr(std::make_shared<ChainPackBlob>(std::move(value))) {}
@@ -479,6 +716,22 @@ RpcValue::RpcValue(RpcValue::Map &&values) : m_ptr(std::make_shared<ChainPackMap
 RpcValue::RpcValue(const RpcValue::IMap &values) : m_ptr(std::make_shared<ChainPackIMap>(values)) {}
 RpcValue::RpcValue(RpcValue::IMap &&values) : m_ptr(std::make_shared<ChainPackIMap>(std::move(values))) {}
 
+namespace {
+template<typename D, typename T>
+std::shared_ptr<RpcValue::AbstractValueData> make_value_data(T &&value, const std::shared_ptr<RpcValueArena> &arena)
+{
+	if(arena)
+		return std::allocate_shared<D>(RpcValueArena::Allocator<D>(arena), std::move(value));
+	return std::make_shared<D>(std::move(value));
+}
+}
+
+RpcValue::RpcValue(std::string &&value, const std::shared_ptr<RpcValueArena> &arena) : m_ptr(make_value_data<ChainPackString>(std::move(value), arena)) {}
+RpcValue::RpcValue(RpcValue::Blob &&value, const std::shared_ptr<RpcValueArena> &arena) : m_ptr(make_value_data<ChainPackBlob>(std::move(value), arena)) {}
+RpcValue::RpcValue(RpcValue::List &&values, const std::shared_ptr<RpcValueArena> &arena) : m_ptr(make_value_data<ChainPackList>(std::move(values), arena)) {}
+RpcValue::RpcValue(RpcValue::Map &&values, const std::shared_ptr<RpcValueArena> &arena) : m_ptr(make_value_data<ChainPackMap>(std::move(values), arena)) {}
+RpcValue::RpcValue(RpcValue::IMap &&values, const std::shared_ptr<RpcValueArena> &arena) : m_ptr(make_value_data<ChainPackIMap>(std::move(values), arena)) {}
+
 #ifdef RPCVALUE_COPY_AND_SWAP
 void RpcValue::swap(RpcValue& other) noexcept
 {
@@ -490,8 +743,95 @@ void RpcValue::swap(RpcValue& other) noexcept
 			  << std::endl;
 	*/
 	std::swap(m_ptr, other.m_ptr);
+	std::swap(m_scalar, other.m_scalar);
 }
 #endif
+
+RpcValue::AbstractValueData *RpcValue::createScalarValueData() const
+{
+	switch(m_scalar.type) {
+	case Type::Null: return new ChainPackNull();
+	case Type::UInt: return new ChainPackUInt(m_scalar.v.u);
+	case Type::Int: return new ChainPackInt(m_scalar.v.i);
+	case Type::Double: return new ChainPackDouble(m_scalar.v.d);
+	case Type::Bool: return new ChainPackBoolean(m_scalar.v.b);
+	case Type::DateTime: return new ChainPackDateTime(DateTime::fromMSecsSinceEpoch(m_scalar.v.i, m_scalar.aux));
+	case Type::Decimal: return new ChainPackDecimal(Decimal(m_scalar.v.i, m_scalar.aux));
+	default: return nullptr;
+	}
+}
+
+void RpcValue::detachScalar()
+{
+	if(isInlineScalar()) {
+		m_ptr = CowPtr<AbstractValueData>(createScalarValueData());
+		m_scalar = Scalar();
+	}
+}
+
+void RpcValue::detachRaw()
+{
+	const CowPtr<AbstractValueData> &ptr = m_ptr;
+	if(!ptr.isNull() && ptr->isRawChainPack()) {
+		std::pair<const char*, size_t> raw = ptr->rawChainPackData();
+		RpcValue val = fromChainPack(raw.first, raw.second);
+		if(!ptr->metaData().isEmpty())
+			val.setMetaData(MetaData(ptr->metaData()));
+		*this = val;
+	}
+}
+RpcValue RpcValue::clone() const
+{
+	RpcValue val = *this;
+	val.detachRaw();
+	RpcValue ret;
+	switch (val.type()) {
+	case Type::String:
+		ret = RpcValue(val.asString());
+		break;
+	case Type::Blob:
+		ret = RpcValue(val.asBlob());
+		break;
+	case Type::List: {
+		List lst;
+		lst.reserve(val.asList().size());
+		for(const RpcValue &v : val.asList())
+			lst.push_back(v.clone());
+		ret = RpcValue(std::move(lst));
+		break;
+	}
+	case Type::Map: {
+		Map map;
+		for(const auto &kv : val.asMap())
+			map[kv.first] = kv.second.clone();
+		ret = RpcValue(std::move(map));
+		break;
+	}
+	case Type::IMap: {
+		IMap map;
+		for(const auto &kv : val.asIMap())
+			map[kv.first] = kv.second.clone();
+		ret = RpcValue(std::move(map));
+		break;
+	}
+	default:
+		// scalar data are never allocated from arena
+		ret = val;
+		break;
+	}
+	const MetaData &md = val.metaData();
+	if(!md.isEmpty()) {
+		MetaData md2;
+		md.forEachIValue([&md2](Int key, const RpcValue &v) {
+			md2.setValue(key, v.clone());
+		});
+		for(const auto &kv : md.sValues())
+			md2.setValue(kv.first, kv.second.clone());
+		ret.setMetaData(std::move(md2));
+	}
+	return ret;
+}
+
 //Value::Value(const Value::MetaTypeId &value) : m_ptr(std::make_shared<ChainPackMetaTypeId>(value)) {}
 //Value::Value(const Value::MetaTypeNameSpaceId &value) : m_ptr(std::make_shared<ChainPackMetaTypeNameSpaceId>(value)) {}
 //Value::Value(const Value::MetaTypeName &value) : m_ptr(std::make_shared<ChainPackMetaTypeName>(value)) {}
@@ -503,7 +843,7 @@ void RpcValue::swap(RpcValue& other) noexcept
 
 RpcValue::Type RpcValue::type() const
 {
-	return !m_ptr.isNull()? m_ptr->type(): Type::Invalid;
+	return !m_ptr.isNull()? m_ptr->type(): m_scalar.type;
 }
 /*
 RpcValue::Type RpcValue::arrayType() const
@@ -535,24 +875,39 @@ RpcValue RpcValue::metaValue(const RpcValue::String &key, const RpcValue &defaul
 
 void RpcValue::setMetaData(RpcValue::MetaData &&meta_data)
 {
-	if(m_ptr.isNull() && !meta_data.isEmpty())
+	if(!isValid() && !meta_data.isEmpty())
 		SHVCHP_EXCEPTION("Cannot set valid meta data to invalid ChainPack value!");
+	if(isInlineScalar()) {
+		if(meta_data.isEmpty())
+			return;
+		detachScalar();
+	}
 	if(!m_ptr.isNull())
 		m_ptr->setMetaData(std::move(meta_data));
 }
 
 void RpcValue::setMetaValue(RpcValue::Int key, const RpcValue &val)
 {
-	if(m_ptr.isNull() && val.isValid())
+	if(!isValid() && val.isValid())
 		SHVCHP_EXCEPTION("Cannot set valid meta value to invalid ChainPack value!");
+	if(isInlineScalar()) {
+		if(!val.isValid())
+			return;
+		detachScalar();
+	}
 	if(!m_ptr.isNull())
 		m_ptr->setMetaValue(key, val);
 }
 
 void RpcValue::setMetaValue(const RpcValue::String &key, const RpcValue &val)
 {
-	if(m_ptr.isNull() && val.isValid())
+	if(!isValid() && val.isValid())
 		SHVCHP_EXCEPTION("Cannot set valid meta value to invalid ChainPack value!");
+	if(isInlineScalar()) {
+		if(!val.isValid())
+			return;
+		detachScalar();
+	}
 	if(!m_ptr.isNull())
 		m_ptr->setMetaValue(key, val);
 }
@@ -579,17 +934,113 @@ bool RpcValue::hasDefaultValue() const
 
 bool RpcValue::isValid() const
 {
-	return !m_ptr.isNull();
+	return !m_ptr.isNull() || m_scalar.type != Type::Invalid;
 }
 
-double RpcValue::toDouble() const { return !m_ptr.isNull()? m_ptr->toDouble(): 0; }
-RpcValue::Decimal RpcValue::toDecimal() const { return !m_ptr.isNull()? m_ptr->toDecimal(): Decimal(); }
-RpcValue::Int RpcValue::toInt() const { return !m_ptr.isNull()? m_ptr->toInt(): 0; }
-RpcValue::UInt RpcValue::toUInt() const { return !m_ptr.isNull()? m_ptr->toUInt(): 0; }
-int64_t RpcValue::toInt64() const { return !m_ptr.isNull()? m_ptr->toInt64(): 0; }
-uint64_t RpcValue::toUInt64() const { return !m_ptr.isNull()? m_ptr->toUInt64(): 0; }
-bool RpcValue::toBool() const { return !m_ptr.isNull()? m_ptr->toBool(): false; }
-RpcValue::DateTime RpcValue::toDateTime() const { return !m_ptr.isNull()? m_ptr->toDateTime(): RpcValue::DateTime{}; }
+// inline scalar conversions shall be the same as the ValueData ones
+double RpcValue::toDouble() const
+{
+	if(!m_ptr.isNull())
+		return m_ptr->toDouble();
+	switch(m_scalar.type) {
+	case Type::Double: return m_scalar.v.d;
+	case Type::Decimal: return Decimal(m_scalar.v.i, m_scalar.aux).toDouble();
+	case Type::Int: return m_scalar.v.i;
+	case Type::UInt: return m_scalar.v.u;
+	default: return 0;
+	}
+}
+
+RpcValue::Decimal RpcValue::toDecimal() const
+{
+	if(!m_ptr.isNull())
+		return m_ptr->toDecimal();
+	if(m_scalar.type == Type::Decimal)
+		return Decimal(m_scalar.v.i, m_scalar.aux);
+	return Decimal();
+}
+
+RpcValue::Int RpcValue::toInt() const
+{
+	if(!m_ptr.isNull())
+		return m_ptr->toInt();
+	switch(m_scalar.type) {
+	case Type::Double: return static_cast<Int>(m_scalar.v.d);
+	case Type::Decimal: return static_cast<Int>(toDouble());
+	case Type::Int: return static_cast<Int>(m_scalar.v.i);
+	case Type::UInt: return static_cast<Int>(m_scalar.v.u);
+	case Type::Bool: return m_scalar.v.b;
+	default: return 0;
+	}
+}
+
+RpcValue::UInt RpcValue::toUInt() const
+{
+	if(!m_ptr.isNull())
+		return m_ptr->toUInt();
+	switch(m_scalar.type) {
+	case Type::Double: return static_cast<UInt>(m_scalar.v.d);
+	case Type::Decimal: return static_cast<UInt>(toDouble());
+	case Type::Int: return static_cast<UInt>(m_scalar.v.i);
+	case Type::UInt: return static_cast<UInt>(m_scalar.v.u);
+	case Type::Bool: return m_scalar.v.b;
+	default: return 0;
+	}
+}
+
+int64_t RpcValue::toInt64() const
+{
+	if(!m_ptr.isNull())
+		return m_ptr->toInt64();
+	switch(m_scalar.type) {
+	case Type::Double: return static_cast<int64_t>(m_scalar.v.d);
+	case Type::Decimal: return static_cast<int64_t>(toDouble());
+	case Type::Int: return m_scalar.v.i;
+	case Type::UInt: return static_cast<int64_t>(m_scalar.v.u);
+	case Type::Bool: return m_scalar.v.b;
+	case Type::DateTime: return m_scalar.v.i;
+	default: return 0;
+	}
+}
+
+uint64_t RpcValue::toUInt64() const
+{
+	if(!m_ptr.isNull())
+		return m_ptr->toUInt64();
+	switch(m_scalar.type) {
+	case Type::Double: return static_cast<uint64_t>(m_scalar.v.d);
+	case Type::Decimal: return static_cast<uint64_t>(toDouble());
+	case Type::Int: return static_cast<uint64_t>(m_scalar.v.i);
+	case Type::UInt: return m_scalar.v.u;
+	case Type::Bool: return m_scalar.v.b;
+	case Type::DateTime: return static_cast<uint64_t>(m_scalar.v.i);
+	default: return 0;
+	}
+}
+
+bool RpcValue::toBool() const
+{
+	if(!m_ptr.isNull())
+		return m_ptr->toBool();
+	switch(m_scalar.type) {
+	case Type::Double: return !(m_scalar.v.d == 0.);
+	case Type::Decimal: return m_scalar.v.i != 0;
+	case Type::Int: return m_scalar.v.i != 0;
+	case Type::UInt: return m_scalar.v.u != 0;
+	case Type::Bool: return m_scalar.v.b;
+	case Type::DateTime: return m_scalar.v.i != 0;
+	default: return false;
+	}
+}
+
+RpcValue::DateTime RpcValue::toDateTime() const
+{
+	if(!m_ptr.isNull())
+		return m_ptr->toDateTime();
+	if(m_scalar.type == Type::DateTime)
+		return DateTime::fromMSecsSinceEpoch(m_scalar.v.i, m_scalar.aux);
+	return DateTime();
+}
 
 RpcValue::String RpcValue::toString() const
 {
@@ -633,10 +1084,26 @@ RpcValue RpcValue::at (const RpcValue::String &key) const { return !m_ptr.isNull
 bool RpcValue::has (RpcValue::Int i) const { return !m_ptr.isNull()? m_ptr->has(i): false; }
 bool RpcValue::has (const RpcValue::String &key) const { return !m_ptr.isNull()? m_ptr->has(key): false; }
 
-std::string RpcValue::toStdString() const { return !m_ptr.isNull()? m_ptr->toStdString(): std::string(); }
+std::string RpcValue::toStdString() const
+{
+	if(!m_ptr.isNull())
+		return m_ptr->toStdString();
+	switch(m_scalar.type) {
+	case Type::Null: return "null";
+	case Type::Double: return Utils::toString(m_scalar.v.d);
+	case Type::Decimal: return toDecimal().toString();
+	case Type::Int: return Utils::toString(m_scalar.v.i);
+	case Type::UInt: return Utils::toString(m_scalar.v.u);
+	case Type::Bool: return m_scalar.v.b? "true": "false";
+	case Type::DateTime: return toDateTime().toIsoString();
+	default: return std::string();
+	}
+}
 
 void RpcValue::set(RpcValue::Int ix, const RpcValue &val)
 {
+	detachScalar();
+	detachRaw();
 	if(!m_ptr.isNull())
 		m_ptr->set(ix, val);
 	else
@@ -645,6 +1112,8 @@ void RpcValue::set(RpcValue::Int ix, const RpcValue &val)
 
 void RpcValue::set(const RpcValue::String &key, const RpcValue &val)
 {
+	detachScalar();
+	detachRaw();
 	if(!m_ptr.isNull())
 		m_ptr->set(key, val);
 	else
@@ -653,6 +1122,8 @@ void RpcValue::set(const RpcValue::String &key, const RpcValue &val)
 
 void RpcValue::append(const RpcValue &val)
 {
+	detachScalar();
+	detachRaw();
 	if(!m_ptr.isNull())
 		m_ptr->append(val);
 	else
@@ -662,35 +1133,36 @@ void RpcValue::append(const RpcValue &val)
 RpcValue RpcValue::metaStripped() const
 {
 	RpcValue ret = *this;
-	ret.m_ptr->stripMeta();
+	if(!ret.m_ptr.isNull())
+		ret.m_ptr->stripMeta();
 	return ret;
 }
 
 std::string RpcValue::toPrettyString(const std::string &indent) const
 {
 	if(isValid()) {
-		std::ostringstream out;
+		std::string out;
 		{
 			CponWriterOptions opts;
 			opts.setTranslateIds(true).setIndent(indent);
 			CponWriter wr(out, opts);
 			wr << *this;
 		}
-		return out.str();
+		return out;
 	}
 	return "<invalid>";
 }
 
 std::string RpcValue::toCpon(const std::string &indent) const
 {
-	std::ostringstream out;
+	std::string out;
 	{
 		CponWriterOptions opts;
 		opts.setTranslateIds(false).setIndent(indent);
 		CponWriter wr(out, opts);
 		wr << *this;
 	}
-	return out.str();
+	return out;
 }
 
 const std::string & RpcValue::AbstractValueData::asString() const { return static_empty_string(); }
@@ -720,14 +1192,33 @@ void RpcValue::AbstractValueData::append(const RpcValue &)
 bool RpcValue::operator== (const RpcValue &other) const
 {
 	if(isValid() && other.isValid()) {
+		const Type t = type();
+		const Type ot = other.type();
 		if (
-			(m_ptr->type() == other.m_ptr->type())
-			|| (m_ptr->type() == RpcValue::Type::UInt && other.m_ptr->type() == RpcValue::Type::Int)
-			|| (m_ptr->type() == RpcValue::Type::Int && other.m_ptr->type() == RpcValue::Type::UInt)
-			|| (m_ptr->type() == RpcValue::Type::Double && other.m_ptr->type() == RpcValue::Type::Decimal)
-			|| (m_ptr->type() == RpcValue::Type::Decimal && other.m_ptr->type() == RpcValue::Type::Double)
+			(t == ot)
+			|| (t == RpcValue::Type::UInt && ot == RpcValue::Type::Int)
+			|| (t == RpcValue::Type::Int && ot == RpcValue::Type::UInt)
+			|| (t == RpcValue::Type::Double && ot == RpcValue::Type::Decimal)
+			|| (t == RpcValue::Type::Decimal && ot == RpcValue::Type::Double)
 		) {
-			return m_ptr->equals(other.m_ptr.operator->());
+			if(!m_ptr.isNull() && !other.m_ptr.isNull())
+				return m_ptr->equals(other.m_ptr.operator->());
+			// at least one value is inline scalar, compare the same way as ValueData::equals() does
+			switch (t) {
+			case Type::Invalid: return false;
+			case Type::Null: return true;
+			case Type::UInt: return toUInt64() == other.toUInt64();
+			case Type::Int: return toInt64() == other.toInt64();
+			case Type::Double:
+			case Type::Decimal: return toDouble() == other.toDouble();
+			case Type::Bool: return toBool() == other.toBool();
+			case Type::DateTime: return toDateTime().msecsSinceEpoch() == other.toDateTime().msecsSinceEpoch();
+			case Type::String: return asString() == other.asString();
+			case Type::Blob: return asBlob() == other.asBlob();
+			case Type::List: return asList() == other.asList();
+			case Type::Map: return asMap() == other.asMap();
+			case Type::IMap: return asIMap() == other.asIMap();
+			}
 		}
 		return false;
 	}
@@ -746,10 +1237,14 @@ bool ChainPack::operator< (const ChainPack &other) const
 */
 
 RpcValue RpcValue::fromCpon(const std::string &str, std::string *err)
+{
+	return fromCpon(str.data(), str.size(), err);
+}
+
+RpcValue RpcValue::fromCpon(const char *data, size_t length, std::string *err)
 {
 	RpcValue ret;
-	std::istringstream in(str);
-	CponReader rd(in);
+	CponReader rd(data, length);
 	if(err) {
 		err->clear();
 		try {
@@ -770,19 +1265,23 @@ RpcValue RpcValue::fromCpon(const std::string &str, std::string *err)
 
 std::string RpcValue::toChainPack() const
 {
-	std::ostringstream out;
+	std::string out;
 	{
 		ChainPackWriter wr(out);
 		wr << *this;
 	}
-	return out.str();
+	return out;
 }
 
 RpcValue RpcValue::fromChainPack(const std::string &str, std::string *err)
+{
+	return fromChainPack(str.data(), str.size(), err);
+}
+
+RpcValue RpcValue::fromChainPack(const char *data, size_t length, std::string *err)
 {
 	RpcValue ret;
-	std::istringstream in(str);
-	ChainPackReader rd(in);
+	ChainPackReader rd(data, length);
 	if(err) {
 		err->clear();
 		try {
@@ -801,6 +1300,87 @@ RpcValue RpcValue::fromChainPack(const std::string &str, std::string *err)
 	return ret;
 }
 
+namespace {
+/// raw value is used for strings and containers only
+RpcValue::Type raw_chainpack_type(const char *begin, const char *end)
+{
+	if(begin < end) {
+		switch(static_cast<uint8_t>(*begin)) {
+		case CP_String:
+		case CP_CString: return RpcValue::Type::String;
+		case CP_Blob: return RpcValue::Type::Blob;
+		case CP_List: return RpcValue::Type::List;
+		case CP_Map: return RpcValue::Type::Map;
+		case CP_IMap: return RpcValue::Type::IMap;
+		default: break;
+		}
+	}
+	return RpcValue::Type::Invalid;
+}
+}
+
+RpcValue RpcValue::fromRawChainPack(const std::shared_ptr<const std::string> &data, std::string *err)
+{
+	if(err)
+		err->clear();
+	if(!data)
+		return RpcValue();
+	try {
+		ChainPackReader rd(data->data(), data->size());
+		MetaData meta_data;
+		rd.read(meta_data);
+		const char *value_begin = data->data() + rd.readPos();
+		const Type type = raw_chainpack_type(value_begin, data->data() + data->size());
+		if(type == Type::Invalid) {
+			// scalars are not worth to be kept packed
+			return fromChainPack(data->data(), data->size());
+		}
+		ChainPackRawValue *raw = new ChainPackRawValue(type, data, value_begin, 0);
+		RpcValue ret;
+		ret.m_ptr = CowPtr<AbstractValueData>(raw);
+		// whole value is validated, raw value is expected to be parsed without errors later
+		raw->validate(rd);
+		if(!meta_data.isEmpty())
+			raw->setMetaData(std::move(meta_data));
+		return ret;
+	}
+	catch(ChainPackReader::ParseException &e) {
+		if(!err)
+			throw;
+		*err = e.what();
+	}
+	return RpcValue();
+}
+
+RpcValue RpcValue::fromRawChainPackSpan(const std::shared_ptr<const std::string> &data, const char *begin, size_t size)
+{
+	ChainPackReader rd(begin, size);
+	MetaData meta_data;
+	rd.read(meta_data);
+	const size_t meta_size = static_cast<size_t>(rd.readPos());
+	const Type type = raw_chainpack_type(begin + meta_size, begin + size);
+	if(type == Type::Invalid)
+		return fromChainPack(begin, size);
+	ChainPackRawValue *raw = new ChainPackRawValue(type, data, begin + meta_size, size - meta_size);
+	RpcValue ret;
+	ret.m_ptr = CowPtr<AbstractValueData>(raw);
+	if(!meta_data.isEmpty())
+		raw->setMetaData(std::move(meta_data));
+	return ret;
+}
+
+bool RpcValue::isRawChainPack() const
+{
+	return !m_ptr.isNull() && m_ptr->isRawChainPack();
+}
+
+std::pair<const char *, size_t> RpcValue::rawChainPackData() const
+{
+	if(m_ptr.isNull())
+		return {nullptr, 0};
+	return m_ptr->rawChainPackData();
+}
+
 const char *RpcValue::typeToName(RpcValue::Type t)
 {
 	switch (t) {
@@ -1047,12 +1627,11 @@ RpcValue::MetaData::MetaData()
 }
 
 RpcValue::MetaData::MetaData(const RpcValue::MetaData &o)
+	: m_iValues(o.m_iValues)
 {
 #ifdef DEBUG_RPCVAL
 	logDebugRpcVal() << ++cnt << "+++MM copy" << this << "<------" << &o;
 #endif
-	if(o.m_imap && !o.m_imap->empty())
-		m_imap = new RpcValue::IMap(*o.m_imap);
 	if(o.m_smap && !o.m_smap->empty())
 		m_smap = new RpcValue::Map(*o.m_smap);
 }
@@ -1071,8 +1650,11 @@ RpcValue::MetaData::MetaData(RpcValue::IMap &&imap)
 #ifdef DEBUG_RPCVAL
 	logDebugRpcVal() << ++cnt << "+++MM move imap" << this;
 #endif
-	if(!imap.empty())
-		m_imap = new RpcValue::IMap(std::move(imap));
+	m_iValues.reserve(imap.size());
+	for(auto &&kv : imap) {
+		if(kv.second.isValid())
+			m_iValues.emplace_back(kv.first, std::move(kv.second));
+	}
 }
 
 RpcValue::MetaData::MetaData(RpcValue::Map &&smap)
@@ -1085,12 +1667,11 @@ RpcValue::MetaData::MetaData(RpcValue::Map &&smap)
 }
 
 RpcValue::MetaData::MetaData(RpcValue::IMap &&imap, RpcValue::Map &&smap)
+	: MetaData(std::move(imap))
 {
 #ifdef DEBUG_RPCVAL
 	logDebugRpcVal() << ++cnt << "+++MM move imap smap" << this;
 #endif
-	if(!imap.empty())
-		m_imap = new RpcValue::IMap(std::move(imap));
 	if(!smap.empty())
 		m_smap = new RpcValue::Map(std::move(smap));
 }
@@ -1100,10 +1681,7 @@ RpcValue::MetaData::~MetaData()
 #ifdef DEBUG_RPCVAL
 	logDebugRpcVal() << cnt-- << "---MM cnt:" << size() << this;
 #endif
-	if(m_imap)
-		delete m_imap;
-	if(m_smap)
-		delete m_smap;
+	delete m_smap;
 }
 
 RpcValue::MetaData &RpcValue::MetaData::operator =(RpcValue::MetaData &&o)
@@ -1120,18 +1698,27 @@ RpcValue::MetaData &RpcValue::MetaData::operator=(const RpcValue::MetaData &o)
 #ifdef DEBUG_RPCVAL
 	logDebugRpcVal() << "===MM op= const ref" << this;
 #endif
-	if(o.m_imap && !o.m_imap->empty())
-		m_imap = new RpcValue::IMap(*o.m_imap);
-	if(o.m_smap && !o.m_smap->empty())
-		m_smap = new RpcValue::Map(*o.m_smap);
+	MetaData tmp(o);
+	swap(tmp);
 	return *this;
 }
 
+RpcValue::MetaData::IValueList::const_iterator RpcValue::MetaData::findIValue(RpcValue::Int key) const
+{
+	auto it = std::lower_bound(m_iValues.begin(), m_iValues.end(), key, [](const IValue &kv, RpcValue::Int k) {
+		return kv.first < k;
+	});
+	if(it != m_iValues.end() && it->first == key)
+		return it;
+	return m_iValues.end();
+}
+
 std::vector<RpcValue::Int> RpcValue::MetaData::iKeys() const
 {
 	std::vector<RpcValue::Int> ret;
-	for(const auto &it : iValues())
-		ret.push_back(it.first);
+	ret.reserve(m_iValues.size());
+	for(const IValue &kv : m_iValues)
+		ret.push_back(kv.first);
 	return ret;
 }
 
@@ -1145,9 +1732,7 @@ std::vector<RpcValue::String> RpcValue::MetaData::sKeys() const
 
 bool RpcValue::MetaData::hasKey(RpcValue::Int key) const
 {
-	const IMap &m = iValues();
-	auto it = m.find(key);
-	return (it != m.end());
+	return findIValue(key) != m_iValues.end();
 }
 
 bool RpcValue::MetaData::hasKey(const RpcValue::String &key) const
@@ -1159,9 +1744,8 @@ bool RpcValue::MetaData::hasKey(const RpcValue::String &key) const
 
 RpcValue RpcValue::MetaData::value(RpcValue::Int key, const RpcValue &def_val) const
 {
-	const IMap &m = iValues();
-	auto it = m.find(key);
-	if(it != m.end())
+	auto it = findIValue(key);
+	if(it != m_iValues.end())
 		return it->second;
 	return def_val;
 }
@@ -1177,14 +1761,26 @@ RpcValue RpcValue::MetaData::value(const String &key, const RpcValue &def_val) c
 
 void RpcValue::MetaData::setValue(RpcValue::Int key, const RpcValue &val)
 {
+	auto it = std::lower_bound(m_iValues.begin(), m_iValues.end(), key, [](const IValue &kv, RpcValue::Int k) {
+		return kv.first < k;
+	});
+	const bool found = it != m_iValues.end() && it->first == key;
 	if(val.isValid()) {
-		if(!m_imap)
-			m_imap = new RpcValue::IMap();
-		(*m_imap)[key] = val;
+		if(found) {
+			it->second = val;
+		}
+		else if(m_iValues.empty()) {
+			// RPC message header tags fit without reallocation
+			m_iValues.reserve(INITIAL_IVALUES_CAPACITY);
+			m_iValues.emplace_back(key, val);
+		}
+		else {
+			m_iValues.emplace(it, key, val);
+		}
 	}
 	else {
-		if(m_imap)
-			m_imap->erase(key);
+		if(found)
+			m_iValues.erase(it);
 	}
 }
 
@@ -1203,7 +1799,7 @@ void RpcValue::MetaData::setValue(const RpcValue::String &key, const RpcValue &v
 
 size_t RpcValue::MetaData::size() const
 {
-	return (m_imap? m_imap->size(): 0) + (m_smap? m_smap->size(): 0);
+	return m_iValues.size() + (m_smap? m_smap->size(): 0);
 }
 
 bool RpcValue::MetaData::isEmpty() const
@@ -1213,21 +1809,21 @@ bool RpcValue::MetaData::isEmpty() const
 
 bool RpcValue::MetaData::operator==(const RpcValue::MetaData &o) const
 {
-	/*
-	std::cerr << "this" << std::endl;
-	for(const auto &it : m_imap)
-		std::cerr << '\t' << it.first << ": " << it.second.dumpText() << std::endl;
-	std::cerr << "other" << std::endl;
-	for(const auto &it : o.m_imap)
-		std::cerr << '\t' << it.first << ": " << it.second.dumpText() << std::endl;
-	*/
-	return iValues() == o.iValues() && sValues() == o.sValues();
+	if(m_iValues.size() != o.m_iValues.size())
+		return false;
+	for(size_t i = 0; i < m_iValues.size(); i++) {
+		if(m_iValues[i].first != o.m_iValues[i].first || !(m_iValues[i].second == o.m_iValues[i].second))
+			return false;
+	}
+	return sValues() == o.sValues();
 }
 
-const RpcValue::IMap &RpcValue::MetaData::iValues() const
+RpcValue::IMap RpcValue::MetaData::iValuesMap() const
 {
-	static RpcValue::IMap m;
-	return m_imap? *m_imap: m;
+	RpcValue::IMap ret;
+	for(const IValue &kv : m_iValues)
+		ret.emplace_hint(ret.end(), kv.first, kv.second);
+	return ret;
 }
 
 const RpcValue::Map &RpcValue::MetaData::sValues() const
@@ -1238,19 +1834,19 @@ const RpcValue::Map &RpcValue::MetaData::sValues() const
 
 std::string RpcValue::MetaData::toPrettyString() const
 {
-	std::ostringstream out;
+	std::string out;
 	{
 		CponWriterOptions opts;
 		opts.setTranslateIds(true);
 		CponWriter wr(out, opts);
 		wr << *this;
 	}
-	return out.str();
+	return out;
 }
 
 std::string RpcValue::MetaData::toString(const std::string &indent) const
 {
-	std::ostringstream out;
+	std::string out;
 	{
 		CponWriterOptions opts;
 		opts.setTranslateIds(false);
@@ -1258,7 +1854,7 @@ std::string RpcValue::MetaData::toString(const std::string &indent) const
 		CponWriter wr(out, opts);
 		wr << *this;
 	}
-	return out.str();
+	return out;
 }
 
 RpcValue::MetaData *RpcValue::MetaData::clone() const
@@ -1269,7 +1865,7 @@ RpcValue::MetaData *RpcValue::MetaData::clone() const
 
 void RpcValue::MetaData::swap(RpcValue::MetaData &o)
 {
-	std::swap(m_imap, o.m_imap);
+	std::swap(m_iValues, o.m_iValues);
 	std::swap(m_smap, o.m_smap);
 }
 
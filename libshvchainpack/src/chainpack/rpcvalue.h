@@ -3,6 +3,7 @@
 #include "../shvchainpackglobal.h"
 #include "exception.h"
 #include "metatypes.h"
+#include "flatmap.h"
 
 #include <string>
 #include <vector>
@@ -13,6 +14,10 @@
 #ifndef CHAINPACK_UINT
 	#define CHAINPACK_UINT unsigned
 #endif
+/// RpcValue::Map and RpcValue::IMap are stored in sorted vector instead of std::map if defined,
+/// it changes ABI, so it must be defined for the library and all its users, qmake CONFIG+=with-rpcvalue-flatmap does it
+//#define SHV_RPCVALUE_FLAT_MAP
+
 namespace shv {
 namespace chainpack {
 
@@ -40,6 +45,9 @@ private:
 	}
 
 public:
+	/// shared_ptr constructed from raw null pointer allocates control block, this one does not
+	CowPtr(std::nullptr_t)
+	{}
 	CowPtr(T* t)
 		:   m_sp(t)
 	{}
@@ -74,6 +82,8 @@ public:
 	}
 };
 
+class RpcValueArena;
+
 class SHVCHAINPACK_DECL_EXPORT RpcValue
 {
 public:
@@ -216,9 +226,16 @@ public:
 			return ret;
 		}
 	};
-	class Map : public std::map<String, RpcValue>
+#ifdef SHV_RPCVALUE_FLAT_MAP
+	template<typename K, typename V>
+	using MapBase = FlatMap<K, V>;
+#else
+	template<typename K, typename V>
+	using MapBase = std::map<K, V>;
+#endif
+	class Map : public MapBase<String, RpcValue>
 	{
-		using Super = std::map<String, RpcValue>;
+		using Super = MapBase<String, RpcValue>;
 		using Super::Super; // expose base class constructors
 	public:
 		RpcValue value(const String &key, const RpcValue &default_val = RpcValue()) const
@@ -248,9 +265,9 @@ public:
 			return ret;
 		}
 	};
-	class IMap : public std::map<Int, RpcValue>
+	class IMap : public MapBase<Int, RpcValue>
 	{
-		using Super = std::map<Int, RpcValue>;
+		using Super = MapBase<Int, RpcValue>;
 		using Super::Super; // expose base class constructors
 	public:
 		RpcValue value(Int key, const RpcValue &default_val = RpcValue()) const
@@ -281,52 +298,12 @@ public:
 		}
 	};
 
-	class SHVCHAINPACK_DECL_EXPORT MetaData
-	{
-	public:
-		MetaData();
-		MetaData(const MetaData &o);
-		MetaData(MetaData &&o);
-		MetaData(RpcValue::IMap &&imap);
-		MetaData(RpcValue::Map &&smap);
-		MetaData(RpcValue::IMap &&imap, RpcValue::Map &&smap);
-		~MetaData();
-
-		MetaData& operator =(MetaData &&o);
-
-		int metaTypeId() const {return value(meta::Tag::MetaTypeId).toInt();}
-		void setMetaTypeId(RpcValue::Int id) {setValue(meta::Tag::MetaTypeId, id);}
-		int metaTypeNameSpaceId() const {return value(meta::Tag::MetaTypeNameSpaceId).toInt();}
-		void setMetaTypeNameSpaceId(RpcValue::Int id) {setValue(meta::Tag::MetaTypeNameSpaceId, id);}
-		std::vector<RpcValue::Int> iKeys() const;
-		std::vector<RpcValue::String> sKeys() const;
-		bool hasKey(RpcValue::Int key) const;
-		bool hasKey(const RpcValue::String &key) const;
-		RpcValue value(RpcValue::Int key, const RpcValue &def_val = RpcValue()) const;
-		RpcValue value(const RpcValue::String &key, const RpcValue &def_val = RpcValue()) const;
-		void setValue(RpcValue::Int key, const RpcValue &val);
-		void setValue(const RpcValue::String &key, const RpcValue &val);
-		size_t size() const;
-		bool isEmpty() const;
-		bool operator==(const MetaData &o) const;
-		const RpcValue::IMap& iValues() const;
-		const RpcValue::Map& sValues() const;
-		std::string toPrettyString() const;
-		std::string toString(const std::string &indent = std::string()) const;
-
-		MetaData* clone() const;
-	private:
-		MetaData& operator=(const MetaData &o);
-		void swap(MetaData &o);
-	private:
-		RpcValue::IMap *m_imap = nullptr;
-		RpcValue::Map *m_smap = nullptr;
-	};
+	class MetaData;
 
 	// Constructors for the various types of JSON value.
 	RpcValue() noexcept;                // Invalid
 #ifdef RPCVALUE_COPY_AND_SWAP
-	RpcValue(const RpcValue &other) noexcept : m_ptr(other.m_ptr) {}
+	RpcValue(const RpcValue &other) noexcept : m_ptr(other.m_ptr), m_scalar(other.m_scalar) {}
 	RpcValue(RpcValue &&other) noexcept : RpcValue() { swap(other); }
 #endif
 	RpcValue(std::nullptr_t) noexcept;  // Null
@@ -354,6 +331,13 @@ public:
 	RpcValue(const IMap &values);     // IMap
 	RpcValue(IMap &&values);          // IMap
 
+	// Value data allocated from arena, plain heap is used if arena is null.
+	RpcValue(std::string &&value, const std::shared_ptr<RpcValueArena> &arena);
+	RpcValue(Blob &&value, const std::shared_ptr<RpcValueArena> &arena);
+	RpcValue(List &&values, const std::shared_ptr<RpcValueArena> &arena);
+	RpcValue(Map &&values, const std::shared_ptr<RpcValueArena> &arena);
+	RpcValue(IMap &&values, const std::shared_ptr<RpcValueArena> &arena);
+
 	// Implicit constructor: anything with a toRpcValue() function.
 	// dangerous
 	//template <class T, class = decltype(&T::toRpcValue)>
@@ -447,11 +431,23 @@ public:
 	std::string toStdString() const;
 	std::string toCpon(const std::string &indent = std::string()) const;
 	static RpcValue fromCpon(const std::string & str, std::string *err = nullptr);
+	static RpcValue fromCpon(const char *data, size_t length, std::string *err = nullptr);
 
 	std::string toChainPack() const;
 	static RpcValue fromChainPack(const std::string & str, std::string *err = nullptr);
-	//static constexpr bool CloneMetaData = true;
-	//RpcValue clone(bool clone_meta_data = CloneMetaData) const;
+	static RpcValue fromChainPack(const char *data, size_t length, std::string *err = nullptr);
+	/// Value wrapping packed ChainPack data, it is decoded lazily on access.
+	/// at() decodes the requested item only, containers and strings are returned as raw values again.
+	/// Raw value is written to ChainPack by copying packed data.
+	/// Data are validated on construction, meta data and scalars are decoded immediately.
+	static RpcValue fromRawChainPack(const std::shared_ptr<const std::string> &data, std::string *err = nullptr);
+	bool isRawChainPack() const;
+	/// packed data of raw value without meta data, {nullptr, 0} for other values
+	std::pair<const char*, size_t> rawChainPackData() const;
+	/// Deep copy allocated on the heap, it does not share any data with this value.
+	/// Use it for parts of decoded message kept for long time,
+	/// otherwise single retained item keeps whole message RpcValueArena alive.
+	RpcValue clone() const;
 
 	bool operator== (const RpcValue &rhs) const;
 	bool operator!= (const RpcValue &rhs) const {return !operator==(rhs);}
@@ -473,11 +469,101 @@ public:
 	template<typename T> static inline Type guessType();
 	template<typename T> static inline RpcValue fromValue(const T &t);
 
+	/// inline scalar is not reference counted, 0 is returned for it
 	long refCnt() const { return m_ptr.refCnt();}
+private:
+	/// Scalar value without meta data is stored inline, m_ptr is null in such case.
+	/// Heap allocated value data are used for strings, blobs, containers and for scalars with meta data.
+	struct Scalar
+	{
+		Type type = Type::Invalid;
+		/// Decimal exponent or DateTime UTC offset in minutes
+		int32_t aux = 0;
+		union {
+			int64_t i;
+			uint64_t u;
+			double d;
+			bool b;
+		} v;
+
+		Scalar() : v() {}
+		explicit Scalar(Type t) : type(t), v() {}
+	};
+	bool isInlineScalar() const { return m_ptr.isNull() && m_scalar.type != Type::Invalid; }
+	AbstractValueData* createScalarValueData() const;
+	/// move inline scalar to the heap, it is needed to store meta data
+	void detachScalar();
+
+	friend class ChainPackRawValue;
+	/// data span must contain single valid ChainPack value
+	static RpcValue fromRawChainPackSpan(const std::shared_ptr<const std::string> &data, const char *begin, size_t size);
+	/// replace raw value by the decoded one, it is needed to modify it
+	void detachRaw();
 private:
 	CowPtr<AbstractValueData> m_ptr;
+	Scalar m_scalar;
+};
+
+class SHVCHAINPACK_DECL_EXPORT RpcValue::MetaData
+{
+public:
+	MetaData();
+	MetaData(const MetaData &o);
+	MetaData(MetaData &&o);
+	MetaData(RpcValue::IMap &&imap);
+	MetaData(RpcValue::Map &&smap);
+	MetaData(RpcValue::IMap &&imap, RpcValue::Map &&smap);
+	~MetaData();
+
+	MetaData& operator =(MetaData &&o);
+
+	int metaTypeId() const {return value(meta::Tag::MetaTypeId).toInt();}
+	void setMetaTypeId(RpcValue::Int id) {setValue(meta::Tag::MetaTypeId, id);}
+	int metaTypeNameSpaceId() const {return value(meta::Tag::MetaTypeNameSpaceId).toInt();}
+	void setMetaTypeNameSpaceId(RpcValue::Int id) {setValue(meta::Tag::MetaTypeNameSpaceId, id);}
+	std::vector<RpcValue::Int> iKeys() const;
+	std::vector<RpcValue::String> sKeys() const;
+	bool hasKey(RpcValue::Int key) const;
+	bool hasKey(const RpcValue::String &key) const;
+	RpcValue value(RpcValue::Int key, const RpcValue &def_val = RpcValue()) const;
+	RpcValue value(const RpcValue::String &key, const RpcValue &def_val = RpcValue()) const;
+	void setValue(RpcValue::Int key, const RpcValue &val);
+	void setValue(const RpcValue::String &key, const RpcValue &val);
+	size_t size() const;
+	bool isEmpty() const;
+	bool operator==(const MetaData &o) const;
+	/// calls fn(key, value) for all int keys in ascending order
+	template<typename F> void forEachIValue(F fn) const;
+	/// int keys map is composed on every call and returned by value, use forEachIValue() where possible
+	RpcValue::IMap iValuesMap() const;
+	const RpcValue::Map& sValues() const;
+	std::string toPrettyString() const;
+	std::string toString(const std::string &indent = std::string()) const;
+
+	MetaData* clone() const;
+private:
+	using IValue = std::pair<RpcValue::Int, RpcValue>;
+	using IValueList = std::vector<IValue>;
+
+	MetaData& operator=(const MetaData &o);
+	void swap(MetaData &o);
+	IValueList::const_iterator findIValue(RpcValue::Int key) const;
+private:
+	static constexpr size_t INITIAL_IVALUES_CAPACITY = 8;
+
+	/// int keys in ascending order, there are few of them, RPC message header has 5 typically,
+	/// so sorted vector is faster to search and to build than map
+	IValueList m_iValues;
+	RpcValue::Map *m_smap = nullptr;
 };
 
+template<typename F>
+void RpcValue::MetaData::forEachIValue(F fn) const
+{
+	for(const IValue &kv : m_iValues)
+		fn(kv.first, kv.second);
+}
+
 template<typename T> RpcValue::Type RpcValue::guessType() { throw std::runtime_error("guessing of this type is not implemented"); }
 template<> inline RpcValue::Type RpcValue::guessType<RpcValue::Int>() { return Type::Int; }
 template<> inline RpcValue::Type RpcValue::guessType<RpcValue::UInt>() { return Type::UInt; }
@@ -0,0 +1,56 @@
+#include "rpcvaluearena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace shv {
+namespace chainpack {
+
+constexpr size_t RpcValueArena::DEFAULT_BLOCK_SIZE;
+constexpr size_t RpcValueArena::MAX_BLOCK_SIZE;
+
+RpcValueArena::RpcValueArena(size_t initial_block_size)
+	: m_nextBlockSize(std::max<size_t>(initial_block_size, 64))
+{
+}
+
+RpcValueArena::~RpcValueArena()
+{
+	while(m_blocks) {
+		Block *next = m_blocks->next;
+		::operator delete(m_blocks);
+		m_blocks = next;
+	}
+}
+
+void *RpcValueArena::allocate(size_t size, size_t alignment)
+{
+	uintptr_t p = reinterpret_cast<uintptr_t>(m_current);
+	uintptr_t aligned = (p + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+	if(!m_current || aligned + size > reinterpret_cast<uintptr_t>(m_end)) {
+		addBlock(size + alignment);
+		p = reinterpret_cast<uintptr_t>(m_current);
+		aligned = (p + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+	}
+	m_current = reinterpret_cast<char*>(aligned + size);
+	m_size += size;
+	return reinterpret_cast<void*>(aligned);
+}
+
+void RpcValueArena::addBlock(size_t min_size)
+{
+	size_t block_size = std::max(m_nextBlockSize, min_size + sizeof(Block));
+	Block *block = static_cast<Block*>(::operator new(block_size));
+	block->next = m_blocks;
+	m_blocks = block;
+	m_current = reinterpret_cast<char*>(block + 1);
+	m_end = reinterpret_cast<char*>(block) + block_size;
+	m_capacity += block_size;
+	m_blockCount++;
+	// grow geometrically up to fixed size chunks, big messages need just few blocks
+	m_nextBlockSize = std::min(m_nextBlockSize * 2, std::max(MAX_BLOCK_SIZE, m_nextBlockSize));
+}
+
+} // namespace chainpack
+} // namespace shv
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "../shvchainpackglobal.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace shv {
+namespace chainpack {
+
+/// Monotonic memory arena for values decoded from single RPC message.
+///
+/// Memory is taken from blocks allocated on demand, deallocation is no-op,
+/// all the blocks are released together when the arena is destroyed.
+/// Blocks grow geometrically up to MAX_BLOCK_SIZE chunks,
+/// so less than one chunk is wasted at the end of the last block.
+/// Values allocated from arena keep it alive through their allocator,
+/// so arena lives until the last value allocated from it is dropped.
+/// Single retained string or container pins the whole arena,
+/// use RpcValue::clone() for values which outlive the decoded message.
+/// Allocation is not thread safe, arena is supposed to be filled by single reader.
+class SHVCHAINPACK_DECL_EXPORT RpcValueArena
+{
+public:
+	static constexpr size_t DEFAULT_BLOCK_SIZE = 4 * 1024;
+	static constexpr size_t MAX_BLOCK_SIZE = 64 * 1024;
+
+	/// STL allocator holding shared reference to the arena
+	template<typename T>
+	class Allocator
+	{
+	public:
+		using value_type = T;
+		template<typename U>
+		struct rebind { using other = Allocator<U>; };
+
+		Allocator(const std::shared_ptr<RpcValueArena> &arena) : m_arena(arena) {}
+		template<typename U>
+		Allocator(const Allocator<U> &o) : m_arena(o.arena()) {}
+
+		T* allocate(size_t n) { return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+		void deallocate(T*, size_t) {}
+
+		const std::shared_ptr<RpcValueArena>& arena() const {return m_arena;}
+
+		template<typename U>
+		bool operator==(const Allocator<U> &o) const {return m_arena == o.arena();}
+		template<typename U>
+		bool operator!=(const Allocator<U> &o) const {return m_arena != o.arena();}
+	private:
+		std::shared_ptr<RpcValueArena> m_arena;
+	};
+public:
+	/// bigger initial_block_size saves few allocations, but it is wasted if message has few strings and containers
+	explicit RpcValueArena(size_t initial_block_size = DEFAULT_BLOCK_SIZE);
+	RpcValueArena(const RpcValueArena &) = delete;
+	RpcValueArena& operator=(const RpcValueArena &) = delete;
+	~RpcValueArena();
+
+	void* allocate(size_t size, size_t alignment);
+
+	/// bytes allocated by arena blocks
+	size_t capacity() const {return m_capacity;}
+	/// bytes handed out by allocate()
+	size_t size() const {return m_size;}
+	size_t blockCount() const {return m_blockCount;}
+private:
+	void addBlock(size_t min_size);
+private:
+	struct Block
+	{
+		Block *next;
+	};
+	Block *m_blocks = nullptr;
+	char *m_current = nullptr;
+	char *m_end = nullptr;
+	size_t m_nextBlockSize;
+	size_t m_capacity = 0;
+	size_t m_size = 0;
+	size_t m_blockCount = 0;
+};
+
+} // namespace chainpack
+} // namespace shv
@@ -50,12 +50,13 @@ int64_t SocketRpcDriver::writeBytes(const char *bytes, size_t length)
 		nInfo() << "Write to closed socket";
 		return 0;
 	}
-	flush();
-	ssize_t bytes_to_write_len = (m_writeBuffer.size() + length > m_maxWriteBufferLength)? m_maxWriteBufferLength - m_writeBuffer.size(): length;
+	// messages are collected in write buffer and written to socket at once in flush()
+	if(m_writeBuffer.size() + length > m_maxWriteBufferLength)
+		flush();
+	size_t bytes_to_write_len = (m_writeBuffer.size() + length > m_maxWriteBufferLength)? m_maxWriteBufferLength - m_writeBuffer.size(): length;
 	if(bytes_to_write_len > 0)
-		m_writeBuffer += std::string(bytes, static_cast<size_t>(bytes_to_write_len));
-	flush();
-	return bytes_to_write_len;
+		m_writeBuffer.append(bytes, bytes_to_write_len);
+	return static_cast<int64_t>(bytes_to_write_len);
 }
 
 bool SocketRpcDriver::flush()
@@ -69,7 +70,7 @@ bool SocketRpcDriver::flush()
 	int64_t n = ::write(m_socket, m_writeBuffer.data(), m_writeBuffer.length());
 	nDebug() << "\t" << n << "bytes written";
 	if(n > 0)
-		m_writeBuffer = m_writeBuffer.substr(n);
+		m_writeBuffer.erase(0, static_cast<size_t>(n));
 	return (n > 0);
 }
 
@@ -139,7 +140,8 @@ void SocketRpcDriver::exec()
 		FD_ZERO(&read_flags);
 		FD_ZERO(&write_flags);
 		FD_SET(m_socket, &read_flags);
-		if(!m_writeBuffer.empty())
+		// send queue can be non-empty when previous write batch was limited by writeBatchMaxBytes()
+		if(!m_writeBuffer.empty() || sendQueueLength() > 0)
 			FD_SET(m_socket, &write_flags);
 		//FD_SET(STDIN_FILENO, &read_flags);
 		//FD_SET(STDIN_FILENO, &write_flags);
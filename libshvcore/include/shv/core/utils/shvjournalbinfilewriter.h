@@ -0,0 +1 @@
+#include "../../../../src/utils/shvjournalbinfilewriter.h"
@@ -4,6 +4,8 @@ QT -= core gui
 
 CONFIG += C++11
 CONFIG += hide_symbols
+CONFIG += thread
+include( $$PWD/../libshvchainpack/rpcvalueflatmap.pri )
 
 TEMPLATE = lib
 TARGET = shvcore
@@ -23,6 +23,10 @@
 
 #define shvLogFuncFrame() nLogFuncFrame()
 
+/// log macros evaluate their arguments only when the topic is enabled,
+/// check the topic explicitly when some work is needed for logging before the log line itself
+#define shvCMessageEnabled(category) NecroLog::shouldLog(NecroLog::Level::Message, NecroLog::LogContext(__FILE__, __LINE__, category))
+
 #else
 
 #include "shvlog.h"
@@ -47,6 +51,8 @@ shv::core::ShvLog(shv::core::ShvLog::Level::Warning, shv::core::ShvLog::LogConte
 #define shvCError(category) for(bool en = shv::core::ShvLog::isMatchingLogFilter(shv::core::ShvLog::Level::Error, shv::core::ShvLog::LogContext{__FILE__, __LINE__, __FUNCTION__, category}); en; en = false) \
 shv::core::ShvLog(shv::core::ShvLog::Level::Error, shv::core::ShvLog::LogContext{__FILE__, __LINE__, __FUNCTION__, category})
 
+#define shvCMessageEnabled(category) shv::core::ShvLog::isMatchingLogFilter(shv::core::ShvLog::Level::Info, shv::core::ShvLog::LogContext{__FILE__, __LINE__, __FUNCTION__, category})
+
 #ifdef SHV_NO_DEBUG_LOG
 #define shvLogFuncFrame() while(0) shvDebug()
 #else
@@ -65,6 +71,7 @@ shvDebug() << ">>>> ENTER FN" << __FUNCTION__
 #define shvError() shvCError("")
 
 #define logRpcMsg() shvCMessage("RpcMsg")
+#define isLogRpcMsgEnabled() shvCMessageEnabled("RpcMsg")
 //.color(NecroLog::Color::LightGray)
 
 inline NecroLog &operator<<(NecroLog log, const shv::core::StringView &v) { return log.operator<<(v.toString()); }
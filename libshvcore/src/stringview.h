@@ -2,6 +2,8 @@
 
 #include "shvcoreglobal.h"
 
+#include <cstdint>
+#include <functional>
 #include <limits>
 #include <string>
 #include <vector>
@@ -88,3 +90,24 @@ public:
 
 } // namespace core
 } // namespace shv
+
+namespace std {
+
+/// allows to use StringView as key of unordered containers
+template<>
+struct hash<shv::core::StringView>
+{
+	size_t operator()(const shv::core::StringView &sv) const
+	{
+		// FNV-1a
+		uint64_t h = 14695981039346656037ULL;
+		const char *data = sv.str().data() + sv.start();
+		for (size_t i = 0; i < sv.length(); ++i) {
+			h ^= static_cast<unsigned char>(data[i]);
+			h *= 1099511628211ULL;
+		}
+		return static_cast<size_t>(h);
+	}
+};
+
+} // namespace std
@@ -1,6 +1,7 @@
 #include "abstractshvjournal.h"
 #include "shvjournalentry.h"
 #include "shvgetlogparams.h"
+#include "shvlogwriter.h"
 #include "shvpath.h"
 #include "../stringview.h"
 
@@ -24,6 +25,23 @@ AbstractShvJournal::~AbstractShvJournal()
 {
 }
 
+void AbstractShvJournal::getLog(const ShvGetLogParams &params, AbstractShvLogWriter &writer)
+{
+	chainpack::RpcValue log = getLog(params);
+	ShvLogHeader header = ShvLogHeader::fromMetaData(log.metaData());
+	writer.begin(header);
+	for(const chainpack::RpcValue &row : log.toList()) {
+		chainpack::RpcValue::List rec = row.toList();
+		if(rec.size() <= ShvLogHeader::Column::Path)
+			continue;
+		chainpack::RpcValue &path = rec[ShvLogHeader::Column::Path];
+		if(path.isInt())
+			path = header.pathDictCRef().value(path.toInt());
+		writer.append(std::move(rec));
+	}
+	writer.end(std::move(header));
+}
+
 chainpack::RpcValue AbstractShvJournal::getSnapShotMap()
 {
 	SHV_EXCEPTION("getSnapShot() not implemented");
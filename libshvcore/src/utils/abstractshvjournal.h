@@ -13,6 +13,7 @@ namespace utils {
 
 class ShvJournalEntry;
 class ShvGetLogParams;
+class AbstractShvLogWriter;
 
 class SHVCORE_DECL_EXPORT AbstractShvJournal
 {
@@ -28,6 +29,9 @@ public:
 
 	virtual void append(const ShvJournalEntry &entry) = 0;
 	virtual shv::chainpack::RpcValue getLog(const ShvGetLogParams &params) = 0;
+	/// streaming getLog(), records are passed to writer as they are produced,
+	/// default implementation builds whole log first
+	virtual void getLog(const ShvGetLogParams &params, AbstractShvLogWriter &writer);
 	virtual shv::chainpack::RpcValue getSnapShotMap();
 };
 
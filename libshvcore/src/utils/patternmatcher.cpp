@@ -10,6 +10,42 @@ namespace shv {
 namespace core {
 namespace utils {
 
+namespace {
+/// splits pattern to literals separated by '|', returns false if any of them contains regex special character
+bool split_literal_alternatives(const std::string &pattern, std::vector<std::string> &literals)
+{
+	static const std::string SPECIAL_CHARS = "\\^$.*+?()[]{}";
+	if(pattern.find_first_of(SPECIAL_CHARS) != std::string::npos)
+		return false;
+	for(const StringView &sv : StringView(pattern).split('|', StringView::KeepEmptyParts))
+		literals.push_back(sv.toString());
+	return true;
+}
+
+/// iterates over path segments without copying them, empty segments are skipped like in StringView::split()
+class PathSegments
+{
+public:
+	PathSegments(const std::string &path) : m_path(path) { next(); }
+
+	bool atEnd() const { return m_begin >= m_path.size(); }
+	bool operator==(const std::string &s) const { return s.size() == m_end - m_begin && m_path.compare(m_begin, m_end - m_begin, s) == 0; }
+	void next()
+	{
+		m_begin = m_end;
+		while(m_begin < m_path.size() && m_path[m_begin] == '/')
+			m_begin++;
+		m_end = m_begin;
+		while(m_end < m_path.size() && m_path[m_end] != '/')
+			m_end++;
+	}
+private:
+	const std::string &m_path;
+	size_t m_begin = 0;
+	size_t m_end = 0;
+};
+}
+
 PatternMatcher::PatternMatcher(const ShvGetLogParams &filter)
 {
 	shvLogFuncFrame() << "params:" << filter.toRpcValue().toCpon();
@@ -30,10 +66,25 @@ PatternMatcher::PatternMatcher(const ShvGetLogParams &filter)
 		else {
 			shvDebug() << "\t wildcard";
 			m_pathPatternWildCard = filter.pathPattern;
+			for(const StringView &sv : StringView(m_pathPatternWildCard).split('/')) {
+				PatternSegment seg;
+				if(sv == "*")
+					seg.type = PatternSegment::Type::AnySegment;
+				else if(sv == "**")
+					seg.type = PatternSegment::Type::AnySegments;
+				else
+					seg.type = PatternSegment::Type::Literal;
+				seg.text = sv.toString();
+				m_pathPatternSegments.push_back(std::move(seg));
+			}
 			shvDebug() << "\t\t OK";
 		}
 	}
-	if(!filter.domainPattern.empty()) try {
+	if(!filter.domainPattern.empty() && split_literal_alternatives(filter.domainPattern, m_domainPatternLiterals)) {
+		shvDebug() << "domain pattern:" << filter.domainPattern;
+		shvDebug() << "\t literals";
+	}
+	else if(!filter.domainPattern.empty()) try {
 		shvDebug() << "domain pattern:" << filter.domainPattern;
 		shvDebug() << "\t regex";
 		m_domainPatternRegEx = std::regex(filter.domainPattern);
@@ -58,26 +109,95 @@ bool PatternMatcher::match(const std::string &path, const std::string &domain) c
 		//shvDebug() << "empty filter matches ALL";
 		return true;
 	}
+	if(!matchPath(path))
+		return false;
+	return matchDomain(domain);
+}
+
+bool PatternMatcher::matchPath(const std::string &path) const
+{
 	if(m_usePathPatternRegEx) {
 		//shvDebug() << "using path pattern regex";
+		auto it = m_pathMatchCache.find(path);
+		if(it != m_pathMatchCache.end())
+			return it->second;
 		std::smatch cmatch;
-		if(!std::regex_search(path, cmatch, m_pathPatternRegEx))
-			return false;
+		bool ok = std::regex_search(path, cmatch, m_pathPatternRegEx);
+		if(m_pathMatchCache.size() < MAX_CACHE_SIZE)
+			m_pathMatchCache[path] = ok;
+		return ok;
 	}
-	else if(!m_pathPatternWildCard.empty()) {
+	if(!m_pathPatternWildCard.empty()) {
 		//shvDebug() << "using path pattern wildcard:" << m_pathPatternWildCard;
-		const shv::core::StringViewList path_lst = shv::core::StringView(path).split('/');
-		const shv::core::StringViewList pattern_lst = shv::core::StringView(m_pathPatternWildCard).split('/');
-		if(!ShvPath::matchWild(path_lst, pattern_lst))
-			return false;
+		return matchPathWildCard(path);
+	}
+	return true;
+}
+
+bool PatternMatcher::matchDomain(const std::string &domain) const
+{
+	if(!m_domainPatternLiterals.empty()) {
+		for(const std::string &s : m_domainPatternLiterals) {
+			if(s == domain)
+				return true;
+		}
+		return false;
 	}
 	if(m_useDomainPatternregEx) {
 		//shvDebug() << "using domain pattern regex";
-		return std::regex_match(domain, m_domainPatternRegEx);
+		auto it = m_domainMatchCache.find(domain);
+		if(it != m_domainMatchCache.end())
+			return it->second;
+		bool ok = std::regex_match(domain, m_domainPatternRegEx);
+		if(m_domainMatchCache.size() < MAX_CACHE_SIZE)
+			m_domainMatchCache[domain] = ok;
+		return ok;
 	}
 	return true;
 }
 
+bool PatternMatcher::matchPathWildCard(const std::string &path) const
+{
+	using Type = PatternSegment::Type;
+	const std::vector<PatternSegment> &pattern = m_pathPatternSegments;
+	size_t ptix = 0;
+	PathSegments ph(path);
+	while(true) {
+		if(ph.atEnd() && ptix == pattern.size())
+			return true;
+		if(ptix == pattern.size() && !ph.atEnd())
+			return false;
+		if(ph.atEnd() && ptix == pattern.size() - 1 && pattern[ptix].type == Type::AnySegments)
+			return true;
+		if(ph.atEnd() && ptix < pattern.size())
+			return false;
+		const PatternSegment &pt = pattern[ptix];
+		if(pt.type == Type::AnySegment) {
+			// match exactly one path segment
+		}
+		else if(pt.type == Type::AnySegments) {
+			// match zero or more path segments
+			ptix++;
+			if(ptix == pattern.size())
+				return true;
+			const std::string &pt2 = pattern[ptix].text;
+			do {
+				if(ph == pt2)
+					break;
+				ph.next();
+			} while(!ph.atEnd());
+			if(ph.atEnd())
+				return false;
+		}
+		else {
+			if(!(ph == pt.text))
+				return false;
+		}
+		ptix++;
+		ph.next();
+	}
+}
+
 }
 }
 }
@@ -6,28 +6,52 @@
 #include "shvjournalentry.h"
 
 #include <regex>
+#include <unordered_map>
 
 namespace shv {
 namespace core {
 namespace utils {
 
+/// Patterns are compiled in constructor, wildcard and literal patterns are matched without allocation.
+/// Regex match results are cached per distinct path and domain, so instance should not be shared between threads.
 class SHVCORE_DECL_EXPORT PatternMatcher
 {
 public:
 	PatternMatcher() {}
 	PatternMatcher(const ShvGetLogParams &filter);
-	bool isEmpty() const {return !isRegexError() && !m_usePathPatternRegEx && m_pathPatternWildCard.empty() && !m_useDomainPatternregEx;}
+	bool isEmpty() const {return !isRegexError() && !m_usePathPatternRegEx && m_pathPatternWildCard.empty() && !m_useDomainPatternregEx && m_domainPatternLiterals.empty();}
 	bool isRegexError() const {return  m_regexError;}
 	bool match(const ShvJournalEntry &entry) const;
 	bool match(const std::string &path, const std::string &domain) const;
+	/// path part of the filter only, domain is not checked
+	bool matchPath(const std::string &path) const;
+	bool isPathPatternEmpty() const {return !m_usePathPatternRegEx && m_pathPatternWildCard.empty();}
 
+	/// same result as ShvPath::matchWild() called on path and pattern split to segments
+	bool matchPathWildCard(const std::string &path) const;
 private:
+	bool matchDomain(const std::string &domain) const;
+private:
+	struct PatternSegment
+	{
+		enum class Type {Literal, AnySegment, AnySegments};
+		Type type;
+		std::string text;
+	};
+	static constexpr size_t MAX_CACHE_SIZE = 16 * 1024;
+
 	std::regex m_pathPatternRegEx;
 	bool m_usePathPatternRegEx = false;
 	std::string m_pathPatternWildCard;
+	std::vector<PatternSegment> m_pathPatternSegments;
 
 	std::regex m_domainPatternRegEx;
 	bool m_useDomainPatternregEx = false;
+	/// domain pattern consisting of literals separated by '|' is matched without regex
+	std::vector<std::string> m_domainPatternLiterals;
+
+	mutable std::unordered_map<std::string, bool> m_pathMatchCache;
+	mutable std::unordered_map<std::string, bool> m_domainMatchCache;
 
 	bool m_regexError = false;
 };
@@ -4,6 +4,7 @@
 #include "shvjournalfilewriter.h"
 #include "shvjournalfilereader.h"
 #include "shvlogheader.h"
+#include "shvlogwriter.h"
 #include "shvpath.h"
 
 #include "../log.h"
@@ -16,7 +17,11 @@
 #include <fstream>
 #include <sstream>
 #include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
 #include <regex>
+#include <thread>
 #include <dirent.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -132,6 +137,7 @@ static constexpr size_t SEC_SEP_POS = MIN_SEP_POS + 3;
 static constexpr size_t MSEC_SEP_POS = SEC_SEP_POS + 3;
 
 const std::string ShvFileJournal::FILE_EXT = ".log2";
+const std::string ShvFileJournal::INDEX_FILE_EXT = ".idx";
 
 ShvFileJournal::ShvFileJournal(std::string device_id, ShvFileJournal::SnapShotFn snf)
 	: m_snapShotFn(snf)
@@ -141,6 +147,10 @@ ShvFileJournal::ShvFileJournal(std::string device_id, ShvFileJournal::SnapShotFn
 	setDeviceId(device_id);
 }
 
+ShvFileJournal::~ShvFileJournal()
+{
+}
+
 //void ShvFileJournal::setDefaultAppendLogTSNowFn()
 //{
 //	m_appendLogTSNowFn = []() {return cp::RpcValue::DateTime::now().msecsSinceEpoch();};
@@ -150,6 +160,7 @@ void ShvFileJournal::setJournalDir(std::string s)
 {
 	if(s == m_journalContext.journalDir)
 		return;
+	m_fileWriter.reset();
 	shvInfo() << "Journal dir set to:" << s;
 	m_journalContext.journalDir = std::move(s);
 }
@@ -194,6 +205,7 @@ void ShvFileJournal::append(const ShvJournalEntry &entry)
 		logIShvJournal() << "Append to log failed, journal dir will be read again, SD card might be replaced:" << e.what();
 	}
 	try {
+		m_fileWriter.reset();
 		ensureJournalDir();
 		checkJournalContext_helper(true);
 		appendThrow(entry);
@@ -203,6 +215,20 @@ void ShvFileJournal::append(const ShvJournalEntry &entry)
 	}
 }
 
+void ShvFileJournal::setGroupCommit(size_t max_size, int64_t max_delay_msec)
+{
+	m_groupCommitSize = max_size;
+	m_groupCommitDelay = max_delay_msec;
+	if(m_fileWriter)
+		m_fileWriter->setGroupCommit(max_size, max_delay_msec);
+}
+
+void ShvFileJournal::sync()
+{
+	if(m_fileWriter)
+		m_fileWriter->sync();
+}
+
 void ShvFileJournal::appendThrow(const ShvJournalEntry &entry)
 {
 	shvLogFuncFrame();// << "last file no:" << lastFileNo();
@@ -229,7 +255,13 @@ void ShvFileJournal::appendThrow(const ShvJournalEntry &entry)
 	if(!m_journalContext.files.empty() && journal_file_start_msec < m_journalContext.files[m_journalContext.files.size() - 1])
 		SHV_EXCEPTION("Journal context corrupted!");
 
-	ShvJournalFileWriter wr(journalDir(), journal_file_start_msec, m_journalContext.recentTimeStamp);
+	if(!m_fileWriter || m_fileWriterStartMsec != journal_file_start_msec) {
+		m_fileWriter.reset();
+		m_fileWriter.reset(new ShvJournalFileWriter(journalDir(), journal_file_start_msec, m_journalContext.recentTimeStamp));
+		m_fileWriter->setGroupCommit(m_groupCommitSize, m_groupCommitDelay);
+		m_fileWriterStartMsec = journal_file_start_msec;
+	}
+	ShvJournalFileWriter &wr = *m_fileWriter;
 	ssize_t orig_fsz = wr.fileSize();
 	if(orig_fsz == 0) {
 		logMShvJournal() << "New log file:" << wr.fileName() << "created.";
@@ -338,6 +370,7 @@ bool ShvFileJournal::journalDirExists()
 void ShvFileJournal::rotateJournal()
 {
 	logMShvJournal() << "Rotating journal of size:" << m_journalContext.journalSize;
+	m_fileWriter.reset();
 	updateJournalFiles();
 	size_t file_sz = m_journalContext.files.size();
 	size_t file_cnt = m_journalContext.files.size();
@@ -351,6 +384,7 @@ void ShvFileJournal::rotateJournal()
 		std::string fn = m_journalContext.fileMsecToFilePath(file_msec);
 		logMShvJournal() << "\t deleting file:" << fn;
 		m_journalContext.journalSize -= rm_file(fn);
+		SHV_REMOVE_FILE((fn + INDEX_FILE_EXT).c_str());
 		file_sz--;
 		file_cnt--;
 	}
@@ -598,6 +632,8 @@ int64_t ShvFileJournal::findLastEntryDateTime(const std::string &fn, ssize_t *p_
 
 const ShvFileJournal::JournalContext &ShvFileJournal::checkJournalContext()
 {
+	// buffered records are written, journal file is reopened on next append then, SD card might be replaced
+	m_fileWriter.reset();
 	try {
 		checkJournalContext_helper();
 	}
@@ -611,7 +647,13 @@ const ShvFileJournal::JournalContext &ShvFileJournal::checkJournalContext()
 chainpack::RpcValue ShvFileJournal::getLog(const ShvGetLogParams &params)
 {
 	JournalContext ctx = checkJournalContext();
-	return getLog(ctx, params);
+	return getLog(ctx, params, m_getLogThreadCount);
+}
+
+void ShvFileJournal::getLog(const ShvGetLogParams &params, AbstractShvLogWriter &writer)
+{
+	JournalContext ctx = checkJournalContext();
+	getLog(ctx, params, writer, m_getLogThreadCount);
 }
 
 chainpack::RpcValue ShvFileJournal::getSnapShotMap()
@@ -628,38 +670,187 @@ chainpack::RpcValue ShvFileJournal::getSnapShotMap()
 	return m;
 }
 
-chainpack::RpcValue ShvFileJournal::getLog(const ShvFileJournal::JournalContext &journal_context, const ShvGetLogParams &params)
+namespace {
+/// Entries of journal file needed by getLog, records older than since are kept for snapshot only.
+/// File reading ends on first record not older than until or when max_cnt records are found.
+std::vector<ShvJournalEntry> read_file_entries(const std::string &fn, const ShvGetLogParams &params, const PatternMatcher &pattern_matcher, bool seek, size_t max_cnt)
+{
+	const auto since_msec = params.since.isDateTime()? params.since.toDateTime().msecsSinceEpoch(): 0;
+	const auto until_msec = params.until.isDateTime()? params.until.toDateTime().msecsSinceEpoch(): 0;
+	std::vector<ShvJournalEntry> ret;
+	ShvJournalFileReader rd(fn);
+	if(seek)
+		rd.seek(since_msec);
+	size_t cnt = 0;
+	while(rd.next()) {
+		const ShvJournalEntry &e = rd.entry();
+		if(!params.pathPattern.empty() && !pattern_matcher.match(e.path, e.domain))
+			continue;
+		if(since_msec > 0 && e.epochMsec < since_msec) {
+			if(params.withSnapshot && e.sampleType == ShvJournalEntry::SampleType::Continuous)
+				ret.push_back(e);
+			continue;
+		}
+		ret.push_back(e);
+		// one record over the limit lets consumer detect limit hit
+		if((until_msec > 0 && e.epochMsec >= until_msec) || ++cnt > max_cnt)
+			break;
+	}
+	return ret;
+}
+
+/// Parses and filters journal files in worker threads, entries are taken in file order.
+/// Workers parse at most 2 * thread_count files ahead of consumer to keep memory usage bounded.
+class ParallelFileReader
+{
+public:
+	ParallelFileReader(const ShvFileJournal::JournalContext &journal_context, const ShvGetLogParams &params, std::vector<int64_t> files, int thread_count, size_t max_file_entry_count)
+		: m_journalContext(journal_context)
+		, m_params(params)
+		, m_files(std::move(files))
+		, m_results(m_files.size())
+		, m_maxFileEntryCount(max_file_entry_count)
+		, m_readAhead(2 * static_cast<size_t>(thread_count))
+	{
+		size_t n = std::min(static_cast<size_t>(thread_count), m_files.size());
+		for (size_t i = 0; i < n; ++i)
+			m_threads.emplace_back(&ParallelFileReader::run, this);
+	}
+	~ParallelFileReader()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stop = true;
+		}
+		m_cond.notify_all();
+		for(std::thread &t : m_threads)
+			t.join();
+	}
+
+	size_t fileCount() const { return m_files.size(); }
+	/// waits until file ix is parsed, exception thrown by parser is rethrown here
+	std::vector<ShvJournalEntry> takeFileEntries(size_t ix)
+	{
+		FileResult res;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cond.wait(lock, [this, ix]() { return m_results[ix].done; });
+			res = std::move(m_results[ix]);
+			m_takenCount = ix + 1;
+		}
+		m_cond.notify_all();
+		if(res.error)
+			std::rethrow_exception(res.error);
+		return std::move(res.entries);
+	}
+private:
+	struct FileResult
+	{
+		bool done = false;
+		std::vector<ShvJournalEntry> entries;
+		std::exception_ptr error;
+	};
+	void run()
+	{
+		const auto since_msec = m_params.since.isDateTime()? m_params.since.toDateTime().msecsSinceEpoch(): 0;
+		PatternMatcher pattern_matcher(m_params);
+		while(true) {
+			size_t ix;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_cond.wait(lock, [this]() { return m_stop || m_nextFile >= m_files.size() || m_nextFile < m_takenCount + m_readAhead; });
+				if(m_stop || m_nextFile >= m_files.size())
+					return;
+				ix = m_nextFile++;
+			}
+			FileResult res;
+			try {
+				std::string fn = m_journalContext.fileMsecToFilePath(m_files[ix]);
+				logDShvJournal() << "-------- parsing file:" << fn;
+				bool seek = since_msec > 0 && !m_params.withSnapshot && m_files[ix] < since_msec;
+				res.entries = read_file_entries(fn, m_params, pattern_matcher, seek, m_maxFileEntryCount);
+			}
+			catch (...) {
+				res.error = std::current_exception();
+			}
+			res.done = true;
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_results[ix] = std::move(res);
+			}
+			m_cond.notify_all();
+		}
+	}
+private:
+	const ShvFileJournal::JournalContext &m_journalContext;
+	const ShvGetLogParams &m_params;
+	std::vector<int64_t> m_files;
+	std::vector<FileResult> m_results;
+	size_t m_maxFileEntryCount;
+	size_t m_readAhead;
+	size_t m_nextFile = 0;
+	size_t m_takenCount = 0;
+	bool m_stop = false;
+	std::mutex m_mutex;
+	std::condition_variable m_cond;
+	std::vector<std::thread> m_threads;
+};
+}
+
+chainpack::RpcValue ShvFileJournal::getLog(const ShvFileJournal::JournalContext &journal_context, const ShvGetLogParams &params, int thread_count)
+{
+	ShvLogRpcValueWriter writer;
+	getLog(journal_context, params, writer, thread_count);
+	return writer.result();
+}
+
+void ShvFileJournal::getLog(const ShvFileJournal::JournalContext &journal_context, const ShvGetLogParams &params, AbstractShvLogWriter &writer, int thread_count)
 {
 	logIShvJournal() << "========================= getLog ==================";
 	logIShvJournal() << "params:" << params.toRpcValue().toCpon();
 	std::map<std::string, ShvJournalEntry> snapshot;
-	cp::RpcValue::List log;
 
-	cp::RpcValue::Map path_cache;
 	const auto params_since_msec = params.since.isDateTime()? params.since.toDateTime().msecsSinceEpoch(): 0;
 	const auto params_until_msec = params.until.isDateTime()? params.until.toDateTime().msecsSinceEpoch(): 0;
-	int64_t journal_start_msec = 0;
+	const int64_t journal_start_msec = journal_context.files.empty()? 0: journal_context.files.front();
 	int64_t first_record_msec = 0;
 	int64_t last_record_msec = 0;
+	int rec_cnt = 0;
 	int rec_cnt_limit = std::min(params.recordCountLimit, DEFAULT_GET_LOG_RECORD_COUNT_LIMIT);
 	bool rec_cnt_limit_hit = false;
 
-	/// this ensure that there be only one copy of each path in memory
-	int max_path_id = 0;
-	auto make_path_shared = [&path_cache, &max_path_id, &params](const std::string &path) -> cp::RpcValue {
-		cp::RpcValue ret = path_cache.value(path);
-		if(ret.isValid())
-			return ret;
-		if(params.withPathsDict)
-			ret = ++max_path_id;
-		else
-			ret = path;
-		logMShvJournal() << "Adding record to path cache:" << path << "-->" << ret.toCpon();
-		path_cache[path] = ret;
-		return ret;
-	};
-	auto append_log_entry = [make_path_shared, rec_cnt_limit, &rec_cnt_limit_hit, &first_record_msec, &last_record_msec, &log](const ShvJournalEntry &e) {
-		if((int)log.size() >= rec_cnt_limit) {
+	int64_t log_since_msec = params_since_msec;
+	if(log_since_msec < journal_start_msec) {
+		log_since_msec = journal_start_msec;
+	}
+	ShvLogHeader log_header;
+	{
+		log_header.setDeviceId(journal_context.deviceId);
+		log_header.setDeviceType(journal_context.deviceType);
+		log_header.setDateTime(cp::RpcValue::DateTime::now());
+		log_header.setLogParams(params);
+		log_header.setSince((log_since_msec > 0)? cp::RpcValue(cp::RpcValue::DateTime::fromMSecsSinceEpoch(log_since_msec)): cp::RpcValue(nullptr));
+		log_header.setRecordCountLimit(rec_cnt_limit);
+		log_header.setWithSnapShot(params.withSnapshot);
+		log_header.setWithPathsDict(params.withPathsDict);
+
+		using Column = ShvLogHeader::Column;
+		cp::RpcValue::List fields;
+		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Timestamp)}});
+		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Path)}});
+		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Value)}});
+		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::ShortTime)}});
+		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Domain)}});
+		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::SampleType)}});
+		log_header.setFields(std::move(fields));
+	}
+	if(params.withTypeInfo) {
+		log_header.setTypeInfo(journal_context.typeInfo);
+	}
+	writer.begin(log_header);
+
+	auto append_log_entry = [rec_cnt_limit, &rec_cnt, &rec_cnt_limit_hit, &first_record_msec, &last_record_msec, &writer](const ShvJournalEntry &e) {
+		if(rec_cnt >= rec_cnt_limit) {
 			rec_cnt_limit_hit = true;
 			return false;
 		}
@@ -668,13 +859,14 @@ chainpack::RpcValue ShvFileJournal::getLog(const ShvFileJournal::JournalContext
 		last_record_msec = e.epochMsec;
 		cp::RpcValue::List rec;
 		rec.push_back(e.dateTime());
-		rec.push_back(make_path_shared(e.path));
+		rec.push_back(e.path);
 		rec.push_back(e.value);
 		rec.push_back(e.shortTime == ShvJournalEntry::NO_SHORT_TIME? cp::RpcValue(nullptr): cp::RpcValue(e.shortTime));
 		rec.push_back((e.domain.empty() || e.domain == cp::Rpc::SIG_VAL_CHANGED)? cp::RpcValue(nullptr): e.domain);
 		rec.push_back((int)e.sampleType);
 		rec.push_back(e.userId.empty()? cp::RpcValue(nullptr): cp::RpcValue(e.userId));
-		log.push_back(std::move(rec));
+		writer.append(std::move(rec));
+		rec_cnt++;
 		return true;
 	};
 	auto write_snapshot = [append_log_entry, &snapshot]() {
@@ -704,7 +896,6 @@ chainpack::RpcValue ShvFileJournal::getLog(const ShvFileJournal::JournalContext
 	*/
 	if(journal_context.files.size()) {
 		std::vector<int64_t>::const_iterator file_it = journal_context.files.begin();
-		journal_start_msec = *file_it;
 		if(params_since_msec > 0) {
 			logDShvJournal() << "since:" << params.since.toCpon() << "msec:" << params_since_msec;
 			file_it = std::lower_bound(journal_context.files.begin(), journal_context.files.end(), params_since_msec);
@@ -733,39 +924,55 @@ chainpack::RpcValue ShvFileJournal::getLog(const ShvFileJournal::JournalContext
 		//	append_data_missing(journal_start_msec, false);
 		//}
 
-		PatternMatcher pattern_matcher(params);
-		for(; file_it != journal_context.files.end(); file_it++) {
-			std::string fn = journal_context.fileMsecToFilePath(*file_it);
-			logDShvJournal() << "-------- opening file:" << fn;
-			ShvJournalFileReader rd(fn);
-			while(rd.next()) {
-				const ShvJournalEntry &e = rd.entry();
-				if(!params.pathPattern.empty()) {
-					logDShvJournal() << "\t MATCHING:" << params.pathPattern << "vs:" << e.path;
-					if(!pattern_matcher.match(e.path, e.domain))
-						continue;
-					logDShvJournal() << "\t\t MATCH";
-				}
-				if(params_since_msec > 0 && e.epochMsec < params_since_msec) {
-					if(params.withSnapshot) {
-						if(e.sampleType == ShvJournalEntry::SampleType::Continuous) {
-							ShvJournalEntry e2 = e;
-							e2.epochMsec = params_since_msec;
-							snapshot[e2.path] = std::move(e2);
-						}
+		/// returns false when log is complete
+		auto process_entry = [&](const ShvJournalEntry &e) {
+			if(params_since_msec > 0 && e.epochMsec < params_since_msec) {
+				if(params.withSnapshot) {
+					if(e.sampleType == ShvJournalEntry::SampleType::Continuous) {
+						ShvJournalEntry e2 = e;
+						e2.epochMsec = params_since_msec;
+						snapshot[e2.path] = std::move(e2);
 					}
 				}
-				else {
-					if(params.withSnapshot)
-						if(!write_snapshot())
-							goto log_finish;
-					if(params_until_msec == 0 || e.epochMsec < params_until_msec) { // keep interval open to make log merge simpler
-						if(!append_log_entry(e))
-							goto log_finish;
-					}
-					else {
+				return true;
+			}
+			if(params.withSnapshot)
+				if(!write_snapshot())
+					return false;
+			if(params_until_msec == 0 || e.epochMsec < params_until_msec) { // keep interval open to make log merge simpler
+				return append_log_entry(e);
+			}
+			return false;
+		};
+		if(thread_count > 1 && journal_context.files.end() - file_it > 1) {
+			ParallelFileReader rd(journal_context, params, std::vector<int64_t>(file_it, journal_context.files.end()), thread_count, static_cast<size_t>(rec_cnt_limit));
+			for(size_t i = 0; i < rd.fileCount(); ++i) {
+				for(const ShvJournalEntry &e : rd.takeFileEntries(i)) {
+					if(!process_entry(e))
 						goto log_finish;
+				}
+			}
+		}
+		else {
+			PatternMatcher pattern_matcher(params);
+			for(; file_it != journal_context.files.end(); file_it++) {
+				std::string fn = journal_context.fileMsecToFilePath(*file_it);
+				logDShvJournal() << "-------- opening file:" << fn;
+				ShvJournalFileReader rd(fn);
+				if(params_since_msec > 0 && !params.withSnapshot && *file_it < params_since_msec) {
+					// records older than since are needed for snapshot only
+					rd.seek(params_since_msec);
+				}
+				while(rd.next()) {
+					const ShvJournalEntry &e = rd.entry();
+					if(!params.pathPattern.empty()) {
+						logDShvJournal() << "\t MATCHING:" << params.pathPattern << "vs:" << e.path;
+						if(!pattern_matcher.match(e.path, e.domain))
+							continue;
+						logDShvJournal() << "\t\t MATCH";
 					}
+					if(!process_entry(e))
+						goto log_finish;
 				}
 			}
 		}
@@ -778,53 +985,14 @@ log_finish:
 		write_snapshot();
 	}
 
-	int64_t log_since_msec = params_since_msec;
-	if(log_since_msec < journal_start_msec) {
-		log_since_msec = journal_start_msec;
-	}
 	int64_t log_until_msec = params_until_msec;
 	if(params_until_msec == 0 || rec_cnt_limit_hit) {
 		log_until_msec = last_record_msec;
 	}
-	cp::RpcValue ret = log;
-	ShvLogHeader log_header;
-	{
-		log_header.setDeviceId(journal_context.deviceId);
-		log_header.setDeviceType(journal_context.deviceType);
-		log_header.setDateTime(cp::RpcValue::DateTime::now());
-		log_header.setLogParams(params);
-		log_header.setSince((log_since_msec > 0)? cp::RpcValue(cp::RpcValue::DateTime::fromMSecsSinceEpoch(log_since_msec)): cp::RpcValue(nullptr));
-		log_header.setUntil((log_until_msec > 0)? cp::RpcValue(cp::RpcValue::DateTime::fromMSecsSinceEpoch(log_until_msec)): cp::RpcValue(nullptr));
-		log_header.setRecordCount((int)log.size());
-		log_header.setRecordCountLimit(rec_cnt_limit);
-		log_header.setRecordCountLimitHit(rec_cnt_limit_hit);
-		log_header.setWithSnapShot(params.withSnapshot);
-		log_header.setWithPathsDict(params.withPathsDict);
-
-		using Column = ShvLogHeader::Column;
-		cp::RpcValue::List fields;
-		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Timestamp)}});
-		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Path)}});
-		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Value)}});
-		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::ShortTime)}});
-		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Domain)}});
-		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::SampleType)}});
-		log_header.setFields(std::move(fields));
-	}
-	if(params.withPathsDict) {
-		logIShvJournal() << "Generating paths dict";
-		cp::RpcValue::IMap path_dict;
-		for(auto kv : path_cache) {
-			//logIShvJournal() << "Adding record to paths dict:" << kv.second.toInt() << "-->" << kv.first;
-			path_dict[kv.second.toInt()] = kv.first;
-		}
-		log_header.setPathDict(std::move(path_dict));
-	}
-	if(params.withTypeInfo) {
-		log_header.setTypeInfo(journal_context.typeInfo);
-	}
-	ret.setMetaData(log_header.toMetaData());
-	return ret;
+	log_header.setUntil((log_until_msec > 0)? cp::RpcValue(cp::RpcValue::DateTime::fromMSecsSinceEpoch(log_until_msec)): cp::RpcValue(nullptr));
+	log_header.setRecordCount(rec_cnt);
+	log_header.setRecordCountLimitHit(rec_cnt_limit_hit);
+	writer.end(std::move(log_header));
 }
 
 const char *ShvFileJournal::TxtColumn::name(ShvFileJournal::TxtColumn::Enum e)
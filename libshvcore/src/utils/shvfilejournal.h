@@ -8,11 +8,14 @@
 #include "shvgetlogparams.h"
 
 #include <functional>
+#include <memory>
 
 namespace shv {
 namespace core {
 namespace utils {
 
+class ShvJournalFileWriter;
+
 class SHVCORE_DECL_EXPORT ShvFileJournal : public AbstractShvJournal
 {
 public:
@@ -21,11 +24,16 @@ public:
 	static constexpr char FIELD_SEPARATOR = '\t';
 	static constexpr char RECORD_SEPARATOR = '\n';
 	static const std::string FILE_EXT;
+	/// sidecar time index of journal file is stored in file name + INDEX_FILE_EXT
+	static const std::string INDEX_FILE_EXT;
+	/// time index contains timestamp and position of every record crossing multiple of INDEX_STRIDE bytes
+	static constexpr int64_t INDEX_STRIDE = 16 * 1024;
 public:
 	using SnapShotFn = std::function<void (std::vector<ShvJournalEntry>&)>;
 	using TSNowFn = std::function<int64_t ()>;
 
 	ShvFileJournal(std::string device_id, SnapShotFn snf);
+	~ShvFileJournal() override;
 
 	void setJournalDir(std::string s);
 	const std::string& journalDir();
@@ -43,13 +51,31 @@ public:
 	void setDeviceType(std::string type) { m_journalContext.deviceType = std::move(type); }
 
 	static int64_t findLastEntryDateTime(const std::string &fn, ssize_t *p_date_time_fpos = nullptr);
+	static bool isIndexedRecord(int64_t record_fpos, int64_t record_end_fpos)
+	{
+		return (record_fpos + INDEX_STRIDE - 1) / INDEX_STRIDE * INDEX_STRIDE < record_end_fpos;
+	}
 	void append(const ShvJournalEntry &entry) override;
+	/// appended records are buffered and written to the journal file when max_size bytes are buffered,
+	/// oldest buffered record is older than max_delay_msec or sync() is called,
+	/// max_size == 0 (default) writes every record immediately,
+	/// buffered records are lost on crash, see ShvJournalFileWriter::setGroupCommit()
+	void setGroupCommit(size_t max_size, int64_t max_delay_msec);
+	/// write buffered records to the journal file, checkJournalContext() and getLog() do it too
+	void sync();
 
 	// testing purposes
 	//void setAppendLogTSNowFn(TSNowFn fn) { m_appendLogTSNowFn = fn; }
 	//void setDefaultAppendLogTSNowFn();
 
+	/// getLog() blocks calling thread till the log is read, even if files are parsed by worker threads,
+	/// there is no async variant, the journal is appended, indexed and rotated by the owning thread,
+	/// and reads from other thread would not be synchronized with it
 	shv::chainpack::RpcValue getLog(const ShvGetLogParams &params) override;
+	void getLog(const ShvGetLogParams &params, AbstractShvLogWriter &writer) override;
+	/// journal files are parsed by thread_count worker threads in getLog() if thread_count > 1
+	void setGetLogThreadCount(int n) {m_getLogThreadCount = n;}
+	int getLogThreadCount() const {return m_getLogThreadCount;}
 	shv::chainpack::RpcValue getSnapShotMap() override;
 
 	void convertLog1JournalDir();
@@ -89,7 +115,8 @@ public:
 		std::string fileMsecToFilePath(int64_t file_msec) const;
 	};
 	const JournalContext& checkJournalContext();
-	static shv::chainpack::RpcValue getLog(const JournalContext &journal_context, const ShvGetLogParams &params);
+	static shv::chainpack::RpcValue getLog(const JournalContext &journal_context, const ShvGetLogParams &params, int thread_count = 1);
+	static void getLog(const JournalContext &journal_context, const ShvGetLogParams &params, AbstractShvLogWriter &writer, int thread_count = 1);
 private:
 
 	void checkJournalContext_helper(bool force = false);
@@ -109,6 +136,12 @@ private:
 	SnapShotFn m_snapShotFn;
 	int64_t m_fileSizeLimit = DEFAULT_FILE_SIZE_LIMIT;
 	int64_t m_journalSizeLimit = DEFAULT_JOURNAL_SIZE_LIMIT;
+	int m_getLogThreadCount = 1;
+	size_t m_groupCommitSize = 0;
+	int64_t m_groupCommitDelay = 0;
+	/// writer of the last journal file is kept open between appends
+	std::unique_ptr<ShvJournalFileWriter> m_fileWriter;
+	int64_t m_fileWriterStartMsec = 0;
 
 	// we need custom DateTime::now() fn for testing purposes
 	//TSNowFn m_appendLogTSNowFn;
@@ -0,0 +1,223 @@
+#include "shvjournalbinfilereader.h"
+#include "shvjournalbinfilewriter.h"
+
+#include "../exception.h"
+#include "../log.h"
+
+#include <shv/chainpack/chainpackreader.h>
+
+#define logWShvJournal() shvCWarning("ShvJournal")
+#define logDShvJournal() shvCDebug("ShvJournal")
+
+namespace cp = shv::chainpack;
+
+namespace shv {
+namespace core {
+namespace utils {
+
+namespace {
+using Key = ShvJournalBinFileWriter::Key;
+
+/// block columns in order of ShvJournalBinFileReader::m_columnReaders
+const Key::Enum COLUMN_KEYS[] = {Key::TimeDeltas, Key::PathIds, Key::DomainIds, Key::UserIdIds, Key::ShortTimes, Key::SampleTypes, Key::Values};
+enum Column {TimeDeltas = 0, PathIds, DomainIds, UserIdIds, ShortTimes, SampleTypes, Values, COLUMN_CNT};
+static_assert(sizeof(COLUMN_KEYS) / sizeof(COLUMN_KEYS[0]) == COLUMN_CNT, "Column keys and column indexes mismatch");
+
+bool dict_string(const cp::RpcValue::List &dict, uint64_t id, std::string &s)
+{
+	if(id >= dict.size())
+		return false;
+	s = dict[id].asString();
+	return true;
+}
+}
+
+ShvJournalBinFileReader::ShvJournalBinFileReader(const std::string &file_name)
+	: m_fileName(file_name)
+{
+	m_ifstream.open(file_name, std::ios::binary);
+	if(!m_ifstream)
+		SHV_EXCEPTION("Cannot open file " + file_name + " for reading.");
+	cp::RpcValue header;
+	if(!readChunk(header)
+			|| header.at(Key::Format).asString() != ShvJournalBinFileWriter::FORMAT_NAME
+			|| header.at(Key::Version).toInt() != ShvJournalBinFileWriter::FORMAT_VERSION)
+		SHV_EXCEPTION("File " + file_name + " is not binary journal file.");
+}
+
+ShvJournalBinFileReader::~ShvJournalBinFileReader()
+{
+}
+
+bool ShvJournalBinFileReader::next()
+{
+	m_currentEntry = ShvJournalEntry();
+	while(m_blockRecordIndex >= m_blockRecordCount) {
+		if(!readBlock())
+			return false;
+	}
+	m_blockRecordIndex++;
+	if(decodeRecord())
+		return true;
+	logWShvJournal() << m_fileName << "corrupted block, rest of the file will be ignored";
+	m_currentEntry = ShvJournalEntry();
+	m_blockRecordCount = 0;
+	m_ifstream.setstate(std::ios::eofbit);
+	return false;
+}
+
+bool ShvJournalBinFileReader::last()
+{
+	// chunks are length prefixed, skip to the last one without decoding
+	m_ifstream.clear();
+	int64_t file_size = fileSize();
+	m_ifstream.seekg(0, std::ios::beg);
+	int64_t last_chunk_pos = -1;
+	while(true) {
+		int64_t pos = m_ifstream.tellg();
+		uint64_t len;
+		if(!readChunkLength(len))
+			break;
+		if(static_cast<int64_t>(m_ifstream.tellg()) + static_cast<int64_t>(len) > file_size) {
+			logWShvJournal() << m_fileName << "truncated block at:" << pos << "will be ignored";
+			break;
+		}
+		m_ifstream.seekg(static_cast<std::streamoff>(len), std::ios::cur);
+		last_chunk_pos = pos;
+	}
+	m_blockRecordCount = 0;
+	m_blockRecordIndex = 0;
+	m_ifstream.clear();
+	if(last_chunk_pos > 0) {
+		m_ifstream.seekg(last_chunk_pos, std::ios::beg);
+		bool ok = readBlock();
+		while(ok && m_blockRecordIndex < m_blockRecordCount) {
+			m_blockRecordIndex++;
+			ok = decodeRecord();
+		}
+		if(ok && m_blockRecordCount > 0)
+			return true;
+	}
+	m_currentEntry = ShvJournalEntry();
+	return false;
+}
+
+const ShvJournalEntry &ShvJournalBinFileReader::entry()
+{
+	return m_currentEntry;
+}
+
+int64_t ShvJournalBinFileReader::fileSize()
+{
+	const std::streampos pos = m_ifstream.tellg();
+	m_ifstream.seekg(0, std::ios::end);
+	const int64_t ret = m_ifstream.tellg();
+	m_ifstream.seekg(pos);
+	return ret;
+}
+
+bool ShvJournalBinFileReader::readChunkLength(uint64_t &len)
+{
+	if(m_ifstream.peek() == std::char_traits<char>::eof())
+		return false;
+	bool ok;
+	len = cp::ChainPackReader::readUIntData(m_ifstream, &ok);
+	if(!ok)
+		logWShvJournal() << m_fileName << "invalid chunk length";
+	return ok;
+}
+
+bool ShvJournalBinFileReader::readChunk(cp::RpcValue &val)
+{
+	uint64_t len;
+	if(!readChunkLength(len))
+		return false;
+	// length is not trusted, corrupted one would cause huge allocation
+	const int64_t pos = m_ifstream.tellg();
+	if(pos < 0 || static_cast<uint64_t>(fileSize() - pos) < len) {
+		logWShvJournal() << m_fileName << "truncated or corrupted chunk at:" << pos << "rest of the file will be ignored";
+		m_ifstream.setstate(std::ios::eofbit);
+		return false;
+	}
+	std::string data(len, '\0');
+	m_ifstream.read(&data[0], static_cast<std::streamsize>(len));
+	if(static_cast<uint64_t>(m_ifstream.gcount()) != len) {
+		logWShvJournal() << m_fileName << "truncated chunk, rest of the file will be ignored";
+		return false;
+	}
+	std::string err;
+	val = cp::RpcValue::fromChainPack(data, &err);
+	if(!err.empty()) {
+		logWShvJournal() << m_fileName << "invalid chunk:" << err << "rest of the file will be ignored";
+		return false;
+	}
+	return true;
+}
+
+bool ShvJournalBinFileReader::readBlock()
+{
+	m_blockRecordCount = 0;
+	m_blockRecordIndex = 0;
+	m_columnReaders.clear();
+	if(!readChunk(m_block))
+		return false;
+	const cp::RpcValue::IMap &block = m_block.asIMap();
+	auto it = block.find(Key::RecordCount);
+	if(it == block.end()) {
+		logWShvJournal() << m_fileName << "chunk is not records block, rest of the file will be ignored";
+		return false;
+	}
+	for(Key::Enum key : COLUMN_KEYS) {
+		auto col_it = block.find(key);
+		if(col_it == block.end() || !col_it->second.isBlob()) {
+			logWShvJournal() << m_fileName << "block column:" << key << "missing, rest of the file will be ignored";
+			return false;
+		}
+		// column data are owned by m_block
+		const cp::RpcValue::Blob &data = col_it->second.asBlob();
+		m_columnReaders.emplace_back(new cp::ChainPackReader(reinterpret_cast<const char*>(data.data()), data.size()));
+	}
+	m_pathDict = &m_block.at(Key::PathDict).asList();
+	m_domainDict = &m_block.at(Key::DomainDict).asList();
+	m_userIdDict = &m_block.at(Key::UserIdDict).asList();
+	m_prevMsec = m_block.at(Key::StartMsec).toInt64();
+	m_blockRecordCount = it->second.toInt();
+	logDShvJournal() << m_fileName << "block of:" << m_blockRecordCount << "records";
+	return true;
+}
+
+bool ShvJournalBinFileReader::decodeRecord()
+{
+	bool ok = true;
+	auto read_uint = [this, &ok](Column col) -> uint64_t {
+		bool ok2;
+		uint64_t n = m_columnReaders[col]->readUIntData(&ok2);
+		ok = ok && ok2;
+		return n;
+	};
+	ShvJournalEntry &e = m_currentEntry;
+	m_prevMsec += ShvJournalBinFileWriter::zigZagDecode(read_uint(TimeDeltas));
+	e.epochMsec = m_prevMsec;
+	ok = dict_string(*m_pathDict, read_uint(PathIds), e.path) && ok;
+	ok = dict_string(*m_domainDict, read_uint(DomainIds), e.domain) && ok;
+	ok = dict_string(*m_userIdDict, read_uint(UserIdIds), e.userId) && ok;
+	uint64_t short_time = read_uint(ShortTimes);
+	e.shortTime = short_time == 0? ShvJournalEntry::NO_SHORT_TIME: static_cast<int>(short_time - 1);
+	e.sampleType = static_cast<ShvJournalEntry::SampleType>(read_uint(SampleTypes));
+	if (e.sampleType == ShvJournalEntry::SampleType::Invalid)
+		e.sampleType = ShvJournalEntry::SampleType::Continuous;
+	if(!ok)
+		return false;
+	try {
+		m_columnReaders[Values]->read(e.value);
+	}
+	catch (cp::ChainPackReader::ParseException &ex) {
+		logWShvJournal() << m_fileName << "invalid value:" << ex.what();
+		return false;
+	}
+	return true;
+}
+
+} // namespace utils
+} // namespace core
+} // namespace shv
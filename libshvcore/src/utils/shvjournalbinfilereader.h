@@ -0,0 +1,52 @@
+#pragma once
+
+#include "../shvcoreglobal.h"
+#include "shvjournalentry.h"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace shv {
+namespace chainpack { class ChainPackReader; }
+namespace core {
+namespace utils {
+
+/// Reader of binary journal files (.log3) written by ShvJournalBinFileWriter
+///
+/// Whole block is read from the file at once, records are decoded from block columns one by one in next().
+class SHVCORE_DECL_EXPORT ShvJournalBinFileReader
+{
+public:
+	ShvJournalBinFileReader(const std::string &file_name);
+	~ShvJournalBinFileReader();
+
+	bool next();
+	bool last();
+	const ShvJournalEntry& entry();
+private:
+	/// current size, file can grow when it is appended by writer
+	int64_t fileSize();
+	bool readChunkLength(uint64_t &len);
+	bool readChunk(shv::chainpack::RpcValue &val);
+	bool readBlock();
+	bool decodeRecord();
+private:
+	std::string m_fileName;
+	std::ifstream m_ifstream;
+	ShvJournalEntry m_currentEntry;
+
+	shv::chainpack::RpcValue m_block;
+	int m_blockRecordCount = 0;
+	int m_blockRecordIndex = 0;
+	int64_t m_prevMsec = 0;
+	const shv::chainpack::RpcValue::List *m_pathDict = nullptr;
+	const shv::chainpack::RpcValue::List *m_domainDict = nullptr;
+	const shv::chainpack::RpcValue::List *m_userIdDict = nullptr;
+	std::vector<std::unique_ptr<shv::chainpack::ChainPackReader>> m_columnReaders;
+};
+
+} // namespace utils
+} // namespace core
+} // namespace shv
@@ -0,0 +1,179 @@
+#include "shvjournalbinfilewriter.h"
+#include "shvjournalentry.h"
+#include "shvjournalfilereader.h"
+#include "../exception.h"
+#include "../log.h"
+
+#include <shv/chainpack/chainpack.h>
+#include <shv/chainpack/chainpackwriter.h>
+#include <shv/chainpack/rpc.h>
+
+#define logWShvJournal() shvCWarning("ShvJournal")
+
+namespace cp = shv::chainpack;
+
+namespace shv {
+namespace core {
+namespace utils {
+
+constexpr int ShvJournalBinFileWriter::FORMAT_VERSION;
+constexpr int ShvJournalBinFileWriter::DEFAULT_BLOCK_RECORD_COUNT;
+
+namespace {
+void append_uint_data(std::string &out, uint64_t n)
+{
+	char buff[16];
+	ccpcp_pack_context ctx;
+	ccpcp_pack_context_init(&ctx, buff, sizeof(buff), nullptr);
+	cchainpack_pack_uint_data(&ctx, n);
+	out.append(buff, static_cast<size_t>(ctx.current - ctx.start));
+}
+
+cp::RpcValue::Blob to_blob(const std::string &data)
+{
+	return cp::RpcValue::Blob(data.begin(), data.end());
+}
+}
+
+const std::string ShvJournalBinFileWriter::FILE_EXT = ".log3";
+const std::string ShvJournalBinFileWriter::FORMAT_NAME = "shvjournal";
+
+uint64_t ShvJournalBinFileWriter::Dictionary::id(const std::string &s)
+{
+	auto it = ids.find(s);
+	if(it != ids.end())
+		return it->second;
+	uint64_t id = strings.size();
+	ids[s] = id;
+	strings.push_back(s);
+	return id;
+}
+
+ShvJournalBinFileWriter::ShvJournalBinFileWriter(const std::string &file_name, int block_record_count)
+	: m_fileName(file_name)
+	, m_blockRecordCount(block_record_count > 0? block_record_count: DEFAULT_BLOCK_RECORD_COUNT)
+{
+	open();
+	clearBlock();
+}
+
+ShvJournalBinFileWriter::~ShvJournalBinFileWriter()
+{
+	try {
+		flush();
+	}
+	catch (std::exception &e) {
+		logWShvJournal() << "Cannot write pending records to:" << m_fileName << e.what();
+	}
+}
+
+void ShvJournalBinFileWriter::open()
+{
+	m_out.open(m_fileName, std::ios::binary | std::ios::out | std::ios::app | std::ios::ate);
+	if(!m_out)
+		SHV_EXCEPTION("Cannot open file " + m_fileName + " for writing");
+	if(fileSize() == 0) {
+		writeChunk(cp::RpcValue::IMap{
+					   {Key::Format, FORMAT_NAME},
+					   {Key::Version, FORMAT_VERSION},
+				   });
+		m_out.flush();
+	}
+}
+
+ssize_t ShvJournalBinFileWriter::fileSize()
+{
+	return m_out.tellp();
+}
+
+void ShvJournalBinFileWriter::append(const ShvJournalEntry &entry)
+{
+	int64_t msec = entry.epochMsec;
+	if(msec == 0)
+		msec = cp::RpcValue::DateTime::now().msecsSinceEpoch();
+	if(m_recordCount == 0) {
+		m_startMsec = msec;
+		m_prevMsec = msec;
+	}
+	append_uint_data(m_timeDeltas, zigZagEncode(msec - m_prevMsec));
+	m_prevMsec = msec;
+	append_uint_data(m_pathIds, m_pathDict.id(entry.path));
+	// same domain normalization as in .log2 files
+	append_uint_data(m_domainIds, m_domainDict.id(entry.domain == cp::Rpc::SIG_VAL_CHANGED? ShvJournalEntry::DOMAIN_VAL_CHANGE: entry.domain));
+	append_uint_data(m_userIdIds, m_userIdDict.id(entry.userId));
+	append_uint_data(m_shortTimes, entry.shortTime >= 0? static_cast<uint64_t>(entry.shortTime) + 1: 0);
+	append_uint_data(m_sampleTypes, static_cast<uint64_t>(entry.sampleType));
+	m_valuesWriter->write(entry.value);
+	m_recentTimeStamp = msec;
+	if(++m_recordCount >= m_blockRecordCount)
+		flush();
+}
+
+void ShvJournalBinFileWriter::flush()
+{
+	if(m_recordCount == 0)
+		return;
+	m_valuesWriter->flush();
+	writeChunk(cp::RpcValue::IMap{
+				   {Key::RecordCount, m_recordCount},
+				   {Key::StartMsec, m_startMsec},
+				   {Key::PathDict, std::move(m_pathDict.strings)},
+				   {Key::DomainDict, std::move(m_domainDict.strings)},
+				   {Key::UserIdDict, std::move(m_userIdDict.strings)},
+				   {Key::TimeDeltas, to_blob(m_timeDeltas)},
+				   {Key::PathIds, to_blob(m_pathIds)},
+				   {Key::DomainIds, to_blob(m_domainIds)},
+				   {Key::UserIdIds, to_blob(m_userIdIds)},
+				   {Key::ShortTimes, to_blob(m_shortTimes)},
+				   {Key::SampleTypes, to_blob(m_sampleTypes)},
+				   {Key::Values, to_blob(m_values)},
+			   });
+	m_out.flush();
+	clearBlock();
+}
+
+void ShvJournalBinFileWriter::writeChunk(const chainpack::RpcValue &val)
+{
+	std::string data = val.toChainPack();
+	std::string len;
+	append_uint_data(len, data.size());
+	m_out.write(len.data(), static_cast<std::streamsize>(len.size()));
+	m_out.write(data.data(), static_cast<std::streamsize>(data.size()));
+	if(!m_out)
+		SHV_EXCEPTION("Error writing file " + m_fileName);
+}
+
+void ShvJournalBinFileWriter::clearBlock()
+{
+	m_recordCount = 0;
+	m_pathDict.clear();
+	m_domainDict.clear();
+	m_userIdDict.clear();
+	m_timeDeltas.clear();
+	m_pathIds.clear();
+	m_domainIds.clear();
+	m_userIdIds.clear();
+	m_shortTimes.clear();
+	m_sampleTypes.clear();
+	// writer keeps pointers to the string buffer, it must be recreated
+	m_valuesWriter.reset();
+	m_values.clear();
+	m_valuesWriter.reset(new cp::ChainPackWriter(m_values));
+}
+
+int64_t ShvJournalBinFileWriter::convertLog2File(const std::string &log2_file_name, const std::string &log3_file_name)
+{
+	ShvJournalFileReader rd(log2_file_name);
+	ShvJournalBinFileWriter wr(log3_file_name);
+	int64_t cnt = 0;
+	while(rd.next()) {
+		wr.append(rd.entry());
+		cnt++;
+	}
+	wr.flush();
+	return cnt;
+}
+
+} // namespace utils
+} // namespace core
+} // namespace shv
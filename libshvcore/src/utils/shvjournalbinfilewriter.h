@@ -0,0 +1,108 @@
+#pragma once
+
+#include "../shvcoreglobal.h"
+
+#include <shv/chainpack/rpcvalue.h>
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace shv {
+namespace chainpack { class ChainPackWriter; }
+namespace core {
+namespace utils {
+
+class ShvJournalEntry;
+
+/// Writer of binary journal files (.log3)
+///
+/// File consists of chunks, every chunk is ChainPack UInt data length followed by ChainPack IMap of that length.
+/// First chunk is file header, other chunks are blocks of records. Block keeps records column wise,
+/// paths, domains and user IDs are replaced by indexes into block local dictionaries,
+/// timestamps are zig-zag encoded deltas from previous record and values are packed as ChainPack.
+/// Every block is self contained, so records can be appended to existing file.
+class SHVCORE_DECL_EXPORT ShvJournalBinFileWriter
+{
+public:
+	static const std::string FILE_EXT;
+	static const std::string FORMAT_NAME;
+	static constexpr int FORMAT_VERSION = 3;
+	static constexpr int DEFAULT_BLOCK_RECORD_COUNT = 1024;
+
+	struct Key
+	{
+		enum Enum {
+			// file header
+			Format = 1,
+			Version,
+			// block
+			RecordCount,
+			StartMsec,
+			PathDict,
+			DomainDict,
+			UserIdDict,
+			TimeDeltas,
+			PathIds,
+			DomainIds,
+			UserIdIds,
+			ShortTimes,
+			SampleTypes,
+			Values,
+		};
+	};
+public:
+	ShvJournalBinFileWriter(const std::string &file_name, int block_record_count = DEFAULT_BLOCK_RECORD_COUNT);
+	~ShvJournalBinFileWriter();
+
+	void append(const ShvJournalEntry &entry);
+	/// write pending records to the file
+	void flush();
+
+	ssize_t fileSize();
+	const std::string& fileName() const { return m_fileName; }
+	int64_t recentTimeStamp() const { return m_recentTimeStamp; }
+
+	/// append all the records of .log2 file to .log3 file, returns number of records converted
+	static int64_t convertLog2File(const std::string &log2_file_name, const std::string &log3_file_name);
+
+	static uint64_t zigZagEncode(int64_t n) { return (static_cast<uint64_t>(n) << 1) ^ static_cast<uint64_t>(n >> 63); }
+	static int64_t zigZagDecode(uint64_t n) { return static_cast<int64_t>(n >> 1) ^ -static_cast<int64_t>(n & 1); }
+private:
+	struct Dictionary
+	{
+		std::unordered_map<std::string, uint64_t> ids;
+		shv::chainpack::RpcValue::List strings;
+
+		uint64_t id(const std::string &s);
+		void clear() { ids.clear(); strings.clear(); }
+	};
+	void open();
+	void writeChunk(const shv::chainpack::RpcValue &val);
+	void clearBlock();
+private:
+	std::string m_fileName;
+	std::ofstream m_out;
+	int m_blockRecordCount;
+	int64_t m_recentTimeStamp = 0;
+
+	int m_recordCount = 0;
+	int64_t m_startMsec = 0;
+	int64_t m_prevMsec = 0;
+	Dictionary m_pathDict;
+	Dictionary m_domainDict;
+	Dictionary m_userIdDict;
+	std::string m_timeDeltas;
+	std::string m_pathIds;
+	std::string m_domainIds;
+	std::string m_userIdIds;
+	std::string m_shortTimes;
+	std::string m_sampleTypes;
+	std::string m_values;
+	std::unique_ptr<shv::chainpack::ChainPackWriter> m_valuesWriter;
+};
+
+} // namespace utils
+} // namespace core
+} // namespace shv
@@ -7,6 +7,8 @@
 #include "../stringview.h"
 #include "../string.h"
 
+#include <algorithm>
+
 #define logWShvJournal() shvCWarning("ShvJournal")
 #define logIShvJournal() shvCInfo("ShvJournal")
 #define logMShvJournal() shvCMessage("ShvJournal")
@@ -85,9 +87,10 @@ bool ShvJournalFileReader::next()
 			m_currentEntry.sampleType = ShvJournalEntry::SampleType::Continuous;
 		m_currentEntry.userId = line_record.value(Column::UserId).toString();
 		std::string err;
-		m_currentEntry.value = cp::RpcValue::fromCpon(line_record.value(Column::Value).toString(), &err);
+		StringView value_sv = line_record.value(Column::Value);
+		m_currentEntry.value = cp::RpcValue::fromCpon(value_sv.str().data() + value_sv.start(), value_sv.length(), &err);
 		if(!err.empty())
-			logWShvJournal() << "Invalid CPON value:" << line_record.value(Column::Value).toString();
+			logWShvJournal() << "Invalid CPON value:" << value_sv.toString();
 		return true;
 	}
 }
@@ -107,6 +110,68 @@ bool ShvJournalFileReader::last()
 	}
 }
 
+void ShvJournalFileReader::seek(int64_t msec)
+{
+	m_ifstream.clear();
+	m_ifstream.seekg(0, std::ios::end);
+	int64_t file_size = m_ifstream.tellg();
+	Index index = readIndex(m_fileName);
+	if(index.empty() || index.back().second >= file_size) {
+		logMShvJournal() << "time index of file:" << m_fileName << "is missing or invalid, rebuilding it";
+		index = rebuildIndex(m_fileName);
+	}
+	// last indexed record older than msec, all the records before it are older too
+	auto it = std::lower_bound(index.begin(), index.end(), msec, [](const Index::value_type &v, int64_t ms) {
+		return v.first < ms;
+	});
+	int64_t fpos = (it == index.begin())? 0: (it - 1)->second;
+	logDShvJournal() << "seek:" << msec << "file:" << m_fileName << "pos:" << fpos;
+	m_currentEntry = ShvJournalEntry();
+	m_ifstream.seekg(fpos, std::ios::beg);
+}
+
+ShvJournalFileReader::Index ShvJournalFileReader::readIndex(const std::string &file_name)
+{
+	Index ret;
+	std::ifstream in(file_name + ShvFileJournal::INDEX_FILE_EXT, std::ios::binary);
+	int64_t msec, fpos;
+	while(in >> msec >> fpos) {
+		if(!ret.empty() && fpos <= ret.back().second) {
+			logWShvJournal() << "invalid time index of file:" << file_name;
+			return Index();
+		}
+		ret.emplace_back(msec, fpos);
+	}
+	if(!ret.empty() && ret.front().second != 0)
+		return Index(); // index was not created with the file
+	return ret;
+}
+
+ShvJournalFileReader::Index ShvJournalFileReader::rebuildIndex(const std::string &file_name)
+{
+	Index ret;
+	ShvJournalFileReader rd(file_name);
+	rd.m_ifstream.seekg(0, std::ios::end);
+	int64_t file_size = rd.m_ifstream.tellg();
+	rd.m_ifstream.seekg(0, std::ios::beg);
+	while(true) {
+		int64_t fpos = rd.m_ifstream.tellg();
+		if(fpos < 0 || !rd.next())
+			break;
+		int64_t end_fpos = rd.m_ifstream.tellg();
+		if(end_fpos < 0)
+			end_fpos = file_size;
+		if(ShvFileJournal::isIndexedRecord(fpos, end_fpos))
+			ret.emplace_back(rd.entry().epochMsec, fpos);
+	}
+	std::ofstream out(file_name + ShvFileJournal::INDEX_FILE_EXT, std::ios::binary | std::ios::out | std::ios::trunc);
+	for(const auto &kv : ret)
+		out << kv.first << ShvFileJournal::FIELD_SEPARATOR << kv.second << ShvFileJournal::RECORD_SEPARATOR;
+	if(!out)
+		logWShvJournal() << "Cannot write index file:" << file_name + ShvFileJournal::INDEX_FILE_EXT;
+	return ret;
+}
+
 const ShvJournalEntry &ShvJournalFileReader::entry()
 {
 	return m_currentEntry;
@@ -7,6 +7,8 @@
 
 #include <string>
 #include <fstream>
+#include <utility>
+#include <vector>
 
 namespace shv {
 namespace core {
@@ -21,7 +23,15 @@ public:
 
 	bool next();
 	bool last();
+	/// Move read position close before first record with timestamp >= msec using sidecar time index,
+	/// index is rebuilt if it is missing. Records in file must be ordered by timestamp.
+	void seek(int64_t msec);
 	const ShvJournalEntry& entry();
+
+	/// pairs (record msec, record file position)
+	using Index = std::vector<std::pair<int64_t, int64_t>>;
+	static Index readIndex(const std::string &file_name);
+	static Index rebuildIndex(const std::string &file_name);
 private:
 	std::string m_fileName;
 	std::ifstream m_ifstream;
@@ -3,8 +3,11 @@
 #include "../exception.h"
 #include "../log.h"
 
+#include <shv/chainpack/cponwriter.h>
 #include <shv/chainpack/rpc.h>
 
+#include <time.h>
+
 namespace cp = shv::chainpack;
 
 namespace shv {
@@ -13,11 +16,26 @@ namespace utils {
 
 static int uptimeSec()
 {
-	int uptime;
-	if (std::ifstream("/proc/uptime", std::ios::in) >> uptime) {
-		return uptime;
-	}
+#ifdef CLOCK_BOOTTIME
+	// same clock as /proc/uptime, without opening and parsing the file for every record
+	struct timespec ts;
+	if(clock_gettime(CLOCK_BOOTTIME, &ts) == 0)
+		return static_cast<int>(ts.tv_sec);
 	return 0;
+#else
+	// /proc/uptime is read once, monotonic clock is used then
+	static const auto start = std::chrono::steady_clock::now();
+	static const int start_uptime = []() {
+		int uptime;
+		if (std::ifstream("/proc/uptime", std::ios::in) >> uptime) {
+			return uptime;
+		}
+		return 0;
+	}();
+	if(start_uptime == 0)
+		return 0;
+	return start_uptime + static_cast<int>(std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - start).count());
+#endif
 }
 
 ShvJournalFileWriter::ShvJournalFileWriter(const std::string &file_name)
@@ -33,16 +51,49 @@ ShvJournalFileWriter::ShvJournalFileWriter(const std::string &journal_dir, int64
 	open();
 }
 
+ShvJournalFileWriter::~ShvJournalFileWriter()
+{
+	stopFlushThread();
+	try {
+		sync();
+	}
+	catch (std::exception &e) {
+		shvWarning() << "Cannot write buffered records to:" << m_fileName << e.what();
+	}
+}
+
 void ShvJournalFileWriter::open()
 {
 	m_out.open(m_fileName, std::ios::binary | std::ios::out | std::ios::app);
 	if(!m_out)
 		SHV_EXCEPTION("Cannot open file " + m_fileName + " for writing");
+	m_fileSize = m_out.tellp();
 }
 
-ssize_t ShvJournalFileWriter::fileSize()
+void ShvJournalFileWriter::setGroupCommit(size_t max_size, int64_t max_delay_msec)
 {
-	return m_out.tellp();
+	bool needs_flush_thread = max_size > 0 && max_delay_msec > 0;
+	if(!needs_flush_thread)
+		stopFlushThread();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_groupCommitSize = max_size;
+		m_groupCommitDelay = max_delay_msec;
+		if(m_buffer.size() >= m_groupCommitSize)
+			sync_helper();
+	}
+	if(needs_flush_thread) {
+		if(m_flushThread.joinable())
+			m_flushCondition.notify_one();
+		else
+			m_flushThread = std::thread(&ShvJournalFileWriter::flushThreadLoop, this);
+	}
+}
+
+ssize_t ShvJournalFileWriter::fileSize() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return fileSize_helper();
 }
 
 void ShvJournalFileWriter::appendMonotonic(const ShvJournalEntry &entry)
@@ -71,30 +122,143 @@ void ShvJournalFileWriter::append(const ShvJournalEntry &entry)
 	append(msec, 0, entry);
 }
 
+void ShvJournalFileWriter::appendIsoTime(int64_t msec)
+{
+	// same format as DateTime::toIsoString(), date time part is formatted once per second
+	int64_t sec = msec / 1000;
+	if(sec != m_isoTimeSecond) {
+		m_isoTime = cp::RpcValue::DateTime::fromMSecsSinceEpoch(sec * 1000).toIsoString(cp::RpcValue::DateTime::MsecPolicy::Never, false);
+		m_isoTimeSecond = sec;
+	}
+	m_buffer += m_isoTime;
+	int ms = static_cast<int>(msec % 1000);
+	if(ms > 0) {
+		char buff[] = {'.', static_cast<char>('0' + ms / 100), static_cast<char>('0' + ms / 10 % 10), static_cast<char>('0' + ms % 10)};
+		m_buffer.append(buff, sizeof(buff));
+	}
+	m_buffer += 'Z';
+}
+
 void ShvJournalFileWriter::append(int64_t msec, int uptime, const ShvJournalEntry &entry)
 {
-	m_out << cp::RpcValue::DateTime::fromMSecsSinceEpoch(msec).toIsoString();
-	m_out << ShvFileJournal::FIELD_SEPARATOR;
-	m_out << uptime;
-	m_out << ShvFileJournal::FIELD_SEPARATOR;
-	m_out << entry.path;
-	m_out << ShvFileJournal::FIELD_SEPARATOR;
-	m_out << entry.value.toCpon();
-	m_out << ShvFileJournal::FIELD_SEPARATOR;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	ssize_t fpos = fileSize_helper();
+	bool buffer_was_empty = m_buffer.empty();
+	if(buffer_was_empty)
+		m_bufferStart = std::chrono::steady_clock::now();
+	appendIsoTime(msec);
+	m_buffer += ShvFileJournal::FIELD_SEPARATOR;
+	m_buffer += std::to_string(uptime);
+	m_buffer += ShvFileJournal::FIELD_SEPARATOR;
+	m_buffer += entry.path;
+	m_buffer += ShvFileJournal::FIELD_SEPARATOR;
+	{
+		// value is packed directly to the end of buffer
+		cp::CponWriter wr(m_buffer);
+		wr << entry.value;
+	}
+	m_buffer += ShvFileJournal::FIELD_SEPARATOR;
 	if(entry.shortTime >= 0)
-		m_out << entry.shortTime;
-	m_out << ShvFileJournal::FIELD_SEPARATOR;
+		m_buffer += std::to_string(entry.shortTime);
+	m_buffer += ShvFileJournal::FIELD_SEPARATOR;
 	if(entry.domain == cp::Rpc::SIG_VAL_CHANGED)
-		m_out << ShvJournalEntry::DOMAIN_VAL_CHANGE;
+		m_buffer += ShvJournalEntry::DOMAIN_VAL_CHANGE;
 	else
-		m_out << entry.domain;
-	m_out << ShvFileJournal::FIELD_SEPARATOR;
-	m_out << (int)entry.sampleType;
-	m_out << ShvFileJournal::FIELD_SEPARATOR;
-	m_out << entry.userId;
-	m_out << ShvFileJournal::RECORD_SEPARATOR;
-	m_out.flush();
+		m_buffer += entry.domain;
+	m_buffer += ShvFileJournal::FIELD_SEPARATOR;
+	m_buffer += std::to_string((int)entry.sampleType);
+	m_buffer += ShvFileJournal::FIELD_SEPARATOR;
+	m_buffer += entry.userId;
+	m_buffer += ShvFileJournal::RECORD_SEPARATOR;
 	m_recentTimeStamp = msec;
+	if(ShvFileJournal::isIndexedRecord(fpos, fileSize_helper())) {
+		m_indexBuffer += std::to_string(msec);
+		m_indexBuffer += ShvFileJournal::FIELD_SEPARATOR;
+		m_indexBuffer += std::to_string(fpos);
+		m_indexBuffer += ShvFileJournal::RECORD_SEPARATOR;
+	}
+	if(m_buffer.size() >= m_groupCommitSize
+			|| (m_groupCommitDelay > 0 && std::chrono::steady_clock::now() - m_bufferStart >= std::chrono::milliseconds(m_groupCommitDelay)))
+		sync_helper();
+	else if(buffer_was_empty && m_flushThread.joinable())
+		m_flushCondition.notify_one();
+}
+
+void ShvJournalFileWriter::sync()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	sync_helper();
+}
+
+void ShvJournalFileWriter::sync_helper()
+{
+	if(m_buffer.empty())
+		return;
+	bool file_was_empty = m_fileSize == 0;
+	m_out.write(m_buffer.data(), static_cast<std::streamsize>(m_buffer.size()));
+	m_out.flush();
+	size_t len = m_buffer.size();
+	m_buffer.clear();
+	if(!m_out) {
+		m_indexBuffer.clear();
+		SHV_EXCEPTION("Error writing file " + m_fileName);
+	}
+	m_fileSize += static_cast<ssize_t>(len);
+	appendIndex(file_was_empty);
+}
+
+void ShvJournalFileWriter::stopFlushThread()
+{
+	if(!m_flushThread.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopFlushThread = true;
+	}
+	m_flushCondition.notify_one();
+	m_flushThread.join();
+	m_stopFlushThread = false;
+}
+
+void ShvJournalFileWriter::flushThreadLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while(!m_stopFlushThread) {
+		if(m_buffer.empty()) {
+			// woken up by first buffered record
+			m_flushCondition.wait(lock);
+			continue;
+		}
+		auto deadline = m_bufferStart + std::chrono::milliseconds(m_groupCommitDelay);
+		if(std::chrono::steady_clock::now() < deadline) {
+			m_flushCondition.wait_until(lock, deadline);
+			continue;
+		}
+		try {
+			sync_helper();
+		}
+		catch (std::exception &e) {
+			// stream is in error state, next append reports it to the journal
+			shvWarning() << "Cannot write buffered records to:" << m_fileName << e.what();
+		}
+	}
+}
+
+void ShvJournalFileWriter::appendIndex(bool new_file)
+{
+	if(m_indexBuffer.empty())
+		return;
+	std::string fn = m_fileName + ShvFileJournal::INDEX_FILE_EXT;
+	if(!new_file && !std::ifstream(fn)) {
+		// file was created without index, it will be rebuilt by ShvJournalFileReader::seek()
+		m_indexBuffer.clear();
+		return;
+	}
+	std::ofstream out(fn, std::ios::binary | std::ios::out | std::ios::app);
+	out.write(m_indexBuffer.data(), static_cast<std::streamsize>(m_indexBuffer.size()));
+	m_indexBuffer.clear();
+	if(!out)
+		shvWarning() << "Cannot write index file:" << fn;
 }
 
 } // namespace utils
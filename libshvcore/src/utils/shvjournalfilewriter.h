@@ -2,8 +2,12 @@
 
 #include "../shvcoreglobal.h"
 
+#include <chrono>
+#include <condition_variable>
 #include <string>
 #include <fstream>
+#include <mutex>
+#include <thread>
 
 namespace shv {
 namespace core {
@@ -16,20 +20,54 @@ class SHVCORE_DECL_EXPORT ShvJournalFileWriter
 public:
 	ShvJournalFileWriter(const std::string &file_name);
 	ShvJournalFileWriter(const std::string &journal_dir, int64_t journal_start_time, int64_t last_entry_ts);
+	~ShvJournalFileWriter();
 
 	void appendMonotonic(const ShvJournalEntry &entry);
 	void append(const ShvJournalEntry &entry);
 
-	ssize_t fileSize();
+	/// Records are written to the file when max_size bytes are buffered, oldest buffered record is older than max_delay_msec
+	/// or sync() is called, max_size == 0 writes every record immediately.
+	/// Delay is checked by background thread, so buffered records are written even if nothing is appended.
+	/// Buffered records are lost if the process crashes, it is up to max_size bytes and max_delay_msec of records,
+	/// they are written by destructor on regular exit. Use max_size == 0 where every record must survive a crash.
+	void setGroupCommit(size_t max_size, int64_t max_delay_msec);
+	/// write buffered records to the file
+	void sync();
+
+	/// size including buffered records
+	ssize_t fileSize() const;
 	const std::string& fileName() const { return m_fileName; }
 	int64_t recentTimeStamp() const { return m_recentTimeStamp; }
 private:
 	void open();
 	void append(int64_t msec, int uptime, const ShvJournalEntry &entry);
+	void appendIsoTime(int64_t msec);
+	void appendIndex(bool new_file);
+	ssize_t fileSize_helper() const { return m_fileSize + static_cast<ssize_t>(m_buffer.size()); }
+	void sync_helper();
+	void stopFlushThread();
+	void flushThreadLoop();
 private:
 	std::string m_fileName;
 	std::ofstream m_out;
+	ssize_t m_fileSize = 0;
 	int64_t m_recentTimeStamp = 0;
+
+	/// records not written to the file yet, buffer is reused to avoid allocation per record
+	std::string m_buffer;
+	std::string m_indexBuffer;
+	size_t m_groupCommitSize = 0;
+	int64_t m_groupCommitDelay = 0;
+	std::chrono::steady_clock::time_point m_bufferStart;
+	/// guards buffers and file, they are written by flush thread too
+	mutable std::mutex m_mutex;
+	std::condition_variable m_flushCondition;
+	std::thread m_flushThread;
+	bool m_stopFlushThread = false;
+
+	/// date time string without msec part of the second m_isoTimeSecond
+	int64_t m_isoTimeSecond = -1;
+	std::string m_isoTime;
 };
 
 } // namespace utils
@@ -1,18 +1,26 @@
 #include "shvlogfilereader.h"
 #include "shvjournalentry.h"
 #include "shvfilejournal.h"
+#include "shvlogwriter.h"
 
 #include "../exception.h"
 #include "../string.h"
 #include "../log.h"
 #include "../stringview.h"
 
+#include <fstream>
+
 #define logWShvJournal() shvCWarning("ShvJournal")
 #define logIShvJournal() shvCInfo("ShvJournal")
 #define logDShvJournal() shvCDebug("ShvJournal")
 
 namespace cp = shv::chainpack;
 
+namespace {
+// log file is unpacked in chunks of this size, memory use does not depend on file size
+constexpr size_t READ_AHEAD_SIZE = 64 * 1024;
+}
+
 namespace shv {
 namespace core {
 namespace utils {
@@ -28,9 +36,11 @@ ShvLogFileReader::ShvLogFileReader(const std::string &file_name)
 	m_readerCreated = true;
 	m_ifstream = new std::ifstream;
 	m_ifstream->open(file_name, std::ios::binary);
-	if(!m_ifstream)
+	if(!*m_ifstream) {
+		delete m_ifstream;
 		SHV_EXCEPTION("Cannot open file " + file_name + " for reading.");
-	m_reader = new shv::chainpack::ChainPackReader(*m_ifstream);
+	}
+	m_reader = new shv::chainpack::ChainPackReader(*m_ifstream, READ_AHEAD_SIZE);
 	init();
 }
 
@@ -48,10 +58,8 @@ void ShvLogFileReader::init()
 ShvLogFileReader::~ShvLogFileReader()
 {
 	if(m_readerCreated) {
-		if(m_reader)
-			delete m_reader;
-		if(m_ifstream)
-			delete m_ifstream;
+		delete m_reader;
+		delete m_ifstream;
 	}
 }
 
@@ -60,7 +68,7 @@ bool ShvLogFileReader::next()
 	using Column = ShvLogHeader::Column;
 	while(true) {
 		m_currentEntry = ShvJournalEntry();
-		if(!m_ifstream)
+		if(!m_reader)
 			return false;
 		chainpack::ChainPackReader::ItemType tt = m_reader->peekNext();
 		//logDShvJournal() << "peek next type:" << chainpack::ChainPackReader::itemTypeToString(tt);
@@ -69,6 +77,11 @@ bool ShvLogFileReader::next()
 
 		cp::RpcValue val;
 		m_reader->read(val);
+		if(ShvLogStreamWriter::isTrailer(val)) {
+			// streamed log, final header is sent after the last record
+			m_logHeader = ShvLogHeader::fromMetaData(val.metaData());
+			continue;
+		}
 		const chainpack::RpcValue::List &row = val.toList();
 		cp::RpcValue dt = row.value(Column::Timestamp);
 		if(!dt.isDateTime()) {
@@ -79,6 +92,8 @@ bool ShvLogFileReader::next()
 		cp::RpcValue p = row.value(Column::Path);
 		if(p.isInt())
 			p = m_logHeader.pathDictCRef().value(p.toInt());
+		else if(p.isString() && m_logHeader.withPathsDict())
+			m_logHeader.pathDictRef()[static_cast<int>(m_logHeader.pathDictCRef().size()) + 1] = p;
 		const std::string &path = p.asString();
 		if(path.empty()) {
 			logWShvJournal() << "Path dictionary corrupted, row:" << val.toCpon();
@@ -18,6 +18,8 @@ namespace utils {
 
 class ShvJournalEntry;
 
+/// Reads ChainPack log record by record, logs streamed by ShvLogStreamWriter are supported,
+/// their logHeader() is complete after next() returns false
 class SHVCORE_DECL_EXPORT ShvLogFileReader
 {
 public:
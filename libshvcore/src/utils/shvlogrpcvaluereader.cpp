@@ -1,4 +1,5 @@
 #include "shvlogrpcvaluereader.h"
+#include "shvlogwriter.h"
 
 #include "../exception.h"
 #include "../log.h"
@@ -33,6 +34,10 @@ bool ShvLogRpcValueReader::next()
 			return false;
 
 		const cp::RpcValue &val = list[m_currentIndex++];
+		if(ShvLogStreamWriter::isTrailer(val)) {
+			m_logHeader = ShvLogHeader::fromMetaData(val.metaData());
+			continue;
+		}
 		const chainpack::RpcValue::List &row = val.toList();
 		cp::RpcValue dt = row.value(Column::Timestamp);
 		if(!dt.isDateTime()) {
@@ -46,6 +51,8 @@ bool ShvLogRpcValueReader::next()
 		cp::RpcValue p = row.value(Column::Path);
 		if(p.isInt())
 			p = m_logHeader.pathDictCRef().value(p.toInt());
+		else if(p.isString() && m_logHeader.withPathsDict())
+			m_logHeader.pathDictRef()[static_cast<int>(m_logHeader.pathDictCRef().size()) + 1] = p;
 		const std::string &path = p.asString();
 		if(path.empty()) {
 			if(m_isThrowExceptions)
@@ -0,0 +1,127 @@
+#include "shvlogwriter.h"
+#include "shvpathdictionary.h"
+
+#include "../log.h"
+
+#include <shv/chainpack/chainpackwriter.h>
+
+#define logMShvJournal() shvCMessage("ShvJournal")
+
+namespace cp = shv::chainpack;
+
+namespace shv {
+namespace core {
+namespace utils {
+
+//===========================================================
+// AbstractShvLogWriter
+//===========================================================
+AbstractShvLogWriter::~AbstractShvLogWriter()
+{
+}
+
+chainpack::RpcValue AbstractShvLogWriter::pathValue(const chainpack::RpcValue &path, bool with_paths_dict, bool *is_new)
+{
+	cp::RpcValue *cached;
+	if(m_pathDictionary && !path.isString()) {
+		size_t id = static_cast<size_t>(path.toUInt());
+		if(id >= m_pathCacheById.size())
+			m_pathCacheById.resize(id + 1);
+		cached = &m_pathCacheById[id];
+	}
+	else {
+		cached = &m_pathCache[path.asString()];
+	}
+	if(is_new)
+		*is_new = !cached->isValid();
+	if(cached->isValid())
+		return *cached;
+	const std::string &path_str = pathString(path);
+	if(with_paths_dict) {
+		*cached = ++m_maxPathId;
+		m_pathDict[m_maxPathId] = path_str;
+	}
+	else {
+		*cached = path_str;
+	}
+	logMShvJournal() << "Adding record to path cache:" << path_str << "-->" << cached->toCpon();
+	return *cached;
+}
+
+const std::string &AbstractShvLogWriter::pathString(const chainpack::RpcValue &path) const
+{
+	if(m_pathDictionary && !path.isString())
+		return m_pathDictionary->string(static_cast<uint32_t>(path.toUInt()));
+	return path.asString();
+}
+
+//===========================================================
+// ShvLogRpcValueWriter
+//===========================================================
+void ShvLogRpcValueWriter::begin(const ShvLogHeader &header)
+{
+	m_withPathsDict = header.withPathsDict();
+	m_log.clear();
+}
+
+void ShvLogRpcValueWriter::append(chainpack::RpcValue::List &&rec)
+{
+	cp::RpcValue &path = rec[ShvLogHeader::Column::Path];
+	path = pathValue(path, m_withPathsDict);
+	m_log.push_back(std::move(rec));
+}
+
+void ShvLogRpcValueWriter::end(ShvLogHeader &&header)
+{
+	if(m_withPathsDict)
+		header.setPathDict(pathDict());
+	m_result = cp::RpcValue(std::move(m_log));
+	m_log = cp::RpcValue::List();
+	m_result.setMetaData(header.toMetaData());
+}
+
+//===========================================================
+// ShvLogStreamWriter
+//===========================================================
+ShvLogStreamWriter::ShvLogStreamWriter(chainpack::ChainPackWriter &out)
+	: m_out(out)
+{
+}
+
+void ShvLogStreamWriter::begin(const ShvLogHeader &header)
+{
+	m_withPathsDict = header.withPathsDict();
+	m_out.write(header.toMetaData());
+	m_out.writeContainerBegin(cp::RpcValue::Type::List);
+}
+
+void ShvLogStreamWriter::append(chainpack::RpcValue::List &&rec)
+{
+	cp::RpcValue &path = rec[ShvLogHeader::Column::Path];
+	bool is_new;
+	cp::RpcValue path_id = pathValue(path, m_withPathsDict, &is_new);
+	if(is_new && m_withPathsDict)
+		path = pathString(path);
+	else
+		path = path_id;
+	// record is written column by column, no RpcValue wrapping the list is created
+	m_out.writeContainerBegin(cp::RpcValue::Type::List);
+	for(const cp::RpcValue &col : rec)
+		m_out.writeListElement(col);
+	m_out.writeContainerEnd();
+}
+
+void ShvLogStreamWriter::end(ShvLogHeader &&header)
+{
+	if(m_withPathsDict)
+		header.setPathDict(pathDict());
+	cp::RpcValue trailer(nullptr);
+	trailer.setMetaData(header.toMetaData());
+	m_out.writeListElement(trailer);
+	m_out.writeContainerEnd();
+	m_out.flush();
+}
+
+} // namespace utils
+} // namespace core
+} // namespace shv
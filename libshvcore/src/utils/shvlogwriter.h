@@ -0,0 +1,92 @@
+#ifndef SHV_CORE_UTILS_SHVLOGWRITER_H
+#define SHV_CORE_UTILS_SHVLOGWRITER_H
+
+#include "../shvcoreglobal.h"
+
+#include "shvlogheader.h"
+
+#include <shv/chainpack/rpcvalue.h>
+
+namespace shv {
+namespace chainpack { class ChainPackWriter; }
+namespace core {
+namespace utils {
+
+class ShvPathDictionary;
+
+/// Consumer of records produced by getLog()
+///
+/// begin() is called before the first record with header fields known up front,
+/// end() is called after the last record with final since, until and record count.
+class SHVCORE_DECL_EXPORT AbstractShvLogWriter
+{
+public:
+	virtual ~AbstractShvLogWriter();
+
+	virtual void begin(const ShvLogHeader &header) = 0;
+	/// record columns are in ShvLogHeader::Column order, Path column contains path string
+	virtual void append(shv::chainpack::RpcValue::List &&rec) = 0;
+	virtual void end(ShvLogHeader &&header) = 0;
+
+	/// when dictionary is set, Path column of appended records can contain path ID from it,
+	/// such a path is found in cache by ID without string lookup
+	void setPathDictionary(const ShvPathDictionary *dict) { m_pathDictionary = dict; }
+protected:
+	/// returns path ID if paths dictionary is used or shared path string otherwise,
+	/// is_new is set when path is seen for the first time
+	shv::chainpack::RpcValue pathValue(const shv::chainpack::RpcValue &path, bool with_paths_dict, bool *is_new = nullptr);
+	/// path string of Path column
+	const std::string& pathString(const shv::chainpack::RpcValue &path) const;
+	const shv::chainpack::RpcValue::IMap& pathDict() const { return m_pathDict; }
+private:
+	/// this ensure that there be only one copy of each path in memory
+	shv::chainpack::RpcValue::Map m_pathCache;
+	/// path values indexed by ID from m_pathDictionary
+	std::vector<shv::chainpack::RpcValue> m_pathCacheById;
+	const ShvPathDictionary *m_pathDictionary = nullptr;
+	shv::chainpack::RpcValue::IMap m_pathDict;
+	int m_maxPathId = 0;
+};
+
+/// Builds whole log in memory, result() is log as it was returned by getLog() before streaming
+class SHVCORE_DECL_EXPORT ShvLogRpcValueWriter : public AbstractShvLogWriter
+{
+public:
+	void begin(const ShvLogHeader &header) override;
+	void append(shv::chainpack::RpcValue::List &&rec) override;
+	void end(ShvLogHeader &&header) override;
+
+	const shv::chainpack::RpcValue& result() const { return m_result; }
+private:
+	bool m_withPathsDict = true;
+	shv::chainpack::RpcValue::List m_log;
+	shv::chainpack::RpcValue m_result;
+};
+
+/// Writes records to stream as they are produced, there is no need to keep whole log in memory
+///
+/// Stream format is <header>[record, ..., <final header>null], where header is written up front
+/// without record count and paths dictionary, the last list element is trailer carrying final header in meta data.
+/// When paths dictionary is used, path is written as string when it occurs for the first time
+/// and it gets next path ID implicitly, following records contain the ID.
+/// Logs in this format are read by ShvLogFileReader and ShvLogRpcValueReader.
+class SHVCORE_DECL_EXPORT ShvLogStreamWriter : public AbstractShvLogWriter
+{
+public:
+	ShvLogStreamWriter(shv::chainpack::ChainPackWriter &out);
+
+	void begin(const ShvLogHeader &header) override;
+	void append(shv::chainpack::RpcValue::List &&rec) override;
+	void end(ShvLogHeader &&header) override;
+
+	static bool isTrailer(const shv::chainpack::RpcValue &row) { return !row.isList() && !row.metaData().isEmpty(); }
+private:
+	shv::chainpack::ChainPackWriter &m_out;
+	bool m_withPathsDict = true;
+};
+
+} // namespace utils
+} // namespace core
+} // namespace shv
+
+#endif // SHV_CORE_UTILS_SHVLOGWRITER_H
@@ -1,5 +1,6 @@
 #include "shvmemoryjournal.h"
 #include "shvlogheader.h"
+#include "shvlogwriter.h"
 #include "shvpath.h"
 #include "shvfilejournal.h"
 #include "shvlogrpcvaluereader.h"
@@ -8,6 +9,9 @@
 #include "../exception.h"
 #include "../log.h"
 
+#include <algorithm>
+#include <iterator>
+
 #define logWShvJournal() shvCWarning("ShvJournal")
 #define logIShvJournal() shvCInfo("ShvJournal")
 #define logDShvJournal() shvCDebug("ShvJournal")
@@ -19,6 +23,12 @@ namespace core {
 namespace utils {
 
 ShvMemoryJournal::ShvMemoryJournal()
+	: ShvMemoryJournal(std::make_shared<ShvPathDictionary>())
+{
+}
+
+ShvMemoryJournal::ShvMemoryJournal(std::shared_ptr<ShvPathDictionary> path_dictionary)
+	: m_pathDictionary(std::move(path_dictionary))
 {
 }
 
@@ -26,7 +36,7 @@ void ShvMemoryJournal::loadLog(const chainpack::RpcValue &log, bool append_recor
 {
 	shv::core::utils::ShvLogRpcValueReader rd(log, !shv::core::Exception::Throw);
 	if(!append_records) {
-		m_entries.clear();
+		clear();
 		m_logHeader = rd.logHeader();
 	}
 	while(rd.next()) {
@@ -37,6 +47,7 @@ void ShvMemoryJournal::loadLog(const chainpack::RpcValue &log, bool append_recor
 
 void ShvMemoryJournal::append(const ShvJournalEntry &entry)
 {
+	const uint32_t path_id = m_pathDictionary->intern(entry.path);
 	int64_t epoch_msec = entry.epochMsec;
 	if(epoch_msec == 0) {
 		epoch_msec = cp::RpcValue::DateTime::now().msecsSinceEpoch();
@@ -44,7 +55,7 @@ void ShvMemoryJournal::append(const ShvJournalEntry &entry)
 	else if(isShortTimeCorrection()) {
 		if(entry.sampleType == ShvJournalEntry::SampleType::Continuous && entry.shortTime != shv::core::utils::ShvJournalEntry::NO_SHORT_TIME) {
 			uint16_t short_msec = static_cast<uint16_t>(entry.shortTime);
-			ShortTime &st = m_recentShortTimes[entry.path];
+			ShortTime &st = m_recentShortTimes[path_id];
 			if(entry.shortTime == st.recentShortTime) {
 				// the same short times in the row, this can happen only when
 				// data is badly generated, we will ignore such values
@@ -84,24 +95,265 @@ void ShvMemoryJournal::append(const ShvJournalEntry &entry)
 		}
 	}
 
-	if (m_pathDictionary.find(entry.path) == m_pathDictionary.end()) {
-		m_pathDictionary[entry.path] = m_pathDictionaryIndex++;
-	}
-
-	Entry e(entry);
+	Entry e;
 	e.epochMsec = epoch_msec;
+	e.value = entry.value;
+	e.pathId = path_id;
+	e.domainId = m_stringDictionary.intern(entry.domain);
+	e.userId = m_stringDictionary.intern(entry.userId);
+	e.shortTime = entry.shortTime;
+	e.sampleType = entry.sampleType;
 	int64_t last_time = m_entries.empty()? 0: m_entries[m_entries.size()-1].epochMsec;
+	size_t entry_ix;
 	if(epoch_msec < last_time) {
-		auto it = std::upper_bound(m_entries.begin(), m_entries.end(), entry, [](const Entry &e1, const Entry &e2) {
-			return e1.epochMsec < e2.epochMsec;
-		});
-		m_entries.insert(it, std::move(e));
+		entry_ix = insertEntry(std::move(e));
 	}
 	else {
 		m_entries.push_back(std::move(e));
+		entry_ix = m_entries.size() - 1;
+		appendToPathSeries(entry_ix);
+	}
+	if(m_entriesCache.entries) {
+		std::vector<ShvJournalEntry> &entries = *m_entriesCache.entries;
+		entries.insert(entries.begin() + static_cast<ptrdiff_t>(entry_ix), toJournalEntry(m_entries[entry_ix]));
+	}
+}
+
+size_t ShvMemoryJournal::insertEntry(Entry &&e)
+{
+	auto it = std::upper_bound(m_entries.begin(), m_entries.end(), e.epochMsec, [](int64_t msec, const Entry &e2) {
+		return msec < e2.epochMsec;
+	});
+	const size_t entry_ix = static_cast<size_t>(it - m_entries.begin());
+	const size_t path_id = e.pathId;
+	m_entries.insert(it, std::move(e));
+	// indexes of entries behind inserted one are shifted by one
+	for(PathSeries &series : m_pathSeries) {
+		std::vector<size_t> &ixs = series.entryIndexes;
+		for(auto ix_it = std::lower_bound(ixs.begin(), ixs.end(), entry_ix); ix_it != ixs.end(); ++ix_it)
+			++*ix_it;
+	}
+	if(path_id >= m_pathSeries.size())
+		m_pathSeries.resize(path_id + 1);
+	PathSeries &series = m_pathSeries[path_id];
+	std::vector<size_t> &ixs = series.entryIndexes;
+	auto ix_it = std::lower_bound(ixs.begin(), ixs.end(), entry_ix);
+	if(ix_it == ixs.end()) {
+		appendToPathSeries(entry_ix);
+		return entry_ix;
+	}
+	// positions of path entries behind inserted one are shifted, pyramid items covering them are recomputed
+	const size_t pos = static_cast<size_t>(ix_it - ixs.begin());
+	ixs.insert(ix_it, entry_ix);
+	updatePyramid(series, pos);
+	return entry_ix;
+}
+
+void ShvMemoryJournal::updatePyramid(PathSeries &series, size_t from_pos)
+{
+	std::vector<std::vector<ValueRange>> &pyramid = series.pyramid;
+	size_t below_cnt = series.entryIndexes.size();
+	for(size_t level = 0; ; ++level) {
+		const size_t cnt = (below_cnt + PYRAMID_FAN_OUT - 1) / PYRAMID_FAN_OUT;
+		from_pos /= PYRAMID_FAN_OUT;
+		if(level == pyramid.size())
+			pyramid.emplace_back();
+		std::vector<ValueRange> &items = pyramid[level];
+		items.resize(cnt);
+		for(size_t i = from_pos; i < cnt; ++i) {
+			ValueRange range;
+			const size_t end = std::min((i + 1) * PYRAMID_FAN_OUT, below_cnt);
+			for(size_t j = i * PYRAMID_FAN_OUT; j < end; ++j) {
+				if(level == 0)
+					range.add(entryValueRange(series.entryIndexes[j]));
+				else
+					range.add(pyramid[level - 1][j]);
+			}
+			items[i] = range;
+		}
+		if(cnt == 1) {
+			pyramid.resize(level + 1);
+			break;
+		}
+		below_cnt = cnt;
 	}
 }
 
+const std::vector<ShvJournalEntry>& ShvMemoryJournal::entries() const
+{
+	std::lock_guard<std::mutex> lock(m_entriesCache.mutex);
+	if(!m_entriesCache.entries) {
+		std::unique_ptr<std::vector<ShvJournalEntry>> entries(new std::vector<ShvJournalEntry>());
+		entries->reserve(m_entries.size());
+		for(const Entry &e : m_entries)
+			entries->push_back(toJournalEntry(e));
+		m_entriesCache.entries = std::move(entries);
+	}
+	return *m_entriesCache.entries;
+}
+
+ShvJournalEntry ShvMemoryJournal::toJournalEntry(const Entry &e) const
+{
+	ShvJournalEntry ret(m_pathDictionary->string(e.pathId), e.value, domain(e), e.shortTime, e.sampleType, e.epochMsec);
+	ret.userId = m_stringDictionary.string(e.userId);
+	return ret;
+}
+
+void ShvMemoryJournal::clear()
+{
+	m_entries.clear();
+	m_pathSeries.clear();
+	m_entriesCache.entries.reset();
+	m_recentShortTimes.clear();
+}
+
+void ShvMemoryJournal::appendToPathSeries(size_t entry_ix)
+{
+	const size_t path_id = m_entries[entry_ix].pathId;
+	if(path_id >= m_pathSeries.size())
+		m_pathSeries.resize(path_id + 1);
+	PathSeries &series = m_pathSeries[path_id];
+	size_t ix = series.entryIndexes.size();
+	series.entryIndexes.push_back(entry_ix);
+	const ValueRange range = entryValueRange(entry_ix);
+	std::vector<std::vector<ValueRange>> &pyramid = series.pyramid;
+	for(size_t level = 0; ; ++level) {
+		ix /= PYRAMID_FAN_OUT;
+		if(level == pyramid.size()) {
+			// new top level covering whole level below
+			ValueRange top = range;
+			if(level > 0) {
+				for(const ValueRange &r : pyramid[level - 1])
+					top.add(r);
+			}
+			pyramid.emplace_back(1, top);
+			break;
+		}
+		std::vector<ValueRange> &items = pyramid[level];
+		if(ix == items.size())
+			items.push_back(range);
+		else
+			items[ix].add(range);
+		if(level + 1 == pyramid.size() && items.size() == 1)
+			break;
+	}
+}
+
+ShvMemoryJournal::ValueRange ShvMemoryJournal::entryValueRange(size_t entry_ix) const
+{
+	ValueRange ret;
+	const cp::RpcValue &val = m_entries[entry_ix].value;
+	switch (val.type()) {
+	case cp::RpcValue::Type::Int:
+	case cp::RpcValue::Type::UInt:
+	case cp::RpcValue::Type::Double:
+	case cp::RpcValue::Type::Decimal:
+		ret.add(val.toDouble());
+		break;
+	case cp::RpcValue::Type::Bool:
+		ret.add(val.toBool()? 1: 0);
+		break;
+	default:
+		break;
+	}
+	return ret;
+}
+
+const ShvMemoryJournal::PathSeries *ShvMemoryJournal::pathSeries(const std::string &path) const
+{
+	uint32_t path_id = m_pathDictionary->id(path);
+	if(path_id == ShvPathDictionary::NO_ID || path_id >= m_pathSeries.size())
+		return nullptr;
+	return &m_pathSeries[path_id];
+}
+
+std::pair<size_t, size_t> ShvMemoryJournal::pathSeriesRange(const PathSeries &series, int64_t since_msec, int64_t until_msec) const
+{
+	auto cmp = [this](size_t entry_ix, int64_t msec) {
+		return m_entries[entry_ix].epochMsec < msec;
+	};
+	const std::vector<size_t> &ixs = series.entryIndexes;
+	auto it1 = ixs.begin();
+	if(since_msec > 0)
+		it1 = std::lower_bound(ixs.begin(), ixs.end(), since_msec, cmp);
+	auto it2 = ixs.end();
+	if(until_msec > 0)
+		it2 = std::lower_bound(it1, ixs.end(), until_msec, cmp);
+	return std::make_pair(static_cast<size_t>(it1 - ixs.begin()), static_cast<size_t>(it2 - ixs.begin()));
+}
+
+ShvMemoryJournal::ValueRange ShvMemoryJournal::pathSeriesValueRange(const PathSeries &series, size_t lo, size_t hi) const
+{
+	ValueRange ret;
+	// level -1 are path entries, pyramid level items are used where range covers them completely
+	auto add_items = [this, &series, &ret](int level, size_t from, size_t to) {
+		for(size_t i = from; i < to; ++i) {
+			if(level < 0)
+				ret.add(entryValueRange(series.entryIndexes[i]));
+			else
+				ret.add(series.pyramid[static_cast<size_t>(level)][i]);
+		}
+	};
+	for(int level = -1; lo < hi; ++level) {
+		size_t lo_up = (lo + PYRAMID_FAN_OUT - 1) / PYRAMID_FAN_OUT * PYRAMID_FAN_OUT;
+		size_t hi_down = hi / PYRAMID_FAN_OUT * PYRAMID_FAN_OUT;
+		if(lo_up >= hi_down || level + 1 == static_cast<int>(series.pyramid.size())) {
+			add_items(level, lo, hi);
+			break;
+		}
+		add_items(level, lo, lo_up);
+		add_items(level, hi_down, hi);
+		lo = lo_up / PYRAMID_FAN_OUT;
+		hi = hi_down / PYRAMID_FAN_OUT;
+	}
+	return ret;
+}
+
+std::vector<size_t> ShvMemoryJournal::pathEntryIndexes(const std::string &path, int64_t since_msec, int64_t until_msec) const
+{
+	const PathSeries *series = pathSeries(path);
+	if(!series)
+		return std::vector<size_t>();
+	auto range = pathSeriesRange(*series, since_msec, until_msec);
+	auto it = series->entryIndexes.begin();
+	return std::vector<size_t>(it + static_cast<ptrdiff_t>(range.first), it + static_cast<ptrdiff_t>(range.second));
+}
+
+ShvMemoryJournal::ValueRange ShvMemoryJournal::pathValueRange(const std::string &path, int64_t since_msec, int64_t until_msec) const
+{
+	const PathSeries *series = pathSeries(path);
+	if(!series)
+		return ValueRange();
+	auto range = pathSeriesRange(*series, since_msec, until_msec);
+	return pathSeriesValueRange(*series, range.first, range.second);
+}
+
+std::vector<ShvMemoryJournal::ValueBucket> ShvMemoryJournal::decimate(const std::string &path, int64_t since_msec, int64_t until_msec, size_t bucket_count) const
+{
+	std::vector<ValueBucket> ret;
+	const PathSeries *series = pathSeries(path);
+	if(!series || series->entryIndexes.empty() || bucket_count == 0)
+		return ret;
+	if(since_msec == 0)
+		since_msec = m_entries[series->entryIndexes.front()].epochMsec;
+	if(until_msec == 0)
+		until_msec = m_entries[series->entryIndexes.back()].epochMsec + 1;
+	if(until_msec <= since_msec)
+		return ret;
+	ret.resize(bucket_count);
+	size_t lo = pathSeriesRange(*series, since_msec, 0).first;
+	for(size_t i = 0; i < bucket_count; ++i) {
+		ValueBucket &bucket = ret[i];
+		bucket.sinceMsec = since_msec + (until_msec - since_msec) * static_cast<int64_t>(i) / static_cast<int64_t>(bucket_count);
+		int64_t bucket_until = since_msec + (until_msec - since_msec) * static_cast<int64_t>(i + 1) / static_cast<int64_t>(bucket_count);
+		size_t hi = pathSeriesRange(*series, bucket_until, 0).first;
+		bucket.count = hi - lo;
+		bucket.range = pathSeriesValueRange(*series, lo, hi);
+		lo = hi;
+	}
+	return ret;
+}
+
 static int64_t min_valid(int64_t a, int64_t b)
 {
 	if(a == 0)
@@ -112,13 +364,17 @@ static int64_t min_valid(int64_t a, int64_t b)
 }
 
 chainpack::RpcValue ShvMemoryJournal::getLog(const ShvGetLogParams &params)
+{
+	ShvLogRpcValueWriter writer;
+	getLog(params, writer);
+	return writer.result();
+}
+
+void ShvMemoryJournal::getLog(const ShvGetLogParams &params, AbstractShvLogWriter &writer)
 {
 	logIShvJournal() << "========================= getLog ==================";
 	logIShvJournal() << "params:" << params.toRpcValue().toCpon();
 	using Column = ShvLogHeader::Column;
-	cp::RpcValue::List log;
-	cp::RpcValue::Map path_cache;
-	int max_path_index = 0;
 	int rec_cnt = 0;
 
 	auto params_since_msec = params.since.toDateTime().msecsSinceEpoch();
@@ -136,6 +392,34 @@ chainpack::RpcValue ShvMemoryJournal::getLog(const ShvGetLogParams &params)
 	//int64_t first_record_msec = 0;
 	int64_t last_record_msec = 0;
 
+	ShvLogHeader hdr;
+	{
+		hdr.setDeviceId(m_logHeader.deviceId());
+		hdr.setDeviceType(m_logHeader.deviceType());
+		hdr.setDateTime(cp::RpcValue::DateTime::now());
+		hdr.setLogParams(params);
+		// since is known up front only when it is not taken from the first record
+		hdr.setSince((since_msec > 0)? cp::RpcValue(cp::RpcValue::DateTime::fromMSecsSinceEpoch(since_msec)): cp::RpcValue(nullptr));
+		hdr.setRecordCountLimit(rec_cnt_limit);
+		hdr.setWithSnapShot(params.withSnapshot);
+		hdr.setWithPathsDict(params.withPathsDict);
+
+		cp::RpcValue::List fields;
+		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Timestamp)}});
+		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Path)}});
+		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Value)}});
+		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::ShortTime)}});
+		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Domain)}});
+		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::SampleType)}});
+		hdr.setFields(std::move(fields));
+
+		if(params.withTypeInfo)
+			hdr.copyTypeInfo(m_logHeader);
+	}
+	// records contain path IDs, writer finds them in dictionary
+	writer.setPathDictionary(m_pathDictionary.get());
+	writer.begin(hdr);
+
 	if(params_since_msec > 0 && log_until_msec > 0 && params_since_msec >= log_until_msec)
 		goto log_finish;
 	if(params_until_msec > 0 && log_since_msec > 0 && params_until_msec < log_since_msec)
@@ -160,31 +444,58 @@ chainpack::RpcValue ShvMemoryJournal::getLog(const ShvGetLogParams &params)
 			});
 		}
 
-		/// this ensure that there be only one copy of each path in memory
-		auto make_path_shared = [&path_cache, &max_path_index, &params](const std::string &path) -> cp::RpcValue {
-			cp::RpcValue ret = path_cache.value(path);
-			if(ret.isValid())
-				return ret;
-			if(params.withPathsDict)
-				ret = ++max_path_index;
-			else
-				ret = path;
-			logIShvJournal() << "Adding record to path cache:" << path << "-->" << ret.toCpon();
-			path_cache[path] = ret;
-			return ret;
+		PatternMatcher pm(params);
+		auto match = [this, &pm](const Entry &e) {
+			return pm.match(m_pathDictionary->string(e.pathId), domain(e));
+		};
+		// domain and user ID values are shared by all records
+		std::vector<cp::RpcValue> string_values(m_stringDictionary.size());
+		auto string_value = [this, &string_values](uint32_t id) -> const cp::RpcValue& {
+			cp::RpcValue &val = string_values[id];
+			if(!val.isValid()) {
+				const std::string &s = m_stringDictionary.string(id);
+				val = s.empty()? cp::RpcValue(nullptr): cp::RpcValue(s);
+			}
+			return val;
 		};
 
-		PatternMatcher pm(params);
+		// when path pattern is specified, only entries of matching paths are visited using path index
+		const bool use_path_index = !pm.isPathPatternEmpty() && !pm.isRegexError();
+		std::vector<const PathSeries*> matching_series;
+		if(use_path_index) {
+			for(size_t path_id = 0; path_id < m_pathSeries.size(); ++path_id) {
+				const PathSeries &series = m_pathSeries[path_id];
+				if(!series.entryIndexes.empty() && pm.matchPath(m_pathDictionary->string(static_cast<uint32_t>(path_id))))
+					matching_series.push_back(&series);
+			}
+		}
+		const size_t ix1 = static_cast<size_t>(it1 - m_entries.begin());
+		const size_t ix2 = static_cast<size_t>(it2 - m_entries.begin());
 
-		std::map<std::string, Entry> snapshot;
+		std::map<std::string, const Entry*> snapshot;
 		if(params.withSnapshot) {
-			for(auto it = m_entries.begin(); it != m_entries.end() && it < it1; ++it) {
-				const Entry &e = *it;
-				if (it < it1 || e.epochMsec == since_msec) {  //it1 (lower_bound) can be == since_msec (we want in snapshot)
-					if(!pm.match(e))                          //or > since_msec (we don't want in snapshot)
-						continue;
-					if(e.sampleType == ShvJournalEntry::SampleType::Continuous) {
-						snapshot[e.path] = e;
+			if(use_path_index) {
+				for(const PathSeries *series : matching_series) {
+					const std::vector<size_t> &ixs = series->entryIndexes;
+					auto it = std::lower_bound(ixs.begin(), ixs.end(), ix1);
+					while(it != ixs.begin()) {
+						const Entry &e = m_entries[*(--it)];
+						if(e.sampleType == ShvJournalEntry::SampleType::Continuous && match(e)) {
+							snapshot[m_pathDictionary->string(e.pathId)] = &e;
+							break;
+						}
+					}
+				}
+			}
+			else {
+				for(auto it = m_entries.begin(); it != m_entries.end() && it < it1; ++it) {
+					const Entry &e = *it;
+					if (it < it1 || e.epochMsec == since_msec) {  //it1 (lower_bound) can be == since_msec (we want in snapshot)
+						if(!match(e))                             //or > since_msec (we don't want in snapshot)
+							continue;
+						if(e.sampleType == ShvJournalEntry::SampleType::Continuous) {
+							snapshot[m_pathDictionary->string(e.pathId)] = &e;
+						}
 					}
 				}
 			}
@@ -195,7 +506,7 @@ chainpack::RpcValue ShvMemoryJournal::getLog(const ShvGetLogParams &params)
 						rec_cnt_limit_hit = true;
 						goto log_finish;
 					}
-					const auto &entry = kv.second;
+					const Entry &entry = *kv.second;
 					if (entry.value.hasDefaultValue()) {
 						continue;
 					}
@@ -204,88 +515,82 @@ chainpack::RpcValue ShvMemoryJournal::getLog(const ShvGetLogParams &params)
 						since_msec = entry.epochMsec;
 					last_record_msec = since_msec;
 					rec.push_back(cp::RpcValue::DateTime::fromMSecsSinceEpoch(since_msec));
-					rec.push_back(make_path_shared(entry.path));
+					rec.push_back(entry.pathId);
 					rec.push_back(entry.value);
 					rec.push_back(entry.shortTime);
-					rec.push_back(entry.domain.empty()? cp::RpcValue(nullptr): entry.domain);
+					rec.push_back(string_value(entry.domainId));
 					rec.push_back((int)entry.sampleType);
 					// clientId & userId shoud not be in snapshot, since they ere used with ShvJournalEntry::SampleType::Discrete only
 					//rec.push_back(entry.userId.empty()? cp::RpcValue(nullptr): cp::RpcValue(entry.userId));
-					log.push_back(std::move(rec));
+					writer.append(std::move(rec));
 					rec_cnt++;
 				}
 			}
 		}
 		// keep <since, until) interval open to make log merge simpler
 		{
-			auto it = it1;
-			for(; it != it2; ++it) {
-				if(pm.match(*it)) {
+			// entries of matching paths are merged from path indexes in time order
+			struct Cursor { const size_t *it; const size_t *end; };
+			auto cursor_greater = [](const Cursor &c1, const Cursor &c2) {
+				return *c1.it > *c2.it;
+			};
+			std::vector<Cursor> cursors;
+			for(const PathSeries *series : matching_series) {
+				const size_t *begin = series->entryIndexes.data();
+				const size_t *end = begin + series->entryIndexes.size();
+				Cursor c{std::lower_bound(begin, end, ix1), std::lower_bound(begin, end, ix2)};
+				if(c.it != c.end)
+					cursors.push_back(c);
+			}
+			std::make_heap(cursors.begin(), cursors.end(), cursor_greater);
+			size_t ix = ix1;
+			auto next_entry = [&]() -> const Entry* {
+				if(!use_path_index)
+					return (ix < ix2)? &m_entries[ix++]: nullptr;
+				if(cursors.empty())
+					return nullptr;
+				std::pop_heap(cursors.begin(), cursors.end(), cursor_greater);
+				Cursor &c = cursors.back();
+				const Entry *e = &m_entries[*c.it++];
+				if(c.it == c.end)
+					cursors.pop_back();
+				else
+					std::push_heap(cursors.begin(), cursors.end(), cursor_greater);
+				return e;
+			};
+			while(const Entry *e = next_entry()) {
+				if(match(*e)) {
 					if(rec_cnt >= rec_cnt_limit) {
 						rec_cnt_limit_hit = true;
 						goto log_finish;
 					}
 					if(since_msec == 0)
-						since_msec = it->epochMsec;
-					last_record_msec = it->epochMsec;
+						since_msec = e->epochMsec;
+					last_record_msec = e->epochMsec;
 					cp::RpcValue::List rec;
-					rec.push_back(cp::RpcValue::DateTime::fromMSecsSinceEpoch(it->epochMsec));
-					rec.push_back(make_path_shared(it->path));
-					rec.push_back(it->value);
-					rec.push_back(it->shortTime);
-					rec.push_back(it->domain.empty()? cp::RpcValue(nullptr): it->domain);
-					rec.push_back((int)it->sampleType);
-					rec.push_back(it->userId.empty()? cp::RpcValue(nullptr): cp::RpcValue(it->userId));
-					log.push_back(std::move(rec));
+					rec.push_back(cp::RpcValue::DateTime::fromMSecsSinceEpoch(e->epochMsec));
+					rec.push_back(e->pathId);
+					rec.push_back(e->value);
+					rec.push_back(e->shortTime);
+					rec.push_back(string_value(e->domainId));
+					rec.push_back((int)e->sampleType);
+					rec.push_back(string_value(e->userId));
+					writer.append(std::move(rec));
 					rec_cnt++;
 				}
 			}
 		}
 	}
 log_finish:
-	cp::RpcValue ret = log;
-	ShvLogHeader hdr;
-	{
-		hdr.setDeviceId(m_logHeader.deviceId());
-		hdr.setDeviceType(m_logHeader.deviceType());
-		hdr.setDateTime(cp::RpcValue::DateTime::now());
-		hdr.setLogParams(params);
-
-		hdr.setSince((since_msec > 0)? cp::RpcValue(cp::RpcValue::DateTime::fromMSecsSinceEpoch(since_msec)): cp::RpcValue(nullptr));
-		// if record count < limit and params until is specified and it is > log end, then set until to log end
-		if(rec_cnt_limit_hit) {
-			until_msec = last_record_msec;
-		}
-		hdr.setUntil((until_msec > 0)? cp::RpcValue(cp::RpcValue::DateTime::fromMSecsSinceEpoch(until_msec)): cp::RpcValue(nullptr));
-		hdr.setRecordCount(rec_cnt);
-		hdr.setRecordCountLimit(rec_cnt_limit);
-		hdr.setRecordCountLimitHit(rec_cnt_limit_hit);
-		hdr.setWithSnapShot(params.withSnapshot);
-		hdr.setWithPathsDict(params.withPathsDict);
-
-		cp::RpcValue::List fields;
-		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Timestamp)}});
-		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Path)}});
-		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Value)}});
-		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::ShortTime)}});
-		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::Domain)}});
-		fields.push_back(cp::RpcValue::Map{{KEY_NAME, Column::name(Column::Enum::SampleType)}});
-		hdr.setFields(std::move(fields));
-
-		if(params.withTypeInfo)
-			hdr.copyTypeInfo(m_logHeader);
-	}
-	if(params.withPathsDict) {
-		logIShvJournal() << "Generating paths dict";
-		cp::RpcValue::IMap path_dict;
-		for(auto kv : path_cache) {
-			logIShvJournal() << "Adding record to paths dict:" << kv.second.toInt() << "-->" << kv.first;
-			path_dict[kv.second.toInt()] = kv.first;
-		}
-		hdr.setPathDict(std::move(path_dict));
+	hdr.setSince((since_msec > 0)? cp::RpcValue(cp::RpcValue::DateTime::fromMSecsSinceEpoch(since_msec)): cp::RpcValue(nullptr));
+	// if record count < limit and params until is specified and it is > log end, then set until to log end
+	if(rec_cnt_limit_hit) {
+		until_msec = last_record_msec;
 	}
-	ret.setMetaData(hdr.toMetaData());
-	return ret;
+	hdr.setUntil((until_msec > 0)? cp::RpcValue(cp::RpcValue::DateTime::fromMSecsSinceEpoch(until_msec)): cp::RpcValue(nullptr));
+	hdr.setRecordCount(rec_cnt);
+	hdr.setRecordCountLimitHit(rec_cnt_limit_hit);
+	writer.end(std::move(hdr));
 }
 /*
 size_t ShvMemoryJournal::timeToUpperBoundIndex(int64_t time) const
@@ -6,15 +6,43 @@
 #include "shvjournalentry.h"
 #include "shvgetlogparams.h"
 #include "shvlogheader.h"
+#include "shvpathdictionary.h"
+
+#include <limits>
+#include <memory>
+#include <mutex>
 
 namespace shv {
 namespace core {
 namespace utils {
 
+/// Entries are kept sorted by time, out of order entry is inserted after entries with the same time.
+/// Every path has index of its entries and min/max pyramid of its numeric values,
+/// so per-path range and aggregate queries do not need to scan the whole journal.
+/// Path, domain and user ID of entries are stored as IDs to interned strings.
 class SHVCORE_DECL_EXPORT ShvMemoryJournal : public AbstractShvJournal
 {
+public:
+	struct ValueRange
+	{
+		double min = std::numeric_limits<double>::max();
+		double max = std::numeric_limits<double>::lowest();
+
+		bool isValid() const { return min <= max; }
+		void add(double d) { if(d < min) min = d; if(d > max) max = d; }
+		void add(const ValueRange &r) { if(r.min < min) min = r.min; if(r.max > max) max = r.max; }
+	};
+	struct ValueBucket
+	{
+		int64_t sinceMsec = 0;
+		/// count of all path entries in bucket, including non numeric ones
+		size_t count = 0;
+		ValueRange range;
+	};
 public:
 	ShvMemoryJournal();
+	/// path dictionary can be shared by more journals
+	ShvMemoryJournal(std::shared_ptr<ShvPathDictionary> path_dictionary);
 
 	void setSince(const shv::chainpack::RpcValue &since) { m_logHeader.setSince(since); }
 	void setUntil(const shv::chainpack::RpcValue &until) { m_logHeader.setUntil(until); }
@@ -32,27 +60,97 @@ public:
 
 	void loadLog(const shv::chainpack::RpcValue &log, bool append_records = false);
 	shv::chainpack::RpcValue getLog(const ShvGetLogParams &params) override;
+	void getLog(const ShvGetLogParams &params, AbstractShvLogWriter &writer) override;
 
 	// we do not expose whole header, since append() does not update field until
 	//const ShvLogHeader &logHeader() const { return m_logHeader; }
 	bool hasSnapshot() const { return m_logHeader.withSnapShot(); }
 
-	const std::vector<ShvJournalEntry>& entries() const {return  m_entries;}
-	bool isEmpty() const { return  m_entries.size() == 0; }
+	/// @deprecated entries are stored with interned strings, this vector is created on first call of entries() or at(),
+	/// then append() keeps it in sync until clear(), it takes as much memory as the journal without interning,
+	/// use size(), entryAt(), epochMsecAt(), pathAt() or valueAt() instead
+	const std::vector<ShvJournalEntry>& entries() const;
+	bool isEmpty() const { return  m_entries.empty(); }
 	size_t size() const { return  m_entries.size(); }
-	const ShvJournalEntry& at(size_t ix) const { return  m_entries.at(ix); }
-	void clear() { m_entries.clear(); }
+	/// @deprecated see entries()
+	const ShvJournalEntry& at(size_t ix) const { return entries().at(ix); }
+	/// entry created from interned strings
+	ShvJournalEntry entryAt(size_t ix) const { return toJournalEntry(m_entries.at(ix)); }
+	int64_t epochMsecAt(size_t ix) const { return  m_entries.at(ix).epochMsec; }
+	const std::string& pathAt(size_t ix) const { return  m_pathDictionary->string(m_entries.at(ix).pathId); }
+	const shv::chainpack::RpcValue& valueAt(size_t ix) const { return  m_entries.at(ix).value; }
+	void clear();
+
+	const std::shared_ptr<ShvPathDictionary>& pathDictionary() const { return m_pathDictionary; }
+
+	/// Per-path queries, time range is <since_msec, until_msec), until_msec == 0 means no upper limit.
+	/// Complexity is O(log n) plus size of output.
+
+	/// indexes to entries() of path records in time range
+	std::vector<size_t> pathEntryIndexes(const std::string &path, int64_t since_msec = 0, int64_t until_msec = 0) const;
+	/// min and max of path numeric values in time range
+	ValueRange pathValueRange(const std::string &path, int64_t since_msec = 0, int64_t until_msec = 0) const;
+	/// time range is split to bucket_count buckets of the same length, min and max is computed for every of them,
+	/// this is what graph needs to draw path with one bucket per pixel
+	std::vector<ValueBucket> decimate(const std::string &path, int64_t since_msec, int64_t until_msec, size_t bucket_count) const;
 	//size_t timeToUpperBoundIndex(int64_t time) const;
 private:
-	using Entry = ShvJournalEntry;
+	/// ShvJournalEntry with interned strings
+	struct Entry
+	{
+		int64_t epochMsec = 0;
+		shv::chainpack::RpcValue value;
+		uint32_t pathId = 0;
+		uint32_t domainId = 0;
+		uint32_t userId = 0;
+		int shortTime = ShvJournalEntry::NO_SHORT_TIME;
+		ShvJournalEntry::SampleType sampleType = ShvJournalEntry::SampleType::Continuous;
+	};
 
-	std::map<std::string, int> m_pathDictionary;
-	int m_pathDictionaryIndex = 0;
+	/// entries of one path, every level of pyramid keeps min and max of PYRAMID_FAN_OUT items of level below,
+	/// level 0 is computed from entryIndexes, top level has single item
+	struct PathSeries
+	{
+		std::vector<size_t> entryIndexes;
+		std::vector<std::vector<ValueRange>> pyramid;
+	};
+	static constexpr size_t PYRAMID_FAN_OUT = 16;
+
+	/// out of order entry, indexes of entries behind it are shifted, returns index of inserted entry
+	size_t insertEntry(Entry &&e);
+	void appendToPathSeries(size_t entry_ix);
+	/// recompute pyramid items covering entryIndexes positions from from_pos to the end
+	void updatePyramid(PathSeries &series, size_t from_pos);
+	ShvJournalEntry toJournalEntry(const Entry &e) const;
+	const std::string& domain(const Entry &e) const { return m_stringDictionary.string(e.domainId); }
+	const PathSeries* pathSeries(const std::string &path) const;
+	/// positions in PathSeries::entryIndexes of time range
+	std::pair<size_t, size_t> pathSeriesRange(const PathSeries &series, int64_t since_msec, int64_t until_msec) const;
+	ValueRange pathSeriesValueRange(const PathSeries &series, size_t lo, size_t hi) const;
+	ValueRange entryValueRange(size_t entry_ix) const;
+private:
+	std::shared_ptr<ShvPathDictionary> m_pathDictionary;
+	/// domains and user IDs
+	ShvPathDictionary m_stringDictionary;
 
 	ShvLogHeader m_logHeader;
 	std::map<std::string, ShvLogTypeDescr> m_pathsTypeDescr;
 
 	std::vector<Entry> m_entries;
+	/// indexed by m_pathDictionary ID
+	std::vector<PathSeries> m_pathSeries;
+
+	/// ShvJournalEntry vector created by entries(), journal copy creates its own one when needed
+	struct EntriesCache
+	{
+		EntriesCache() {}
+		EntriesCache(const EntriesCache &) {}
+		EntriesCache& operator=(const EntriesCache &) { entries.reset(); return *this; }
+
+		std::mutex mutex;
+		std::unique_ptr<std::vector<ShvJournalEntry>> entries;
+	};
+	mutable EntriesCache m_entriesCache;
 
 	struct ShortTime {
 		int64_t epochTime = 0;
@@ -75,7 +173,8 @@ private:
 	};
 
 	bool m_isShortTimeCorrection = false;
-	std::map<std::string, ShortTime> m_recentShortTimes;
+	/// key is path ID
+	std::map<uint32_t, ShortTime> m_recentShortTimes;
 };
 
 } // namespace utils
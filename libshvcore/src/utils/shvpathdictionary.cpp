@@ -0,0 +1,28 @@
+#include "shvpathdictionary.h"
+
+namespace shv {
+namespace core {
+namespace utils {
+
+uint32_t ShvPathDictionary::intern(const std::string &s)
+{
+	auto it = m_ids.find(s);
+	if(it != m_ids.end())
+		return it->second;
+	uint32_t id = static_cast<uint32_t>(m_strings.size());
+	it = m_ids.emplace(s, id).first;
+	m_strings.push_back(&it->first);
+	return id;
+}
+
+uint32_t ShvPathDictionary::id(const std::string &s) const
+{
+	auto it = m_ids.find(s);
+	if(it == m_ids.end())
+		return NO_ID;
+	return it->second;
+}
+
+} // namespace utils
+} // namespace core
+} // namespace shv
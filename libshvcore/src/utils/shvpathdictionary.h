@@ -0,0 +1,44 @@
+#ifndef SHV_CORE_UTILS_SHVPATHDICTIONARY_H
+#define SHV_CORE_UTILS_SHVPATHDICTIONARY_H
+
+#include "../shvcoreglobal.h"
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace shv {
+namespace core {
+namespace utils {
+
+/// Interned strings with 32-bit IDs, every string is stored only once.
+///
+/// Journals keep path, domain and user ID of log entries as IDs, so the same few thousand paths
+/// are not copied to every of millions of entries. IDs are dense and never change, dictionary
+/// can be shared by more journals. Dictionary is not thread safe.
+class SHVCORE_DECL_EXPORT ShvPathDictionary
+{
+public:
+	static constexpr uint32_t NO_ID = std::numeric_limits<uint32_t>::max();
+
+	/// returns ID of s, s is added to dictionary if it is not there yet
+	uint32_t intern(const std::string &s);
+	/// returns NO_ID if s is not in dictionary
+	uint32_t id(const std::string &s) const;
+	const std::string& string(uint32_t id) const { return *m_strings[id]; }
+
+	size_t size() const { return m_strings.size(); }
+	bool isEmpty() const { return m_strings.empty(); }
+private:
+	std::unordered_map<std::string, uint32_t> m_ids;
+	/// points to keys of m_ids, unordered_map does not move its nodes
+	std::vector<const std::string*> m_strings;
+};
+
+} // namespace utils
+} // namespace core
+} // namespace shv
+
+#endif // SHV_CORE_UTILS_SHVPATHDICTIONARY_H
@@ -5,13 +5,17 @@ HEADERS += \
     $$PWD/shvfilejournal.h \
     $$PWD/shvgetlogparams.h \
     $$PWD/shvjournalentry.h \
+    $$PWD/shvjournalbinfilereader.h \
+    $$PWD/shvjournalbinfilewriter.h \
     $$PWD/shvjournalfilereader.h \
     $$PWD/shvjournalfilewriter.h \
     $$PWD/shvlogfilereader.h \
     $$PWD/shvlogheader.h \
     $$PWD/shvlogrpcvaluereader.h \
     $$PWD/shvlogtypeinfo.h \
+    $$PWD/shvlogwriter.h \
     $$PWD/shvmemoryjournal.h \
+    $$PWD/shvpathdictionary.h \
     $$PWD/versioninfo.h \
     $$PWD/clioptions.h \
     $$PWD/shvpath.h \
@@ -25,13 +29,17 @@ SOURCES += \
     $$PWD/shvfilejournal.cpp \
     $$PWD/shvgetlogparams.cpp \
     $$PWD/shvjournalentry.cpp \
+    $$PWD/shvjournalbinfilereader.cpp \
+    $$PWD/shvjournalbinfilewriter.cpp \
     $$PWD/shvjournalfilereader.cpp \
     $$PWD/shvjournalfilewriter.cpp \
     $$PWD/shvlogfilereader.cpp \
     $$PWD/shvlogheader.cpp \
     $$PWD/shvlogrpcvaluereader.cpp \
     $$PWD/shvlogtypeinfo.cpp \
+    $$PWD/shvlogwriter.cpp \
     $$PWD/shvmemoryjournal.cpp \
+    $$PWD/shvpathdictionary.cpp \
     $$PWD/versioninfo.cpp \
     $$PWD/clioptions.cpp \
     $$PWD/shvpath.cpp \
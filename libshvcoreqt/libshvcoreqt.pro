@@ -4,6 +4,7 @@ QT -= gui
 
 CONFIG += C++11
 CONFIG += hide_symbols
+include( $$PWD/../libshvchainpack/rpcvalueflatmap.pri )
 
 TEMPLATE = lib
 TARGET = shvcoreqt
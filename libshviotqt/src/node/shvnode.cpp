@@ -21,6 +21,7 @@
 #include <QFile>
 #include <cstring>
 #include <fstream>
+#include <typeinfo>
 
 namespace cp = shv::chainpack;
 
@@ -38,6 +39,9 @@ ShvNode::ShvNode(ShvNode *parent)
 	: QObject(parent)
 {
 	shvDebug() << __FUNCTION__ << this;
+	// ChildAdded event was sent to parent before this node was constructed
+	if(parent)
+		parent->addChildToIndex(this);
 }
 
 ShvNode::ShvNode(const std::string &node_id, ShvNode *parent)
@@ -48,6 +52,10 @@ ShvNode::ShvNode(const std::string &node_id, ShvNode *parent)
 
 ShvNode::~ShvNode()
 {
+	// parent cast fails when parent is being destroyed, its index is gone already then
+	ShvNode *parent_nd = parentNode();
+	if(parent_nd)
+		parent_nd->removeChildFromIndex(this);
 	/*
 	ShvNode *pnd = this->parentNode();
 	if(pnd && !pnd->isRootNode() && pnd->ownChildren().isEmpty()) {
@@ -64,10 +72,17 @@ ShvNode *ShvNode::parentNode() const
 
 ShvNode *ShvNode::childNode(const ShvNode::String &name, bool throw_exc) const
 {
-	ShvNode *nd = findChild<ShvNode*>(QString::fromStdString(name), Qt::FindDirectChildrenOnly);
-	if(throw_exc && !nd)
-		SHV_EXCEPTION("Child node id: " + name + " doesn't exist, parent node: " + shvPath());
-	return nd;
+	return childNode(StringView(name), throw_exc);
+}
+
+ShvNode *ShvNode::childNode(const core::StringView &name, bool throw_exc) const
+{
+	auto it = m_childNodes.find(name);
+	if(it != m_childNodes.end())
+		return it->second;
+	if(throw_exc)
+		SHV_EXCEPTION("Child node id: " + name.toString() + " doesn't exist, parent node: " + shvPath());
+	return nullptr;
 }
 
 void ShvNode::setParentNode(ShvNode *parent)
@@ -79,14 +94,71 @@ void ShvNode::setNodeId(ShvNode::String &&n)
 {
 	setObjectName(QString::fromStdString(n));
 	shvDebug() << __FUNCTION__ << this << n;
+	ShvNode *parent_nd = parentNode();
+	if(parent_nd)
+		parent_nd->removeChildFromIndex(this);
 	m_nodeId = std::move(n);
+	if(parent_nd)
+		parent_nd->addChildToIndex(this);
 }
 
 void ShvNode::setNodeId(const ShvNode::String &n)
 {
-	setObjectName(QString::fromStdString(n));
-	shvDebug() << __FUNCTION__ << this << n;
-	m_nodeId = n;
+	setNodeId(String(n));
+}
+
+void ShvNode::childEvent(QChildEvent *event)
+{
+	// cast fails for child being constructed or destroyed, such a child is handled in ShvNode constructor and destructor,
+	// events come here when existing node is reparented with setParent()
+	ShvNode *nd = qobject_cast<ShvNode*>(event->child());
+	if(nd) {
+		if(event->added())
+			addChildToIndex(nd);
+		else if(event->removed())
+			removeChildFromIndex(nd);
+	}
+	QObject::childEvent(event);
+}
+
+void ShvNode::addChildToIndex(ShvNode *nd)
+{
+	if(nd->m_nodeId.empty())
+		return;
+	auto it = m_childNodes.find(StringView(nd->m_nodeId));
+	if(it == m_childNodes.end()) {
+		m_childNodes[StringView(nd->m_nodeId)] = nd;
+	}
+	else if(it->second != nd) {
+		shvWarning() << "Duplicate child node id:" << nd->m_nodeId << "parent node:" << shvPath();
+		m_shadowedChildCount++;
+	}
+}
+
+void ShvNode::removeChildFromIndex(ShvNode *nd)
+{
+	if(nd->m_nodeId.empty())
+		return;
+	auto it = m_childNodes.find(StringView(nd->m_nodeId));
+	if(it == m_childNodes.end())
+		return;
+	if(it->second != nd) {
+		// shadowed duplicate
+		m_shadowedChildCount--;
+		return;
+	}
+	m_childNodes.erase(it);
+	if(m_shadowedChildCount > 0) {
+		// first remaining sibling with the same ID takes its place, as findChild() would return it
+		for(QObject *o : children()) {
+			ShvNode *sibling = qobject_cast<ShvNode*>(o);
+			if(sibling && sibling != nd && sibling->m_nodeId == nd->m_nodeId) {
+				m_childNodes[StringView(sibling->m_nodeId)] = sibling;
+				m_shadowedChildCount--;
+				break;
+			}
+		}
+	}
 }
 
 shv::core::utils::ShvPath ShvNode::shvPath() const
@@ -122,6 +194,22 @@ void ShvNode::deleteIfEmptyWithParents()
 	}
 }
 
+ShvNode *ShvNode::routeRequest(const StringViewList &shv_path, size_t &ix)
+{
+	ShvNode *nd = this;
+	while(ix < shv_path.size()) {
+		ShvNode *child = nd->childNode(shv_path[ix], !shv::core::Exception::Throw);
+		if(!child)
+			break;
+		nd = child;
+		ix++;
+		// descendants can reimplement request handling, they must get request themselves
+		if(typeid(*nd) != typeid(ShvNode))
+			break;
+	}
+	return nd;
+}
+
 void ShvNode::handleRawRpcRequest(cp::RpcValue::MetaData &&meta, std::string &&data)
 {
 	shvLogFuncFrame() << "node:" << nodeId() << "meta:" << meta.toPrettyString();
@@ -130,17 +218,18 @@ void ShvNode::handleRawRpcRequest(cp::RpcValue::MetaData &&meta, std::string &&d
 	core::StringViewList shv_path = shv::core::utils::ShvPath::split(shv_path_str);
 	cp::RpcResponse resp = cp::RpcResponse::forRequest(meta);
 	try {
-		if(!shv_path.empty()) {
-			ShvNode *nd = childNode(shv_path.at(0).toString(), !shv::core::Exception::Throw);
-			if(nd) {
-				shvDebug() << "Child node:" << shv_path.at(0).toString() << "on path:" << shv_path.join('/') << "FOUND";
-				std::string new_path = core::StringView::join(++shv_path.begin(), shv_path.end(), '/');
-				cp::RpcMessage::setShvPath(meta, new_path);
+		size_t ix = 0;
+		ShvNode *nd = routeRequest(shv_path, ix);
+		if(ix > 0) {
+			shvDebug() << "Child node:" << nd->nodeId() << "on path:" << shv_path.join('/') << "FOUND";
+			cp::RpcMessage::setShvPath(meta, core::StringView::join(shv_path.begin() + static_cast<ssize_t>(ix), shv_path.end(), '/'));
+			if(typeid(*nd) != typeid(ShvNode)) {
 				nd->handleRawRpcRequest(std::move(meta), std::move(data));
 				return;
 			}
+			shv_path.erase(shv_path.begin(), shv_path.begin() + static_cast<ssize_t>(ix));
 		}
-		const chainpack::MetaMethod *mm = metaMethod(shv_path, method);
+		const chainpack::MetaMethod *mm = nd->metaMethod(shv_path, method);
 		if(mm) {
 			shvDebug() << "Metamethod:" << method << "on path:" << shv_path.join('/') << "FOUND";
 			std::string errmsg;
@@ -149,7 +238,7 @@ void ShvNode::handleRawRpcRequest(cp::RpcValue::MetaData &&meta, std::string &&d
 				SHV_EXCEPTION(errmsg);
 
 			cp::RpcRequest rq(rpc_msg);
-			chainpack::RpcValue ret_val = processRpcRequest(rq);
+			chainpack::RpcValue ret_val = nd->processRpcRequest(rq);
 			if(ret_val.isValid()) {
 				resp.setResult(ret_val);
 			}
@@ -189,22 +278,24 @@ void ShvNode::handleRpcRequest(const chainpack::RpcRequest &rq)
 	core::StringViewList shv_path = shv::core::utils::ShvPath::split(shv_path_str);
 	cp::RpcResponse resp = cp::RpcResponse::forRequest(rq);
 	try {
-		if(!shv_path.empty()) {
-			ShvNode *nd = childNode(shv_path.at(0).toString(), !shv::core::Exception::Throw);
-			if(nd) {
-				shvDebug() << "Child node:" << shv_path.at(0).toString() << "on path:" << shv_path.join('/') << "FOUND";
-				std::string new_path = core::StringView::join(++shv_path.begin(), shv_path.end(), '/');
-				chainpack::RpcRequest rq2(rq);
-				//cp::RpcValue::MetaData meta2(meta);
-				rq2.setShvPath(new_path);
+		size_t ix = 0;
+		ShvNode *nd = routeRequest(shv_path, ix);
+		// request is copied only once, when shv path is rewritten for destination node
+		chainpack::RpcRequest rq2;
+		if(ix > 0) {
+			shvDebug() << "Child node:" << nd->nodeId() << "on path:" << shv_path.join('/') << "FOUND";
+			rq2 = rq;
+			rq2.setShvPath(core::StringView::join(shv_path.begin() + static_cast<ssize_t>(ix), shv_path.end(), '/'));
+			if(typeid(*nd) != typeid(ShvNode)) {
 				nd->handleRpcRequest(rq2);
 				return;
 			}
+			shv_path.erase(shv_path.begin(), shv_path.begin() + static_cast<ssize_t>(ix));
 		}
-		const chainpack::MetaMethod *mm = metaMethod(shv_path, method);
+		const chainpack::MetaMethod *mm = nd->metaMethod(shv_path, method);
 		if(mm) {
 			shvDebug() << "Metamethod:" << method << "on path:" << shv_path.join('/') << "FOUND";
-			chainpack::RpcValue ret_val = processRpcRequest(rq);
+			chainpack::RpcValue ret_val = nd->processRpcRequest((ix > 0)? rq2: rq);
 			if(ret_val.isValid()) {
 				resp.setResult(ret_val);
 			}
@@ -303,7 +394,7 @@ ShvNode::StringList ShvNode::childNames(const StringViewList &shv_path)
 		}
 	}
 	else if(shv_path.size() == 1) {
-		ShvNode *nd = childNode(shv_path.at(0).toString(), !shv::core::Exception::Throw);
+		ShvNode *nd = childNode(shv_path.at(0), !shv::core::Exception::Throw);
 		if(nd)
 			ret = nd->childNames(StringViewList());
 	}
@@ -315,7 +406,7 @@ chainpack::RpcValue ShvNode::hasChildren(const StringViewList &shv_path)
 {
 	shvLogFuncFrame() << "node:" << nodeId() << "shv_path:" << shv_path.join('/');
 	if(shv_path.size() == 1) {
-		ShvNode *nd = childNode(shv_path.at(0).toString(), !shv::core::Exception::Throw);
+		ShvNode *nd = childNode(shv_path.at(0), !shv::core::Exception::Throw);
 		if(nd) {
 			return nd->hasChildren(StringViewList());
 		}
@@ -12,6 +12,7 @@
 #include <QMetaProperty>
 
 #include <cstddef>
+#include <unordered_map>
 
 //namespace shv { namespace chainpack { class MetaMethod; }}
 //namespace shv { namespace chainpack { class MetaMethod; class RpcValue; class RpcMessage; class RpcRequest; }}
@@ -43,8 +44,12 @@ public:
 	//size_t childNodeCount() const {return propertyNames().size();}
 	ShvNode* parentNode() const;
 	QList<ShvNode*> ownChildren() const;
-	virtual ShvNode* childNode(const String &name, bool throw_exc = true) const;
-	//ShvNode* childNode(const core::StringView &name) const;
+	ShvNode* childNode(const String &name, bool throw_exc = true) const;
+	/// direct child lookup by node ID, request routing, childNames() and hasChildren() use it,
+	/// reimplement this overload to provide children which are not in the index.
+	/// Children are looked up by nodeId(), not by QObject::objectName(), setNodeId() keeps them the same,
+	/// but node renamed by QObject::setObjectName() only is still found by its original ID
+	virtual ShvNode* childNode(const core::StringView &name, bool throw_exc = true) const;
 	virtual void setParentNode(ShvNode *parent);
 	virtual String nodeId() const {return m_nodeId;}
 	void setNodeId(String &&n);
@@ -94,10 +99,24 @@ public:
 	Q_SIGNAL void logUserCommand(const shv::core::utils::ShvJournalEntry &e);
 
 protected:
+	void childEvent(QChildEvent *event) override;
+
 	bool m_isRootNode = false;
+private:
+	/// walks children on shv_path from segment ix in single pass, ix is moved behind the last found node,
+	/// walk stops on node of ShvNode descendant type, since it can reimplement request handling
+	ShvNode* routeRequest(const StringViewList &shv_path, size_t &ix);
+	void addChildToIndex(ShvNode *nd);
+	void removeChildFromIndex(ShvNode *nd);
 private:
 	String m_nodeId;
 	bool m_isSortedChildren = true;
+	/// direct children by node ID, key points to child's m_nodeId
+	/// children are added in ShvNode constructor and removed in destructor,
+	/// setNodeId() and childEvent() keep index up to date when node is renamed or reparented
+	std::unordered_map<StringView, ShvNode*> m_childNodes;
+	/// count of children not in index, because sibling with the same ID is there already
+	size_t m_shadowedChildCount = 0;
 };
 
 /// helper class to save lines when creating root node
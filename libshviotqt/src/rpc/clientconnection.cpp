@@ -174,10 +174,8 @@ void ClientConnection::setCheckBrokerConnectedInterval(int ms)
 
 void ClientConnection::sendMessage(const cp::RpcMessage &rpc_msg)
 {
-	if(rpc_msg.isSignal() && shv::core::String::endsWith(rpc_msg.shvPath().asString(), "server/time")) {
-		// skip annoying messages
-	}
-	else {
+	// signal path is checked only when message is logged, server/time signals are skipped as annoying
+	if(isLogRpcMsgEnabled() && !(rpc_msg.isSignal() && shv::core::String::endsWith(rpc_msg.shvPath().asString(), "server/time"))) {
 		logRpcMsg() << SND_LOG_ARROW
 					<< "client id:" << connectionId()
 					<< "protocol_type:" << (int)protocolType() << shv::chainpack::Rpc::protocolTypeToString(protocolType())
@@ -194,10 +192,8 @@ void ClientConnection::sendMessage(const cp::RpcMessage &rpc_msg)
 
 void ClientConnection::onRpcMessageReceived(const chainpack::RpcMessage &msg)
 {
-	if(msg.isSignal() && shv::core::String::endsWith(msg.shvPath().asString(), "server/time")) {
-		// skip annoying messages
-	}
-	else {
+	// signal path is checked only when message is logged, server/time signals are skipped as annoying
+	if(isLogRpcMsgEnabled() && !(msg.isSignal() && shv::core::String::endsWith(msg.shvPath().asString(), "server/time"))) {
 		logRpcMsg() << cp::RpcDriver::RCV_LOG_ARROW
 					<< "client id:" << connectionId()
 					<< "protocol_type:" << (int)protocolType() << shv::chainpack::Rpc::protocolTypeToString(protocolType())
@@ -15,6 +15,8 @@ namespace rpc {
 //======================================================
 // Socket
 //======================================================
+constexpr qint64 Socket::DEFAULT_MAX_BYTES_TO_WRITE;
+
 Socket::Socket(QObject *parent)
 	: QObject(parent)
 {
@@ -84,7 +86,30 @@ QByteArray TcpSocket::readAll()
 
 qint64 TcpSocket::write(const char *data, qint64 max_size)
 {
-	return m_socket->write(data, max_size);
+	// peer does not read fast enough, stop coalescing and leave the rest in RPC driver send queue,
+	// writing continues on bytesWritten()
+	if(isWriteBufferFull())
+		return 0;
+	// coalesce messages, they are passed to QTcpSocket in single write() call in flush()
+	m_writeBuffer.append(data, static_cast<int>(max_size));
+	return max_size;
+}
+
+qint64 TcpSocket::bytesToWrite() const
+{
+	return m_socket->bytesToWrite() + m_writeBuffer.size();
+}
+
+bool TcpSocket::flush()
+{
+	/// do not call QTcpSocket::flush() here, see writeMessageEnd()
+	if(m_writeBuffer.isEmpty())
+		return false;
+	qint64 n = m_socket->write(m_writeBuffer);
+	m_writeBuffer.clear();
+	if(n < 0)
+		shvWarning() << "Write socket error:" << m_socket->errorString();
+	return n > 0;
 }
 
 void TcpSocket::writeMessageEnd()
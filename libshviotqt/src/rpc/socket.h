@@ -32,12 +32,21 @@ public:
 	virtual quint16  peerPort() const = 0;
 
 	virtual QByteArray readAll() = 0;
+	/// returns 0 when bytesToWrite() reaches maxBytesToWrite(), data stays in RPC driver send queue then
 	virtual qint64 write(const char *data, qint64 max_size) = 0;
-	//virtual bool flush() = 0;
+	/// bytes accepted by write() and not written to the network yet
+	virtual qint64 bytesToWrite() const {return 0;}
+	/// write data of all the messages written since last flush to the underlying socket
+	virtual bool flush() {return false;}
 	virtual void writeMessageBegin() = 0;
 	virtual void writeMessageEnd() = 0;
 	virtual void ignoreSslErrors() = 0;
 
+	static constexpr qint64 DEFAULT_MAX_BYTES_TO_WRITE = 256 * 1024;
+	/// 0 means unlimited
+	qint64 maxBytesToWrite() const {return m_maxBytesToWrite;}
+	void setMaxBytesToWrite(qint64 n) {m_maxBytesToWrite = n;}
+
 	Q_SIGNAL void connected();
 	Q_SIGNAL void disconnected();
 	Q_SIGNAL void readyRead();
@@ -47,6 +56,10 @@ public:
 	Q_SIGNAL void  stateChanged(QAbstractSocket::SocketState state);
 	Q_SIGNAL void error(QAbstractSocket::SocketError socket_error);
 	Q_SIGNAL void sslErrors(const QList<QSslError> &errors);
+protected:
+	bool isWriteBufferFull() const {return m_maxBytesToWrite > 0 && bytesToWrite() >= m_maxBytesToWrite;}
+protected:
+	qint64 m_maxBytesToWrite = DEFAULT_MAX_BYTES_TO_WRITE;
 };
 
 class SHVIOTQT_DECL_EXPORT TcpSocket : public Socket
@@ -66,13 +79,15 @@ public:
 	quint16 peerPort() const override;
 	QByteArray readAll() override;
 	qint64 write(const char *data, qint64 max_size) override;
-	//bool flush() override;
+	qint64 bytesToWrite() const override;
+	bool flush() override;
 	void writeMessageBegin() override {}
 	void writeMessageEnd() override;
 	void ignoreSslErrors() override {}
 
 protected:
 	QTcpSocket *m_socket = nullptr;
+	QByteArray m_writeBuffer;
 };
 
 class SHVIOTQT_DECL_EXPORT SslSocket : public TcpSocket
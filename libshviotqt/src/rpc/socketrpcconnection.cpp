@@ -153,6 +153,13 @@ void SocketRpcConnection::writeMessageEnd()
 		m_socket->writeMessageEnd();
 }
 
+bool SocketRpcConnection::flush()
+{
+	if(m_socket)
+		return m_socket->flush();
+	return false;
+}
+
 #if 0
 namespace {
 class ConnectionScope
@@ -54,7 +54,7 @@ protected:
 	int64_t writeBytes(const char *bytes, size_t length) Q_DECL_OVERRIDE;
 	void writeMessageBegin() override;
 	void writeMessageEnd() override;
-	//bool flush() Q_DECL_OVERRIDE;
+	bool flush() Q_DECL_OVERRIDE;
 
 	Socket* socket();
 	void onReadyRead();
@@ -20,6 +20,7 @@ with-shvwebsockets {
 }
 
 CONFIG += c++11
+include( $$LIBSHV_SRC_DIR/libshvchainpack/rpcvalueflatmap.pri )
 
 TEMPLATE = app
 TARGET = sampleshvbroker
@@ -14,6 +14,7 @@ isEmpty(LIBSHV_SRC_DIR) {
 QT += core network
 QT -= gui
 CONFIG += c++11
+include( $$LIBSHV_SRC_DIR/libshvchainpack/rpcvalueflatmap.pri )
 
 TEMPLATE = app
 TARGET = sampleshvclient
@@ -0,0 +1,9 @@
+include ( ../test_libshvbroker.pri )
+
+TARGET = tst_accessrulestree
+
+
+SOURCES += \
+    $${TARGET}.cpp \
+    $$BROKER_SRC_DIR/accessrulestree.cpp \
+
@@ -0,0 +1,176 @@
+#include "accessrulestree.h"
+
+#include <shv/chainpack/rpc.h>
+
+#include <QtTest/QtTest>
+#include <QDebug>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace shv::broker;
+namespace acl = shv::iotqt::acl;
+namespace cp = shv::chainpack;
+
+namespace {
+
+struct Role
+{
+	int weight;
+	acl::AclRoleAccessRules rules;
+};
+
+/// roles must be sorted by weight DESC
+AccessRulesTree compile_rules(const std::vector<Role> &roles)
+{
+	AccessRulesTree tree;
+	for(const Role &role : roles)
+		tree.addRoleRules(role.weight, role.rules);
+	return tree;
+}
+
+/// naive rule evaluation as it was done by BrokerApp::accessGrantForRequest() before rules were compiled
+acl::AclAccessRule most_specific_rule(const std::vector<Role> &roles, const std::string &shv_path, const std::string &method)
+{
+	acl::AclAccessRule most_specific_rule;
+	int old_weight = std::numeric_limits<int>::max();
+	for(const Role &role : roles) {
+		if(role.weight != old_weight) {
+			if(most_specific_rule.isValid())
+				break;
+			old_weight = role.weight;
+		}
+		for(const acl::AclAccessRule &access_rule : role.rules) {
+			if(access_rule.isPathMethodMatch(shv_path, method) && access_rule.isMoreSpecificThan(most_specific_rule))
+				most_specific_rule = access_rule;
+		}
+	}
+	return most_specific_rule;
+}
+
+acl::AclAccessRule rule(const std::string &path_pattern, const std::string &method, const std::string &role)
+{
+	return acl::AclAccessRule(path_pattern, method, cp::AccessGrant(role));
+}
+
+acl::AclRoleAccessRules role_rules(const std::vector<acl::AclAccessRule> &rules)
+{
+	acl::AclRoleAccessRules ret;
+	ret.insert(ret.end(), rules.begin(), rules.end());
+	return ret;
+}
+
+bool is_same_rule(const acl::AclAccessRule &r1, const acl::AclAccessRule &r2)
+{
+	return r1.isValid() == r2.isValid()
+			&& r1.pathPattern == r2.pathPattern
+			&& r1.method == r2.method
+			&& r1.grant.role == r2.grant.role;
+}
+
+const std::vector<std::string> PATTERNS = {
+	"**",
+	"a/**",
+	"a//**",
+	"a/b/**",
+	"a/b//**",
+	"a/b/c/**",
+	"ab/**",
+	"a",
+	"a/b",
+	"a/b/c",
+	"a/bc",
+	".broker/app/**",
+	".broker/app",
+};
+
+const std::vector<std::string> PATHS = {
+	"",
+	"a",
+	"a/",
+	"a/b",
+	"a/b/",
+	"a/b/c",
+	"a/b/c/d",
+	"a/bc",
+	"a//b",
+	"ab",
+	"ab/c",
+	"x/y",
+	".broker/app",
+	".broker/app/log",
+};
+
+const std::vector<std::string> METHODS = {"", "get", "set"};
+const std::vector<std::string> GRANTS = {cp::Rpc::ROLE_BROWSE, cp::Rpc::ROLE_READ, cp::Rpc::ROLE_WRITE, cp::Rpc::ROLE_COMMAND};
+}
+
+class TestAccessRulesTree : public QObject
+{
+	Q_OBJECT
+private slots:
+	void mostSpecificRuleTest()
+	{
+		std::vector<Role> roles = {
+			{100, role_rules({rule("a/b/**", "", cp::Rpc::ROLE_READ), rule("a/b", "set", cp::Rpc::ROLE_WRITE)})},
+			{10, role_rules({rule("**", "", cp::Rpc::ROLE_BROWSE), rule("a/b/c", "", cp::Rpc::ROLE_COMMAND)})},
+		};
+		AccessRulesTree tree = compile_rules(roles);
+		QCOMPARE(tree.ruleCount(), size_t(4));
+		QCOMPARE(tree.mostSpecificRule("a/b", "set").grant.role, std::string(cp::Rpc::ROLE_WRITE));
+		QCOMPARE(tree.mostSpecificRule("a/b", "get").grant.role, std::string(cp::Rpc::ROLE_READ));
+		// higher weight role wins even if lower weight role has more specific rule
+		QCOMPARE(tree.mostSpecificRule("a/b/c", "get").grant.role, std::string(cp::Rpc::ROLE_READ));
+		// lower weight roles are checked only when higher weight roles have no match
+		QCOMPARE(tree.mostSpecificRule("x", "get").grant.role, std::string(cp::Rpc::ROLE_BROWSE));
+		QVERIFY(!AccessRulesTree().mostSpecificRule("x", "get").isValid());
+	}
+
+	/// compiled rules must give the same result as naive evaluation of all the rules
+	void linearMatchTest()
+	{
+		// every pattern with every method in 3 roles, 2 of them having the same weight,
+		// rules overlap, so rule order and role weight decide as well
+		std::vector<Role> roles(3);
+		roles[0].weight = 100;
+		roles[1].weight = 50;
+		roles[2].weight = 50;
+		size_t n = 0;
+		for(const std::string &pattern : PATTERNS) {
+			for(const std::string &method : METHODS) {
+				Role &role = roles[n % roles.size()];
+				role.rules.push_back(rule(pattern, method, GRANTS[n % GRANTS.size()]));
+				n++;
+			}
+		}
+		// check also all the subsets given by leaving out every k-th rule
+		for(size_t k = 1; k <= 5; ++k) {
+			std::vector<Role> subset = roles;
+			size_t i = 0;
+			for(Role &role : subset) {
+				acl::AclRoleAccessRules rules;
+				for(const acl::AclAccessRule &r : role.rules) {
+					if(k == 1 || ++i % k)
+						rules.push_back(r);
+				}
+				role.rules = rules;
+			}
+			AccessRulesTree tree = compile_rules(subset);
+			for(const std::string &path : PATHS) {
+				for(const std::string &method : METHODS) {
+					const acl::AclAccessRule expected = most_specific_rule(subset, path, method);
+					const acl::AclAccessRule compiled = tree.mostSpecificRule(path, method);
+					if(!is_same_rule(compiled, expected))
+						qWarning() << "path:" << path.c_str() << "method:" << method.c_str()
+								   << "expected:" << expected.pathPattern.c_str() << expected.method.c_str()
+								   << "compiled:" << compiled.pathPattern.c_str() << compiled.method.c_str();
+					QVERIFY(is_same_rule(compiled, expected));
+				}
+			}
+		}
+	}
+};
+
+QTEST_MAIN(TestAccessRulesTree)
+#include "tst_accessrulestree.moc"
@@ -0,0 +1,9 @@
+include ( ../test_libshvbroker.pri )
+
+TARGET = tst_subscriptionindex
+
+
+SOURCES += \
+    $${TARGET}.cpp \
+    $$BROKER_SRC_DIR/subscriptionindex.cpp \
+
@@ -0,0 +1,174 @@
+#include "subscriptionindex.h"
+
+#include <shv/core/stringview.h>
+#include <shv/core/utils/shvpath.h>
+
+#include <QtTest/QtTest>
+#include <QDebug>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace shv::broker;
+using shv::core::utils::ShvPath;
+
+namespace {
+
+struct Subscription
+{
+	int connectionId;
+	std::string localPath;
+	std::string method;
+};
+
+/// signal matching as done by CommonRpcClientHandle::Subscription::match() for every subscription
+std::vector<int> subscribed_connections(const std::vector<Subscription> &subscriptions, const std::string &shv_path, const std::string &method)
+{
+	std::vector<int> ret;
+	for(const Subscription &subs : subscriptions) {
+		if(ShvPath::startsWithPath(shv::core::StringView(shv_path), subs.localPath) && (subs.method.empty() || subs.method == method))
+			ret.push_back(subs.connectionId);
+	}
+	std::sort(ret.begin(), ret.end());
+	ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+	return ret;
+}
+
+const std::vector<std::string> SIGNAL_PATHS = {
+	"",
+	"a",
+	"a/b",
+	"a/b/c",
+	"a/bc",
+	"a/b/",
+	"a//b",
+	"x/y/z",
+	"zone1/heater2/temperature",
+};
+
+const std::vector<std::string> LOCAL_PATHS = {
+	"",
+	"a",
+	"a/b",
+	"a/b/",
+	"a/",
+	"a/b/c",
+	"ab",
+	"x",
+	"zone1/heater2",
+};
+
+const std::vector<std::string> METHODS = {"", "chng", "fchng"};
+}
+
+class TestSubscriptionIndex : public QObject
+{
+	Q_OBJECT
+private slots:
+	void subscribeTest()
+	{
+		SubscriptionIndex index;
+		QCOMPARE(index.subscriptionCount(), size_t(0));
+		QVERIFY(index.subscribedConnections("a/b", "chng").empty());
+
+		index.addSubscription(1, "a/b", "chng");
+		index.addSubscription(2, "a", "");
+		index.addSubscription(3, "", "chng");
+		QCOMPARE(index.subscriptionCount(), size_t(3));
+
+		QCOMPARE(index.subscribedConnections("a/b", "chng"), std::vector<int>({1, 2, 3}));
+		QCOMPARE(index.subscribedConnections("a/b/c", "chng"), std::vector<int>({1, 2, 3}));
+		QCOMPARE(index.subscribedConnections("a/bc", "chng"), std::vector<int>({2, 3}));
+		QCOMPARE(index.subscribedConnections("a/b", "fchng"), std::vector<int>({2}));
+		QCOMPARE(index.subscribedConnections("x", "chng"), std::vector<int>({3}));
+		QVERIFY(index.subscribedConnections("x", "fchng").empty());
+	}
+
+	void unsubscribeTest()
+	{
+		SubscriptionIndex index;
+		index.addSubscription(1, "a/b", "chng");
+		index.addSubscription(1, "a/b", "chng");
+		index.addSubscription(2, "a/b", "");
+		QCOMPARE(index.subscriptionCount(), size_t(3));
+
+		// subscriptions are reference counted
+		index.removeSubscription(1, "a/b", "chng");
+		QCOMPARE(index.subscriptionCount(), size_t(2));
+		QCOMPARE(index.subscribedConnections("a/b", "chng"), std::vector<int>({1, 2}));
+		index.removeSubscription(1, "a/b", "chng");
+		QCOMPARE(index.subscribedConnections("a/b", "chng"), std::vector<int>({2}));
+
+		// not existing subscriptions are ignored
+		index.removeSubscription(1, "a/b", "chng");
+		index.removeSubscription(2, "a/b", "chng");
+		index.removeSubscription(2, "a/b/c", "");
+		index.removeSubscription(3, "a/b", "");
+		QCOMPARE(index.subscriptionCount(), size_t(1));
+		QCOMPARE(index.subscribedConnections("a/b", "chng"), std::vector<int>({2}));
+
+		index.removeSubscription(2, "a/b", "");
+		QCOMPARE(index.subscriptionCount(), size_t(0));
+		QVERIFY(index.subscribedConnections("a/b", "chng").empty());
+	}
+
+	void removeConnectionTest()
+	{
+		SubscriptionIndex index;
+		index.addSubscription(1, "a/b", "chng");
+		index.addSubscription(1, "a/b", "chng");
+		index.addSubscription(1, "x", "");
+		index.addSubscription(2, "a", "chng");
+		index.addSubscription(2, "x/y", "");
+		QCOMPARE(index.subscriptionCount(), size_t(5));
+
+		index.removeConnection(1);
+		QCOMPARE(index.subscriptionCount(), size_t(2));
+		QCOMPARE(index.subscribedConnections("a/b", "chng"), std::vector<int>({2}));
+		QVERIFY(index.subscribedConnections("x", "chng").empty());
+		QCOMPARE(index.subscribedConnections("x/y/z", "chng"), std::vector<int>({2}));
+
+		index.removeConnection(3);
+		QCOMPARE(index.subscriptionCount(), size_t(2));
+		index.removeConnection(2);
+		QCOMPARE(index.subscriptionCount(), size_t(0));
+		QVERIFY(index.subscribedConnections("a/b", "chng").empty());
+		QVERIFY(index.subscribedConnections("x/y", "chng").empty());
+	}
+
+	/// index result must be the same as matching all the subscriptions one by one
+	void linearMatchTest()
+	{
+		std::vector<Subscription> subscriptions;
+		SubscriptionIndex index;
+		int connection_id = 0;
+		for(const std::string &local_path : LOCAL_PATHS) {
+			for(const std::string &method : METHODS) {
+				subscriptions.push_back(Subscription{++connection_id, local_path, method});
+				index.addSubscription(connection_id, local_path, method);
+			}
+		}
+		auto check = [&]() {
+			for(const std::string &shv_path : SIGNAL_PATHS) {
+				for(const std::string &method : METHODS) {
+					if(method.empty())
+						continue;
+					QCOMPARE(index.subscribedConnections(shv_path, method), subscribed_connections(subscriptions, shv_path, method));
+				}
+			}
+		};
+		check();
+		// remove every other subscription
+		for(size_t i = 0; i < subscriptions.size(); ++i) {
+			const Subscription &subs = subscriptions[i];
+			index.removeSubscription(subs.connectionId, subs.localPath, subs.method);
+			subscriptions.erase(subscriptions.begin() + static_cast<std::ptrdiff_t>(i));
+		}
+		QCOMPARE(index.subscriptionCount(), subscriptions.size());
+		check();
+	}
+};
+
+QTEST_MAIN(TestSubscriptionIndex)
+#include "tst_subscriptionindex.moc"
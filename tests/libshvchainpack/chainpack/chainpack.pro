@@ -2,7 +2,10 @@ TEMPLATE = subdirs
 CONFIG += ordered
 
 SUBDIRS += \
+	flatmap \
 	rpcvalue \
 	rpcmessage \
+	rpcdriver \
+	rpcvaluebenchmark \
 	tst_ccpcp \
 
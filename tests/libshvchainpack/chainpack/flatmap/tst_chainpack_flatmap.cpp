@@ -0,0 +1,177 @@
+#include <shv/chainpack/flatmap.h>
+#include <shv/chainpack/rpcvalue.h>
+
+#include <QtTest/QtTest>
+#include <QDebug>
+
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace shv::chainpack;
+
+namespace {
+
+using StringMap = FlatMap<std::string, int>;
+
+// key cannot be modified through iterator, like in std::map
+static_assert(std::is_same<decltype((*std::declval<StringMap::iterator>()).first), const std::string&>::value, "key must be const");
+static_assert(std::is_same<decltype(std::declval<StringMap::iterator>()->first), const std::string&>::value, "key must be const");
+static_assert(std::is_same<decltype(std::declval<StringMap::iterator>()->second), int&>::value, "value must be mutable");
+static_assert(std::is_same<decltype(std::declval<StringMap::const_iterator>()->second), const int&>::value, "value must be const");
+static_assert(std::is_convertible<StringMap::iterator, StringMap::const_iterator>::value, "iterator must convert to const_iterator");
+static_assert(!std::is_convertible<StringMap::const_iterator, StringMap::iterator>::value, "const_iterator must not convert to iterator");
+
+template<typename M>
+std::vector<std::pair<std::string, int>> items(const M &map)
+{
+	std::vector<std::pair<std::string, int>> ret;
+	for(const auto &kv : map)
+		ret.emplace_back(kv.first, kv.second);
+	return ret;
+}
+}
+
+class TestFlatMap : public QObject
+{
+	Q_OBJECT
+private slots:
+	void insertTest()
+	{
+		StringMap map;
+		QVERIFY(map.empty());
+		QVERIFY(map.insert(std::make_pair(std::string("b"), 2)).second);
+		QVERIFY(map.insert(StringMap::value_type("d", 4)).second);
+		QVERIFY(map.emplace("a", 1).second);
+		QVERIFY(map.try_emplace("c", 3).second);
+		// existing keys are not overwritten
+		auto ret = map.insert(std::make_pair(std::string("b"), 20));
+		QVERIFY(!ret.second);
+		QCOMPARE(ret.first->first, std::string("b"));
+		QCOMPARE(ret.first->second, 2);
+		QVERIFY(!map.emplace("a", 10).second);
+		QCOMPARE(map.size(), size_t(4));
+		map["e"] = 5;
+		map["a"] = 11;
+		QCOMPARE(map.at("a"), 11);
+		QCOMPARE(map.size(), size_t(5));
+
+		StringMap map2{{"x", 1}, {"a", 2}};
+		map2.insert(map.begin(), map.end());
+		QCOMPARE(map2.size(), size_t(6));
+		QCOMPARE(map2.at("a"), 2);
+	}
+
+	void iterationOrderTest()
+	{
+		StringMap map{{"c", 3}, {"a", 1}, {"d", 4}, {"b", 2}};
+		std::vector<std::pair<std::string, int>> expected = {{"a", 1}, {"b", 2}, {"c", 3}, {"d", 4}};
+		QVERIFY(items(map) == expected);
+		// values can be modified through iterator
+		for(auto &&kv : map)
+			kv.second *= 10;
+		for(auto it = map.begin(); it != map.end(); ++it)
+			it->second += 1;
+		expected = {{"a", 11}, {"b", 21}, {"c", 31}, {"d", 41}};
+		QVERIFY(items(map) == expected);
+		std::vector<std::string> reversed;
+		for(auto it = map.rbegin(); it != map.rend(); ++it)
+			reversed.push_back((*it).first);
+		QVERIFY(reversed == std::vector<std::string>({"d", "c", "b", "a"}));
+		QCOMPARE(map.end() - map.begin(), StringMap::difference_type(4));
+		QCOMPARE(map.begin()[2].first, std::string("c"));
+	}
+
+	void findTest()
+	{
+		const StringMap map{{"a", 1}, {"c", 3}};
+		QVERIFY(map.find("b") == map.end());
+		QVERIFY(map.find("") == map.end());
+		QVERIFY(map.find("d") == map.end());
+		QVERIFY(map.find("c") != map.end());
+		QCOMPARE(map.find("c")->second, 3);
+		QCOMPARE(map.count("a"), size_t(1));
+		QCOMPARE(map.count("b"), size_t(0));
+		QCOMPARE(map.lower_bound("b")->first, std::string("c"));
+		QCOMPARE(map.upper_bound("a")->first, std::string("c"));
+		QVERIFY(map.upper_bound("c") == map.end());
+		QVERIFY_EXCEPTION_THROWN(map.at("b"), std::out_of_range);
+		QVERIFY(StringMap().find("a") == StringMap().end());
+	}
+
+	void eraseTest()
+	{
+		StringMap map{{"a", 1}, {"b", 2}, {"c", 3}, {"d", 4}, {"e", 5}};
+		QCOMPARE(map.erase("x"), size_t(0));
+		QCOMPARE(map.erase("b"), size_t(1));
+		auto it = map.erase(map.find("c"));
+		QCOMPARE(it->first, std::string("d"));
+		it = map.erase(map.find("d"), map.end());
+		QVERIFY(it == map.end());
+		std::vector<std::pair<std::string, int>> expected = {{"a", 1}};
+		QVERIFY(items(map) == expected);
+		map.clear();
+		QVERIFY(map.empty());
+		QCOMPARE(map.erase("a"), size_t(0));
+	}
+
+	void compareTest()
+	{
+		StringMap map1{{"a", 1}, {"b", 2}};
+		StringMap map2{{"b", 2}, {"a", 1}};
+		QVERIFY(map1 == map2);
+		map2["b"] = 3;
+		QVERIFY(map1 != map2);
+		QVERIFY(map1 < map2);
+		map1.swap(map2);
+		QCOMPARE(map1.at("b"), 3);
+		QCOMPARE(map2.at("b"), 2);
+	}
+
+	/// random operations must give the same result as with std::map
+	void stdMapEquivalenceTest()
+	{
+		std::mt19937 mt(1);
+		std::uniform_int_distribution<int> rnd_key(0, 200);
+		std::uniform_int_distribution<int> rnd_op(0, 3);
+		std::map<std::string, int> expected;
+		StringMap map;
+		for (int i = 0; i < 5000; ++i) {
+			const std::string key = "key" + std::to_string(rnd_key(mt));
+			switch (rnd_op(mt)) {
+			case 0:
+				QCOMPARE(map.insert(std::make_pair(key, i)).second, expected.insert(std::make_pair(key, i)).second);
+				break;
+			case 1:
+				map[key] = i;
+				expected[key] = i;
+				break;
+			case 2:
+				QCOMPARE(map.erase(key), expected.erase(key));
+				break;
+			default:
+				QCOMPARE(map.count(key), expected.count(key));
+				break;
+			}
+		}
+		QCOMPARE(map.size(), expected.size());
+		QVERIFY(items(map) == items(expected));
+	}
+
+	void rpcValueTest()
+	{
+		FlatMap<std::string, RpcValue> map;
+		map["foo"] = RpcValue::List{1, 2};
+		map["bar"] = "baz";
+		RpcValue::Map rmap;
+		for(const auto &kv : map)
+			rmap[kv.first] = kv.second;
+		QCOMPARE(RpcValue(rmap).toCpon(), std::string(R"({"bar":"baz","foo":[1,2]})"));
+	}
+};
+
+QTEST_MAIN(TestFlatMap)
+#include "tst_chainpack_flatmap.moc"
@@ -0,0 +1,375 @@
+#include <shv/chainpack/rpcdriver.h>
+#include <shv/chainpack/rpcmessage.h>
+
+#include <necrolog.h>
+
+#include <QtTest/QtTest>
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace shv::chainpack;
+using std::string;
+
+namespace {
+
+/// RPC driver writing to and reading from memory buffer
+class LoopbackRpcDriver : public RpcDriver
+{
+public:
+	LoopbackRpcDriver()
+	{
+		setProtocolType(Rpc::ProtocolType::ChainPack);
+	}
+
+	std::string takeWrittenData()
+	{
+		std::string ret;
+		ret.swap(m_writtenData);
+		return ret;
+	}
+	void receiveData(std::string &&data) { onBytesRead(std::move(data)); }
+	void receiveData(const std::string &data) { onBytesRead(std::string(data)); }
+	void writeQueuedData() { enqueueDataToSend(MessageData()); }
+
+	/// simulate full socket write buffer
+	bool writeBlocked = false;
+	/// simulate socket accepting only part of data, 0 means no limit
+	size_t writeLimit = 0;
+	int flushCount = 0;
+	bool keepReceivedMessages = true;
+	std::vector<RpcValue> receivedMessages;
+	size_t receivedMessageCount = 0;
+	int exceptionCount = 0;
+	int overflowCount = 0;
+protected:
+	bool isOpen() override { return true; }
+	void writeMessageBegin() override {}
+	void writeMessageEnd() override {}
+	int64_t writeBytes(const char *bytes, size_t length) override
+	{
+		if(writeBlocked)
+			return 0;
+		if(writeLimit > 0 && length > writeLimit)
+			length = writeLimit;
+		m_writtenData.append(bytes, length);
+		return static_cast<int64_t>(length);
+	}
+	bool flush() override
+	{
+		flushCount++;
+		return true;
+	}
+	void onRpcValueReceived(const RpcValue &msg) override
+	{
+		receivedMessageCount++;
+		if(keepReceivedMessages)
+			receivedMessages.push_back(msg);
+	}
+	void onProcessReadDataException(std::exception &e) override
+	{
+		qWarning() << "process read data exception:" << e.what();
+		exceptionCount++;
+	}
+	void onSendQueueOverflow() override { overflowCount++; }
+private:
+	std::string m_writtenData;
+};
+
+RpcValue createSignal(int n)
+{
+	RpcSignal sig;
+	sig.setMethod(Rpc::SIG_VAL_CHANGED);
+	sig.setShvPath("test/node/" + std::to_string(n % 100) + "/status");
+	sig.setParams(n);
+	return sig.value();
+}
+
+std::string createBurst(int msg_count)
+{
+	LoopbackRpcDriver wr;
+	for (int i = 0; i < msg_count; ++i)
+		wr.sendRpcValue(createSignal(i));
+	return wr.takeWrittenData();
+}
+
+}
+
+class TestRpcDriver: public QObject
+{
+	Q_OBJECT
+private slots:
+	void frameSplittingTest()
+	{
+		static constexpr int MSG_CNT = 100;
+		const std::string burst = createBurst(MSG_CNT);
+		for(size_t chunk_len : {(size_t)1, (size_t)3, (size_t)7, (size_t)64, burst.size()}) {
+			LoopbackRpcDriver rd;
+			for (size_t i = 0; i < burst.size(); i += chunk_len)
+				rd.receiveData(burst.substr(i, chunk_len));
+			QCOMPARE(rd.exceptionCount, 0);
+			QCOMPARE(rd.receivedMessages.size(), (size_t)MSG_CNT);
+			for (int i = 0; i < MSG_CNT; ++i) {
+				RpcSignal sig(rd.receivedMessages[i]);
+				RpcSignal expected(createSignal(i));
+				QCOMPARE(sig.shvPath(), expected.shvPath());
+				QCOMPARE(sig.method(), expected.method());
+				QCOMPARE(sig.params(), expected.params());
+			}
+		}
+	}
+
+	void sharedDataTest()
+	{
+		RpcSignal sig(createSignal(42));
+		RpcValue::MetaData meta_data = sig.metaData();
+		RpcMessage::setProtocolType(meta_data, Rpc::ProtocolType::ChainPack);
+		auto shared_data = std::make_shared<const std::string>(sig.value().metaStripped().toChainPack());
+		for(auto protocol_type : {Rpc::ProtocolType::ChainPack, Rpc::ProtocolType::Cpon}) {
+			LoopbackRpcDriver wr;
+			wr.setProtocolType(protocol_type);
+			wr.sendRawData(meta_data, shared_data);
+			RpcValue::MetaData meta_data2(meta_data);
+			RpcMessage::setShvPath(meta_data2, "other/path");
+			wr.sendRawData(meta_data2, shared_data);
+			LoopbackRpcDriver rd;
+			rd.receiveData(wr.takeWrittenData());
+			QCOMPARE(rd.exceptionCount, 0);
+			QCOMPARE(rd.receivedMessages.size(), (size_t)2);
+			RpcSignal sig1(rd.receivedMessages[0]);
+			RpcSignal sig2(rd.receivedMessages[1]);
+			QCOMPARE(sig1.shvPath(), sig.shvPath());
+			QCOMPARE(sig2.shvPath(), RpcValue("other/path"));
+			QCOMPARE(sig1.params(), sig.params());
+			QCOMPARE(sig2.params(), sig.params());
+		}
+		QCOMPARE(shared_data.use_count(), 1L);
+	}
+
+	void writeBatchingTest()
+	{
+		static constexpr int MSG_CNT = 100;
+		LoopbackRpcDriver wr;
+		wr.writeBlocked = true;
+		for (int i = 0; i < MSG_CNT; ++i)
+			wr.sendRpcValue(createSignal(i));
+		QCOMPARE(wr.sendQueueLength(), (size_t)MSG_CNT);
+		QCOMPARE(wr.flushCount, 0);
+		wr.writeBlocked = false;
+		wr.writeQueuedData();
+		// all queued messages shall be written and flushed at once
+		QCOMPARE(wr.sendQueueLength(), (size_t)0);
+		QCOMPARE(wr.flushCount, 1);
+		QCOMPARE(wr.writeStats().writeCount, (uint64_t)1);
+		QCOMPARE(wr.writeStats().messagesWritten, (uint64_t)MSG_CNT);
+		const std::string data = wr.takeWrittenData();
+		QCOMPARE(wr.writeStats().bytesWritten, (uint64_t)data.size());
+		QCOMPARE(data, createBurst(MSG_CNT));
+	}
+
+	void writeBatchLimitTest()
+	{
+		static constexpr int MSG_CNT = 100;
+		static constexpr size_t BATCH_SIZE = 100;
+		const size_t orig_batch_size = RpcDriver::writeBatchMaxBytes();
+		RpcDriver::setWriteBatchMaxBytes(BATCH_SIZE);
+		LoopbackRpcDriver wr;
+		wr.writeBlocked = true;
+		for (int i = 0; i < MSG_CNT; ++i)
+			wr.sendRpcValue(createSignal(i));
+		wr.writeBlocked = false;
+		const size_t max_msg_size = createBurst(1).size() + 10;
+		std::string data;
+		int write_cnt = 0;
+		while(wr.sendQueueLength() > 0) {
+			wr.writeQueuedData();
+			const std::string batch = wr.takeWrittenData();
+			// batch stops at first message boundary after batch size is reached
+			QVERIFY(batch.size() >= BATCH_SIZE || wr.sendQueueLength() == 0);
+			QVERIFY(batch.size() < BATCH_SIZE + max_msg_size);
+			data += batch;
+			write_cnt++;
+		}
+		RpcDriver::setWriteBatchMaxBytes(orig_batch_size);
+		QCOMPARE(data, createBurst(MSG_CNT));
+		QVERIFY(write_cnt > 1);
+		QCOMPARE(wr.flushCount, write_cnt);
+		QCOMPARE(wr.writeStats().messagesWritten, (uint64_t)MSG_CNT);
+	}
+
+	/// socket accepting single byte per write, frame header is split too
+	void shortWriteTest()
+	{
+		static constexpr int MSG_CNT = 10;
+		LoopbackRpcDriver wr;
+		wr.writeLimit = 1;
+		for (int i = 0; i < MSG_CNT; ++i)
+			wr.sendRpcValue(createSignal(i));
+		while(wr.sendQueueLength() > 0)
+			wr.writeQueuedData();
+		QCOMPARE(wr.takeWrittenData(), createBurst(MSG_CNT));
+		QCOMPARE(wr.writeStats().messagesWritten, (uint64_t)MSG_CNT);
+	}
+
+	void sendQueueOverflowTest()
+	{
+		static constexpr int MSG_CNT = 1000;
+		// createSignal() uses 100 distinct paths, they fit to the low watermark
+		static constexpr size_t HIGH_WATERMARK = 300;
+		for(auto policy : {RpcDriver::SendQueueOverflowPolicy::DropOldestSignals, RpcDriver::SendQueueOverflowPolicy::CoalesceSignals}) {
+			LoopbackRpcDriver wr;
+			RpcDriver::SendQueueLimits limits;
+			limits.highWatermarkMessages = HIGH_WATERMARK;
+			limits.overflowPolicy = policy;
+			wr.setSendQueueLimits(limits);
+			wr.writeBlocked = true;
+			RpcRequest rq;
+			rq.setRequestId(1);
+			rq.setMethod("foo");
+			wr.sendRpcValue(rq.value());
+			for (int i = 0; i < MSG_CNT; ++i)
+				wr.sendRpcValue(createSignal(i));
+			QVERIFY(wr.sendQueueLength() <= HIGH_WATERMARK);
+			QCOMPARE(wr.writeStats().droppedMessages + wr.writeStats().coalescedMessages + wr.sendQueueLength(), (uint64_t)MSG_CNT + 1);
+			wr.writeBlocked = false;
+			wr.writeQueuedData();
+			QCOMPARE(wr.sendQueueBytes(), (size_t)0);
+			LoopbackRpcDriver rd;
+			rd.receiveData(wr.takeWrittenData());
+			// request is never dropped and the latest signals are kept
+			QVERIFY(rd.receivedMessages.size() > 1);
+			QVERIFY(RpcMessage(rd.receivedMessages.front()).isRequest());
+			QCOMPARE(RpcSignal(rd.receivedMessages.back()).params(), RpcValue(MSG_CNT - 1));
+			if(policy == RpcDriver::SendQueueOverflowPolicy::CoalesceSignals) {
+				// only older values are coalesced, latest value of every path is delivered
+				QCOMPARE(wr.writeStats().droppedMessages, (uint64_t)0);
+				std::map<std::string, int> last_values;
+				for(size_t i = 1; i < rd.receivedMessages.size(); i++) {
+					RpcSignal sig(rd.receivedMessages[i]);
+					last_values[sig.shvPath().asString()] = sig.params().toInt();
+				}
+				QCOMPARE(last_values.size(), (size_t)100);
+				for(const auto &kv : last_values)
+					QVERIFY(kv.second >= MSG_CNT - 100);
+			}
+		}
+	}
+
+	/// send queue overflow must not discard partially received frame
+	void disconnectPolicyTest()
+	{
+		LoopbackRpcDriver wr;
+		RpcDriver::SendQueueLimits limits;
+		limits.highWatermarkMessages = 10;
+		limits.overflowPolicy = RpcDriver::SendQueueOverflowPolicy::Disconnect;
+		wr.setSendQueueLimits(limits);
+		wr.writeBlocked = true;
+		const std::string data = createBurst(1);
+		wr.receiveData(data.substr(0, data.size() / 2));
+		for (int i = 0; i < 20; ++i)
+			wr.sendRpcValue(createSignal(i));
+		QCOMPARE(wr.overflowCount, 1);
+		QVERIFY(wr.sendQueueLength() < 10);
+		wr.receiveData(data.substr(data.size() / 2));
+		QCOMPARE(wr.receivedMessages.size(), (size_t)1);
+		QCOMPARE(RpcSignal(wr.receivedMessages[0]).params(), RpcValue(0));
+	}
+
+	void lazyDecodeTest()
+	{
+		const size_t orig_min_size = RpcDriver::lazyDecodeMinDataSize();
+		RpcDriver::setLazyDecodeMinDataSize(1);
+		RpcResponse resp;
+		resp.setRequestId(1);
+		resp.setResult(RpcValue::List{1, "foo", RpcValue::Map{{"bar", 2}}});
+		LoopbackRpcDriver wr;
+		wr.sendRpcValue(resp.value());
+		LoopbackRpcDriver rd;
+		rd.receiveData(wr.takeWrittenData());
+		RpcDriver::setLazyDecodeMinDataSize(orig_min_size);
+		QCOMPARE(rd.receivedMessages.size(), (size_t)1);
+		RpcResponse resp2(rd.receivedMessages[0]);
+		QVERIFY(resp2.value().isRawChainPack());
+		QCOMPARE(resp2.requestId(), resp.requestId());
+		QVERIFY(resp2.result().isRawChainPack());
+		QCOMPARE(resp2.result(), resp.result());
+		// forwarded result is copied as it is
+		QCOMPARE(resp2.result().toChainPack(), resp.result().toChainPack());
+		// raw value decoded as whole uses arena
+		const size_t orig_arena_min_size = RpcDriver::decodeArenaMinDataSize();
+		RpcDriver::setDecodeArenaMinDataSize(1);
+		const RpcValue result = resp2.result();
+		const RpcValue::List &lst = result.asList();
+		RpcDriver::setDecodeArenaMinDataSize(orig_arena_min_size);
+		QCOMPARE(lst, resp.result().asList());
+	}
+
+	void burstBenchmark_data()
+	{
+		QTest::addColumn<int>("msgCount");
+		QTest::newRow("10") << 10;
+		QTest::newRow("100") << 100;
+		QTest::newRow("1000") << 1000;
+		QTest::newRow("10000") << 10000;
+	}
+	/// per message cost of processing of all the queued frames
+	/// shall not depend on the number of frames received at once
+	void burstBenchmark()
+	{
+		static constexpr int MIN_MSG_CNT = 100000;
+		QFETCH(int, msgCount);
+		const std::string burst = createBurst(msgCount);
+		const int repeat_cnt = std::max(1, MIN_MSG_CNT / msgCount);
+		LoopbackRpcDriver rd;
+		rd.keepReceivedMessages = false;
+		QElapsedTimer tm;
+		tm.start();
+		for (int i = 0; i < repeat_cnt; ++i)
+			rd.receiveData(burst);
+		qint64 elapsed = tm.nsecsElapsed();
+		QCOMPARE(rd.receivedMessageCount, (size_t)msgCount * repeat_cnt);
+		QTest::setBenchmarkResult(static_cast<qreal>(elapsed) / (msgCount * repeat_cnt), QTest::WalltimeNanoseconds);
+	}
+
+	void loggingBenchmark_data()
+	{
+		QTest::addColumn<QString>("logTresholds");
+		QTest::newRow("default") << QString();
+		QTest::newRow("verbose") << QStringLiteral("RpcRawMsg:M,RpcData:M");
+	}
+	/// send and receive cost with RPC message log topics disabled and enabled,
+	/// log output is thrown away to measure message formatting only
+	void loggingBenchmark()
+	{
+		static constexpr int MSG_CNT = 10000;
+		QFETCH(QString, logTresholds);
+		const std::string orig_tresholds = NecroLog::topicsLogTresholds();
+		NecroLog::MessageHandler orig_handler = NecroLog::setMessageHandler([](NecroLog::Level, const NecroLog::LogContext &, const std::string &) {});
+		NecroLog::setTopicsLogTresholds(logTresholds.toStdString());
+		LoopbackRpcDriver wr;
+		LoopbackRpcDriver rd;
+		rd.keepReceivedMessages = false;
+		std::vector<RpcValue> messages;
+		for (int i = 0; i < MSG_CNT; ++i)
+			messages.push_back(createSignal(i));
+		QElapsedTimer tm;
+		tm.start();
+		for (const RpcValue &msg : messages) {
+			wr.sendRpcValue(msg);
+			rd.receiveData(wr.takeWrittenData());
+		}
+		qint64 elapsed = tm.nsecsElapsed();
+		NecroLog::setTopicsLogTresholds(orig_tresholds);
+		NecroLog::setMessageHandler(orig_handler);
+		QCOMPARE(rd.receivedMessageCount, (size_t)MSG_CNT);
+		qInfo() << "messages per second:" << static_cast<qint64>(MSG_CNT * 1e9 / std::max(elapsed, (qint64)1));
+		QTest::setBenchmarkResult(static_cast<qreal>(elapsed) / MSG_CNT, QTest::WalltimeNanoseconds);
+	}
+};
+
+QTEST_MAIN(TestRpcDriver)
+#include "tst_chainpack_rpcdriver.moc"
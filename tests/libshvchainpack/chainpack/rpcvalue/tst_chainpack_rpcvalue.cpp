@@ -1,8 +1,10 @@
 #include <shv/chainpack/rpcvalue.h>
 #include <shv/chainpack/chainpack.h>
 #include <shv/chainpack/chainpackwriter.h>
+#include <shv/chainpack/cponwriter.h>
 #include <shv/chainpack/chainpackreader.h>
 #include <shv/chainpack/cponreader.h>
+#include <shv/chainpack/rpcvaluearena.h>
 
 #include <QtTest/QtTest>
 #include <QDebug>
@@ -724,6 +726,8 @@ private:
 			//QVERIFY(RpcValue::DateTime() < RpcValue::DateTime::fromMSecsSinceEpoch(0));
 			QVERIFY(RpcValue::DateTime::fromMSecsSinceEpoch(1) < RpcValue::DateTime::fromMSecsSinceEpoch(2));
 			QVERIFY(RpcValue::DateTime::fromMSecsSinceEpoch(0) == RpcValue::DateTime::fromUtcString("1970-01-01T00:00:00"));
+			QCOMPARE(RpcValue::DateTime::fromMSecsSinceEpoch(1).toIsoString(), std::string("1970-01-01T00:00:00.001Z"));
+			QCOMPARE(RpcValue::DateTime::fromMSecsSinceEpoch(1010).toIsoString(), std::string("1970-01-01T00:00:01.010Z"));
 			//RpcValue::DateTime ts;// = RpcValue::DateTime::now();
 			//qDebug() << "~~~~~~~~~~~~~~~~~~~~~~~~~ " << RpcValue(ts).toCpon();
 			for(std::string str : {
@@ -1072,7 +1076,197 @@ private slots:
 		QVERIFY(rv3.metaData().isEmpty() == true);
 		QVERIFY(rv3.at("18") == rpcval.at("18"));
 	}
-
+	void contiguousBufferReadTest()
+	{
+		qDebug() << "================================= Contiguous Buffer Read Test =====================================";
+		auto rpcval = RpcValue::fromCpon(R"(<1:2,8:"foo">{"a":[1,2,3],"b":"baz","c":d"2018-02-02T00:00:00.001Z"})");
+		for(bool is_cpon : {false, true}) {
+			std::string packed = is_cpon? rpcval.toCpon(): rpcval.toChainPack();
+			// surround packed data with garbage to check that reader does not cross span boundaries
+			std::string buff = "xyz" + packed + "!@#";
+			std::string err;
+			RpcValue rv = is_cpon
+					? RpcValue::fromCpon(buff.data() + 3, packed.size(), &err)
+					: RpcValue::fromChainPack(buff.data() + 3, packed.size(), &err);
+			QVERIFY(err.empty());
+			QVERIFY(rv.toCpon() == rpcval.toCpon());
+			// truncated data must end with an error, not with a read past the span
+			rv = is_cpon
+					? RpcValue::fromCpon(buff.data() + 3, packed.size() - 2, &err)
+					: RpcValue::fromChainPack(buff.data() + 3, packed.size() - 2, &err);
+			QVERIFY(!err.empty());
+		}
+	}
+	void readAheadStreamReadTest()
+	{
+		qDebug() << "================================= Read Ahead Stream Read Test =====================================";
+		auto rpcval = RpcValue::fromCpon(R"(<1:2,8:"foo">{"a":[1,2,3],"b":"some string longer than read ahead chunk","c":d"2018-02-02T00:00:00.001Z"})");
+		std::string packed = rpcval.toChainPack();
+		// values and strings cross chunk boundaries
+		for(size_t read_ahead_size : {1, 7, 1024}) {
+			std::istringstream in(packed + packed);
+			ChainPackReader rd(in, read_ahead_size);
+			QVERIFY(rd.read().toCpon() == rpcval.toCpon());
+			QVERIFY(rd.readPos() == static_cast<long>(packed.size()));
+			QVERIFY(rd.read().toCpon() == rpcval.toCpon());
+			std::string err;
+			rd.read(&err);
+			QVERIFY(!err.empty());
+		}
+	}
+	void stringSinkWriteTest()
+	{
+		qDebug() << "================================= String Sink Write Test =====================================";
+		RpcValue::List lst;
+		for (int i = 0; i < 100; ++i)
+			lst.push_back(std::string(static_cast<size_t>(i * 10), 'x'));
+		RpcValue rpcval(lst);
+		rpcval.setMetaValue(8, 42);
+		std::ostringstream os;
+		{
+			ChainPackWriter wr(os);
+			wr << rpcval;
+		}
+		std::string out = "HDR";
+		{
+			ChainPackWriter wr(out);
+			wr << rpcval;
+			wr.flush();
+			QVERIFY(out.substr(3) == os.str());
+			wr << RpcValue(1);
+		}
+		QVERIFY(out.substr(3) == os.str() + RpcValue(1).toChainPack());
+		std::string cpon;
+		{
+			CponWriter wr(cpon);
+			wr << rpcval;
+		}
+		QVERIFY(cpon == rpcval.toCpon());
+	}
+	void metaDataKeysTest()
+	{
+		qDebug() << "================================= MetaData Keys Test =====================================";
+		// mix of int keys including negative and string keys, int keys are not set in order
+		RpcValue::MetaData md;
+		md.setValue(100, 1);
+		md.setValue(8, "foo");
+		md.setValue(-1, 2);
+		md.setValue(0, 3);
+		md.setValue(17, 4);
+		md.setValue("bar", 5);
+		QVERIFY(md.size() == 6);
+		QVERIFY((md.iKeys() == std::vector<RpcValue::Int>{-1, 0, 8, 17, 100}));
+		QVERIFY(md.iValuesMap().size() == 5);
+		QVERIFY(md.hasKey(8) && md.value(8) == RpcValue("foo"));
+		QVERIFY(!md.hasKey(9) && md.value(9, 42) == RpcValue(42));
+		RpcValue::MetaData md2(md);
+		QVERIFY(md2 == md);
+		md2.setValue(8, RpcValue());
+		QVERIFY(!md2.hasKey(8));
+		QVERIFY(md2.size() == 5);
+		QVERIFY(md2.iValuesMap().size() == 4);
+		QVERIFY(!(md2 == md));
+		RpcValue rv = RpcValue::List{1, 2};
+		rv.setMetaData(std::move(md));
+		QVERIFY(rv.toCpon() == R"(<-1:2,0:3,8:"foo",17:4,100:1,"bar":5>[1,2])");
+		QVERIFY(RpcValue::fromChainPack(rv.toChainPack()) == rv);
+	}
+	void arenaReadTest()
+	{
+		qDebug() << "================================= Arena Read Test =====================================";
+		auto rpcval = RpcValue::fromCpon(R"(<1:2,8:"foo">{"a":[1,2,"some quite long string value"],"b":b"blob","c":i{1:"x"}})");
+		const std::string packed = rpcval.toChainPack();
+		auto arena = std::make_shared<RpcValueArena>(16);
+		RpcValue rv;
+		{
+			ChainPackReader rd(packed.data(), packed.size());
+			rd.setArena(arena);
+			rd.read(rv);
+		}
+		QVERIFY(rv == rpcval);
+		QVERIFY(arena->blockCount() > 1);
+		// values allocated from arena keep it alive
+		RpcValue str = rv.at("a").at(2);
+		rv = RpcValue();
+		QVERIFY(arena.use_count() == 2);
+		QVERIFY(str.asString() == "some quite long string value");
+		// modified value is detached to heap
+		RpcValue lst = rpcval.at("a");
+		{
+			ChainPackReader rd(packed.data(), packed.size());
+			rd.setArena(arena);
+			rd.read(rv);
+		}
+		RpcValue lst2 = rv.at("a");
+		lst2.append(3);
+		QVERIFY(rv.at("a") == lst);
+		QVERIFY(lst2.count() == 4);
+		rv = RpcValue();
+		str = RpcValue();
+		QVERIFY(arena.use_count() == 2);
+		lst2 = RpcValue();
+		QVERIFY(arena.use_count() == 1);
+		// clone does not pin arena
+		{
+			ChainPackReader rd(packed.data(), packed.size());
+			rd.setArena(arena);
+			rd.read(rv);
+		}
+		RpcValue cloned = rv.clone();
+		RpcValue cloned_str = rv.at("a").at(2).clone();
+		rv = RpcValue();
+		QVERIFY(arena.use_count() == 1);
+		QVERIFY(cloned == rpcval);
+		QVERIFY(cloned_str.asString() == "some quite long string value");
+	}
+	void rawChainPackTest()
+	{
+		qDebug() << "================================= Raw ChainPack Test =====================================";
+		auto rpcval = RpcValue::fromCpon(R"(<1:2,8:"foo">i{1:[1,"bar",<3:4>{"a":b"blob","b":2}],2:"baz",3:<5:6>7})");
+		auto data = std::make_shared<const std::string>(rpcval.toChainPack());
+		std::string err;
+		RpcValue raw = RpcValue::fromRawChainPack(data, &err);
+		QVERIFY(err.empty());
+		QVERIFY(raw.isRawChainPack());
+		QVERIFY(raw.isIMap());
+		QVERIFY(raw.metaData() == rpcval.metaData());
+		// items are accessed without decoding of the whole value
+		RpcValue lst = raw.at(1);
+		QVERIFY(lst.isRawChainPack());
+		QVERIFY(lst.isList());
+		QVERIFY(lst.at(1) == RpcValue("bar"));
+		RpcValue map = lst.at(2);
+		QVERIFY(map.isRawChainPack());
+		QVERIFY(map.metaValue(3) == RpcValue(4));
+		QVERIFY(map.at("a").asBlob() == rpcval.at(1).at(2).at("a").asBlob());
+		QVERIFY(map.at("c").isValid() == false);
+		QVERIFY(raw.at(3) == RpcValue(7));
+		QVERIFY(raw.at(3).metaValue(5) == RpcValue(6));
+		QVERIFY(!raw.at(3).isRawChainPack());
+		QVERIFY(raw.has(2) && !raw.has(4));
+		// packed data are written unchanged
+		QVERIFY(raw.toChainPack() == *data);
+		QVERIFY(lst.toChainPack() == rpcval.at(1).toChainPack());
+		QVERIFY(raw == rpcval);
+		QVERIFY(raw.toCpon() == rpcval.toCpon());
+		QVERIFY(raw.count() == 3);
+		// modification replaces raw value by decoded one
+		RpcValue raw2 = raw;
+		raw2.set(2, "qux");
+		QVERIFY(!raw2.isRawChainPack());
+		QVERIFY(raw2.metaData() == rpcval.metaData());
+		QVERIFY(raw2.at(2) == RpcValue("qux"));
+		QVERIFY(raw.at(2) == RpcValue("baz"));
+		raw2.setMetaValue(8, "bar");
+		raw.setMetaValue(8, "bar");
+		QVERIFY(raw.isRawChainPack());
+		QVERIFY(RpcValue::fromChainPack(raw.toChainPack()).metaValue(8) == RpcValue("bar"));
+		// scalars are decoded immediately, invalid data are refused
+		QVERIFY(!RpcValue::fromRawChainPack(std::make_shared<const std::string>(RpcValue(42).toChainPack())).isRawChainPack());
+		RpcValue invalid = RpcValue::fromRawChainPack(std::make_shared<const std::string>(data->substr(0, data->size() - 2)), &err);
+		QVERIFY(!err.empty());
+		QVERIFY(!invalid.isValid());
+	}
 
 	void cleanupTestCase()
 	{
@@ -0,0 +1,284 @@
+#include <shv/chainpack/rpcvalue.h>
+#include <shv/chainpack/rpcmessage.h>
+#include <shv/chainpack/rpcvaluearena.h>
+#include <shv/chainpack/chainpackreader.h>
+#include <shv/chainpack/flatmap.h>
+
+#include <QtTest/QtTest>
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace shv::chainpack;
+
+namespace {
+
+constexpr int RECORD_CNT = 10000;
+constexpr int VALUES_PER_RECORD = 7;
+constexpr int MIN_VALUE_CNT = 1000000;
+
+/// journal like record, all the fields are scalars
+RpcValue createRecord(int n)
+{
+	RpcValue::List rec;
+	rec.push_back(RpcValue::DateTime::fromMSecsSinceEpoch(1600000000000LL + n * 1000LL, 60));
+	rec.push_back(n);
+	rec.push_back(static_cast<RpcValue::UInt>(n * 3));
+	rec.push_back(n * 0.5);
+	rec.push_back(RpcValue::Decimal(n, -2));
+	rec.push_back(n % 2 == 0);
+	rec.push_back(nullptr);
+	return rec;
+}
+
+RpcValue createPayload()
+{
+	RpcValue::List ret;
+	ret.reserve(RECORD_CNT);
+	for (int i = 0; i < RECORD_CNT; ++i)
+		ret.push_back(createRecord(i));
+	return ret;
+}
+
+/// typical broker traffic, small request with meta data
+RpcValue createRequest()
+{
+	RpcRequest rq;
+	rq.setRequestId(1234);
+	rq.setMethod("set");
+	rq.setShvPath("shv/eu/pl/plant/zone1/heater/setpoint");
+	rq.setCallerIds(RpcValue::List{12, 5});
+	rq.setParams(RpcValue::Map{{"value", 21.5}, {"unit", "degC"}});
+	return rq.value();
+}
+
+/// getLog reply, journal records with path and domain strings
+RpcValue createGetLogResponse()
+{
+	RpcValue::List log;
+	log.reserve(RECORD_CNT);
+	for (int i = 0; i < RECORD_CNT; ++i) {
+		log.push_back(RpcValue::List{
+						  RpcValue::DateTime::fromMSecsSinceEpoch(1600000000000LL + i * 1000LL),
+						  "zone" + std::to_string(i % 10) + "/heater/temperature",
+						  i * 0.5,
+						  nullptr,
+						  "chng",
+						  0,
+						  nullptr,
+					  });
+	}
+	RpcResponse resp;
+	resp.setRequestId(1234);
+	resp.setCallerIds(RpcValue::List{12, 5});
+	resp.setResult(log);
+	return resp.value();
+}
+
+/// repeat fn until at least MIN_VALUE_CNT scalars are processed, result is time per scalar value
+template<typename Fn>
+void runBenchmark(Fn fn)
+{
+	const int repeat_cnt = std::max(1, MIN_VALUE_CNT / (RECORD_CNT * VALUES_PER_RECORD));
+	QElapsedTimer tm;
+	tm.start();
+	for (int i = 0; i < repeat_cnt; ++i)
+		fn();
+	qint64 elapsed = tm.nsecsElapsed();
+	QTest::setBenchmarkResult(static_cast<qreal>(elapsed) / (repeat_cnt * RECORD_CNT * VALUES_PER_RECORD), QTest::WalltimeNanoseconds);
+}
+
+/// type info like map, node path -> type name
+template<typename M>
+M createTypeInfoMap()
+{
+	static const char *types[] = {"Double", "Int", "Bool", "String", "DateTime"};
+	M ret;
+	for (int i = 0; i < RECORD_CNT; ++i) {
+		std::string path = "system/zone" + std::to_string(i % 100) + "/heater" + std::to_string(i / 100) + "/temperature";
+		ret[path] = types[i % 5];
+	}
+	return ret;
+}
+
+/// lookup of all the keys or iteration over whole map, time per key
+template<typename M>
+void runMapBenchmark(bool iterate)
+{
+	static constexpr int REPEAT_CNT = 100;
+	const M map = createTypeInfoMap<M>();
+	std::vector<std::string> keys;
+	for(const auto &kv : map)
+		keys.push_back(kv.first);
+	// random order lookup
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(1));
+	size_t cnt = 0;
+	QElapsedTimer tm;
+	tm.start();
+	for (int i = 0; i < REPEAT_CNT; ++i) {
+		if(iterate) {
+			for(const auto &kv : map)
+				cnt += kv.second.isString();
+		}
+		else {
+			for(const std::string &key : keys)
+				cnt += map.count(key);
+		}
+	}
+	qint64 elapsed = tm.nsecsElapsed();
+	QCOMPARE(cnt, static_cast<size_t>(REPEAT_CNT) * keys.size());
+	QTest::setBenchmarkResult(static_cast<qreal>(elapsed) / (REPEAT_CNT * keys.size()), QTest::WalltimeNanoseconds);
+}
+
+}
+
+class TestRpcValueBenchmark: public QObject
+{
+	Q_OBJECT
+private slots:
+	void constructionBenchmark()
+	{
+		size_t cnt = 0;
+		runBenchmark([&cnt]() {
+			RpcValue payload = createPayload();
+			cnt += payload.count();
+		});
+		QVERIFY(cnt > 0);
+	}
+
+	void copyBenchmark()
+	{
+		const RpcValue payload = createPayload();
+		size_t cnt = 0;
+		runBenchmark([&payload, &cnt]() {
+			// deep copy, every scalar is copied
+			for(const RpcValue &rec : payload.asList()) {
+				RpcValue::List copy = rec.asList();
+				cnt += copy.size();
+			}
+		});
+		QCOMPARE(cnt % (RECORD_CNT * VALUES_PER_RECORD), (size_t)0);
+	}
+
+	void toChainPackBenchmark()
+	{
+		const RpcValue payload = createPayload();
+		size_t len = 0;
+		runBenchmark([&payload, &len]() {
+			len += payload.toChainPack().size();
+		});
+		QVERIFY(len > 0);
+	}
+
+	void fromChainPackBenchmark()
+	{
+		const RpcValue payload = createPayload();
+		const std::string data = payload.toChainPack();
+		RpcValue val;
+		runBenchmark([&data, &val]() {
+			val = RpcValue::fromChainPack(data);
+		});
+		QVERIFY(val == payload);
+	}
+
+	void decodeMessageBenchmark_data()
+	{
+		QTest::addColumn<bool>("isGetLog");
+		QTest::addColumn<bool>("useArena");
+		QTest::newRow("request") << false << false;
+		QTest::newRow("request arena") << false << true;
+		QTest::newRow("getLog") << true << false;
+		QTest::newRow("getLog arena") << true << true;
+	}
+	/// decode and drop whole message, time per message
+	void decodeMessageBenchmark()
+	{
+		static constexpr int MIN_VALUE_CNT = 1000000;
+		QFETCH(bool, isGetLog);
+		QFETCH(bool, useArena);
+		const RpcValue msg = isGetLog? createGetLogResponse(): createRequest();
+		const std::string data = msg.toChainPack();
+		const int repeat_cnt = isGetLog? std::max(1, MIN_VALUE_CNT / (RECORD_CNT * VALUES_PER_RECORD)): MIN_VALUE_CNT / 10;
+		bool ok = true;
+		QElapsedTimer tm;
+		tm.start();
+		for (int i = 0; i < repeat_cnt; ++i) {
+			ChainPackReader rd(data.data(), data.size());
+			if(useArena)
+				rd.setArena(std::make_shared<RpcValueArena>());
+			RpcValue val;
+			rd.read(val);
+			ok = ok && val.isValid();
+		}
+		qint64 elapsed = tm.nsecsElapsed();
+		QVERIFY(ok);
+		ChainPackReader rd(data.data(), data.size());
+		auto arena = std::make_shared<RpcValueArena>();
+		rd.setArena(arena);
+		RpcValue val;
+		rd.read(val);
+		QVERIFY(val == msg);
+		// less than one chunk is left unused
+		QVERIFY(arena->capacity() - arena->size() < std::max(arena->size(), RpcValueArena::MAX_BLOCK_SIZE));
+		QTest::setBenchmarkResult(static_cast<qreal>(elapsed) / repeat_cnt, QTest::WalltimeNanoseconds);
+	}
+
+	void forwardGetLogBenchmark_data()
+	{
+		QTest::addColumn<bool>("isRaw");
+		QTest::newRow("decode") << false;
+		QTest::newRow("raw") << true;
+	}
+	/// receive getLog response, take its result and send it in other response, time per message
+	void forwardGetLogBenchmark()
+	{
+		static constexpr int REPEAT_CNT = 20;
+		QFETCH(bool, isRaw);
+		const RpcValue msg = createGetLogResponse();
+		const std::string data = msg.metaStripped().toChainPack();
+		std::string out;
+		QElapsedTimer tm;
+		tm.start();
+		for (int i = 0; i < REPEAT_CNT; ++i) {
+			RpcValue val = isRaw
+					? RpcValue::fromRawChainPack(std::make_shared<const std::string>(data))
+					: RpcValue::fromChainPack(data);
+			RpcResponse resp;
+			resp.setRequestId(i);
+			resp.setResult(val.at(RpcMessage::MetaType::Key::Result));
+			out = resp.value().toChainPack();
+		}
+		qint64 elapsed = tm.nsecsElapsed();
+		RpcResponse resp(RpcValue::fromChainPack(out));
+		QVERIFY(resp.result() == RpcResponse(msg).result());
+		QTest::setBenchmarkResult(static_cast<qreal>(elapsed) / REPEAT_CNT, QTest::WalltimeNanoseconds);
+	}
+
+	void mapBenchmark_data()
+	{
+		QTest::addColumn<bool>("isFlat");
+		QTest::addColumn<bool>("iterate");
+		QTest::newRow("std::map lookup") << false << false;
+		QTest::newRow("FlatMap lookup") << true << false;
+		QTest::newRow("std::map iterate") << false << true;
+		QTest::newRow("FlatMap iterate") << true << true;
+	}
+	/// Map implementations compared on 10k keys type info, RpcValue::Map is one of them depending on SHV_RPCVALUE_FLAT_MAP
+	void mapBenchmark()
+	{
+		QFETCH(bool, isFlat);
+		QFETCH(bool, iterate);
+		if(isFlat)
+			runMapBenchmark<FlatMap<std::string, RpcValue>>(iterate);
+		else
+			runMapBenchmark<std::map<std::string, RpcValue>>(iterate);
+	}
+};
+
+QTEST_MAIN(TestRpcValueBenchmark)
+#include "tst_chainpack_rpcvaluebenchmark.moc"
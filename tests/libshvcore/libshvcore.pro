@@ -6,3 +6,5 @@ SUBDIRS += \
 	stringview \
 	shvlogfilereader \
 	shvmemoryjournal \
+	shvjournalbinfile \
+	patternmatcher \
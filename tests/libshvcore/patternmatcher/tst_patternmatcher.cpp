@@ -0,0 +1,180 @@
+#include <shv/core/utils/patternmatcher.h>
+#include <shv/core/utils/shvpath.h>
+#include <shv/core/stringview.h>
+
+#include <QtTest/QtTest>
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <regex>
+#include <string>
+#include <vector>
+
+using namespace shv::core;
+using namespace shv::core::utils;
+
+namespace {
+
+const std::vector<std::string> PATHS = {
+	"",
+	"a",
+	"a/b",
+	"a/b/c",
+	"a/b/c/d",
+	"/a/b/",
+	"a//b",
+	"a/x/b/c",
+	"a/b/b/c",
+	"x/a/b",
+	"*",
+	"a/*/c",
+	"zone1/heater2/temperature",
+	"zone1/heater2/status",
+	"vetra/vehicleDetected",
+};
+
+const std::vector<std::string> PATTERNS = {
+	"/",
+	"a",
+	"a/b",
+	"*",
+	"*/b",
+	"a/*",
+	"a/*/c",
+	"**",
+	"a/**",
+	"**/c",
+	"a/**/c",
+	"a/**/*",
+	"**/b/**",
+	"a/**/b/c",
+	"zone1/**/temperature",
+	"*/*/status",
+};
+
+/// wildcard matching of PatternMatcher before patterns were compiled
+bool match_wild(const std::string &path, const std::string &pattern)
+{
+	const StringViewList path_lst = StringView(path).split('/');
+	const StringViewList pattern_lst = StringView(pattern).split('/');
+	return ShvPath::matchWild(path_lst, pattern_lst);
+}
+
+ShvGetLogParams wildcard_params(const std::string &pattern)
+{
+	ShvGetLogParams params;
+	params.pathPattern = pattern;
+	return params;
+}
+}
+
+class TestPatternMatcher : public QObject
+{
+	Q_OBJECT
+private slots:
+	void wildCardTest()
+	{
+		for(const std::string &pattern : PATTERNS) {
+			PatternMatcher pm(wildcard_params(pattern));
+			for(const std::string &path : PATHS) {
+				QCOMPARE(pm.matchPathWildCard(path), match_wild(path, pattern));
+				QCOMPARE(pm.match(path, std::string()), match_wild(path, pattern));
+			}
+		}
+	}
+
+	void domainTest_data()
+	{
+		QTest::addColumn<QString>("pattern");
+		QTest::newRow("literal") << "chng";
+		QTest::newRow("alternatives") << "chng|fchng|";
+		QTest::newRow("regex") << "f?chng";
+		QTest::newRow("regexAlternatives") << "(chng|fchng)";
+	}
+	void domainTest()
+	{
+		QFETCH(QString, pattern);
+		ShvGetLogParams params;
+		params.domainPattern = pattern.toStdString();
+		PatternMatcher pm(params);
+		QVERIFY(!pm.isEmpty());
+		const std::regex rx(params.domainPattern);
+		for(const std::string &domain : {"", "chng", "fchng", "cmdlog", "chngx", "C"}) {
+			// twice, second result comes from cache for regex patterns
+			QCOMPARE(pm.match("a/b", domain), std::regex_match(domain, rx));
+			QCOMPARE(pm.match("a/b", domain), std::regex_match(domain, rx));
+		}
+	}
+
+	void regexPathTest()
+	{
+		ShvGetLogParams params;
+		params.pathPattern = "^zone[0-9]/.*temperature$";
+		params.pathPatternType = ShvGetLogParams::PatternType::RegEx;
+		PatternMatcher pm(params);
+		const std::regex rx(params.pathPattern);
+		for(int i = 0; i < 2; ++i) {
+			for(const std::string &path : PATHS)
+				QCOMPARE(pm.match(path, std::string()), std::regex_search(path, rx));
+		}
+	}
+
+	void matchBenchmark_data()
+	{
+		QTest::addColumn<QString>("pathPattern");
+		QTest::addColumn<bool>("isRegEx");
+		QTest::addColumn<QString>("domainPattern");
+		QTest::addColumn<bool>("isCompiled");
+		QTest::newRow("wildcard-split") << "*/**/temperature" << false << "" << false;
+		QTest::newRow("wildcard-compiled") << "*/**/temperature" << false << "" << true;
+		QTest::newRow("regex-uncached") << "^zone[0-9]/.*temperature$" << true << "" << false;
+		QTest::newRow("regex-cached") << "^zone[0-9]/.*temperature$" << true << "" << true;
+		QTest::newRow("domain-regex") << "" << false << "chng|fchng" << false;
+		QTest::newRow("domain-literals") << "" << false << "chng|fchng" << true;
+	}
+	/// time per match call, uncompiled rows match the way PatternMatcher did it before
+	void matchBenchmark()
+	{
+		static constexpr int MATCH_CNT = 200000;
+		QFETCH(QString, pathPattern);
+		QFETCH(bool, isRegEx);
+		QFETCH(QString, domainPattern);
+		QFETCH(bool, isCompiled);
+		std::vector<std::string> paths;
+		for (int i = 0; i < 100; ++i)
+			paths.push_back("zone" + std::to_string(i % 10) + "/heater" + std::to_string(i / 10) + (i % 3? "/temperature": "/status"));
+		ShvGetLogParams params;
+		params.pathPattern = pathPattern.toStdString();
+		params.pathPatternType = isRegEx? ShvGetLogParams::PatternType::RegEx: ShvGetLogParams::PatternType::WildCard;
+		params.domainPattern = domainPattern.toStdString();
+		PatternMatcher pm(params);
+		const std::regex path_rx(isRegEx? params.pathPattern: std::string());
+		const std::regex domain_rx(params.domainPattern);
+		int cnt = 0;
+		QElapsedTimer tm;
+		tm.start();
+		for (int i = 0; i < MATCH_CNT; ++i) {
+			const std::string &path = paths[static_cast<size_t>(i) % paths.size()];
+			const std::string domain = (i % 4)? "chng": "fchng";
+			if(isCompiled) {
+				cnt += pm.match(path, domain);
+			}
+			else if(isRegEx) {
+				std::smatch m;
+				cnt += std::regex_search(path, m, path_rx);
+			}
+			else if(!params.pathPattern.empty()) {
+				cnt += match_wild(path, params.pathPattern);
+			}
+			else {
+				cnt += std::regex_match(domain, domain_rx);
+			}
+		}
+		qint64 elapsed = tm.nsecsElapsed();
+		QVERIFY(cnt > 0);
+		QTest::setBenchmarkResult(static_cast<qreal>(elapsed) / MATCH_CNT, QTest::WalltimeNanoseconds);
+	}
+};
+
+QTEST_MAIN(TestPatternMatcher)
+#include "tst_patternmatcher.moc"
@@ -0,0 +1,205 @@
+#include <shv/core/utils/shvjournalentry.h>
+#include <shv/core/utils/shvjournalfilereader.h>
+#include <shv/core/utils/shvjournalfilewriter.h>
+#include <shv/core/utils/shvjournalbinfilereader.h>
+#include <shv/core/utils/shvjournalbinfilewriter.h>
+#include <shv/chainpack/chainpack.h>
+
+#include <QtTest/QtTest>
+#include <QDebug>
+#include <QElapsedTimer>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace shv::core::utils;
+using namespace shv::chainpack;
+
+namespace {
+
+const std::string LOG2_FILE = "/tmp/tst_shvjournalbinfile.log2";
+const std::string LOG3_FILE = "/tmp/tst_shvjournalbinfile.log3";
+
+/// entries as they are read back from .log2 file
+std::vector<ShvJournalEntry> createEntries(int cnt)
+{
+	std::vector<ShvJournalEntry> ret;
+	int64_t msec = 1600000000000LL;
+	for (int i = 0; i < cnt; ++i) {
+		ShvJournalEntry e;
+		msec += i % 7;
+		e.epochMsec = msec;
+		e.path = "zone" + std::to_string(i % 10) + "/heater" + std::to_string(i % 3) + "/temperature";
+		switch (i % 5) {
+		case 0: e.value = RpcValue::Decimal(i, -2); break;
+		case 1: e.value = i; break;
+		case 2: e.value = i % 2 == 0; break;
+		case 3: e.value = RpcValue::List{i, "R"}; break;
+		default: e.value = RpcValue(nullptr); break;
+		}
+		e.domain = (i % 4 == 0)? ShvJournalEntry::DOMAIN_VAL_FASTCHANGE: ShvJournalEntry::DOMAIN_VAL_CHANGE;
+		e.shortTime = (i % 4 == 0)? i % 0x100: ShvJournalEntry::NO_SHORT_TIME;
+		e.sampleType = (i % 6 == 0)? ShvJournalEntry::SampleType::Discrete: ShvJournalEntry::SampleType::Continuous;
+		if(i % 100 == 0)
+			e.userId = "operator";
+		ret.push_back(std::move(e));
+	}
+	return ret;
+}
+
+template<typename Writer>
+void writeFile(const std::string &file_name, const std::vector<ShvJournalEntry> &entries)
+{
+	std::remove(file_name.c_str());
+	Writer wr(file_name);
+	for(const auto &e : entries)
+		wr.append(e);
+}
+
+template<typename Reader>
+int64_t readFile(const std::string &file_name)
+{
+	Reader rd(file_name);
+	int64_t cnt = 0;
+	while(rd.next())
+		cnt += rd.entry().isValid();
+	return cnt;
+}
+
+}
+
+class TestShvJournalBinFile : public QObject
+{
+	Q_OBJECT
+private slots:
+	void writeReadTest()
+	{
+		// more than one block, last one partial
+		const std::vector<ShvJournalEntry> entries = createEntries(ShvJournalBinFileWriter::DEFAULT_BLOCK_RECORD_COUNT * 2 + 100);
+		writeFile<ShvJournalBinFileWriter>(LOG3_FILE, entries);
+		ShvJournalBinFileReader rd(LOG3_FILE);
+		size_t cnt = 0;
+		while(rd.next()) {
+			QVERIFY(cnt < entries.size());
+			QVERIFY(rd.entry() == entries[cnt]);
+			cnt++;
+		}
+		QCOMPARE(cnt, entries.size());
+		QVERIFY(rd.last());
+		QVERIFY(rd.entry() == entries.back());
+		QVERIFY(!rd.next());
+	}
+
+	void appendTest()
+	{
+		const std::vector<ShvJournalEntry> entries = createEntries(50);
+		writeFile<ShvJournalBinFileWriter>(LOG3_FILE, std::vector<ShvJournalEntry>(entries.begin(), entries.begin() + 20));
+		{
+			// records are appended to existing file in new block
+			ShvJournalBinFileWriter wr(LOG3_FILE);
+			for(size_t i = 20; i < entries.size(); ++i)
+				wr.append(entries[i]);
+		}
+		ShvJournalBinFileReader rd(LOG3_FILE);
+		size_t cnt = 0;
+		while(rd.next())
+			QVERIFY(rd.entry() == entries[cnt++]);
+		QCOMPARE(cnt, entries.size());
+	}
+
+	void truncatedFileTest()
+	{
+		const std::vector<ShvJournalEntry> entries = createEntries(ShvJournalBinFileWriter::DEFAULT_BLOCK_RECORD_COUNT + 10);
+		writeFile<ShvJournalBinFileWriter>(LOG3_FILE, entries);
+		std::string data;
+		{
+			std::ifstream in(LOG3_FILE, std::ios::binary);
+			data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		}
+		{
+			std::ofstream out(LOG3_FILE, std::ios::binary | std::ios::trunc);
+			out.write(data.data(), static_cast<std::streamsize>(data.size() - 5));
+		}
+		// complete blocks are readable
+		ShvJournalBinFileReader rd(LOG3_FILE);
+		QCOMPARE(readFile<ShvJournalBinFileReader>(LOG3_FILE), static_cast<int64_t>(ShvJournalBinFileWriter::DEFAULT_BLOCK_RECORD_COUNT));
+		QVERIFY(rd.last());
+		QVERIFY(rd.entry() == entries[ShvJournalBinFileWriter::DEFAULT_BLOCK_RECORD_COUNT - 1]);
+	}
+
+	void corruptedChunkLengthTest()
+	{
+		const std::vector<ShvJournalEntry> entries = createEntries(ShvJournalBinFileWriter::DEFAULT_BLOCK_RECORD_COUNT);
+		writeFile<ShvJournalBinFileWriter>(LOG3_FILE, entries);
+		{
+			// chunk length far beyond file size
+			char buff[16];
+			ccpcp_pack_context ctx;
+			ccpcp_pack_context_init(&ctx, buff, sizeof(buff), nullptr);
+			cchainpack_pack_uint_data(&ctx, 1ULL << 60);
+			std::ofstream out(LOG3_FILE, std::ios::binary | std::ios::app);
+			out.write(buff, ctx.current - ctx.start);
+			out.write("garbage", 7);
+		}
+		QCOMPARE(readFile<ShvJournalBinFileReader>(LOG3_FILE), static_cast<int64_t>(entries.size()));
+		ShvJournalBinFileReader rd(LOG3_FILE);
+		QVERIFY(rd.last());
+		QVERIFY(rd.entry() == entries.back());
+	}
+
+	void convertLog2Test()
+	{
+		const std::vector<ShvJournalEntry> entries = createEntries(5000);
+		writeFile<ShvJournalFileWriter>(LOG2_FILE, entries);
+		std::remove(LOG3_FILE.c_str());
+		QCOMPARE(ShvJournalBinFileWriter::convertLog2File(LOG2_FILE, LOG3_FILE), static_cast<int64_t>(entries.size()));
+		ShvJournalFileReader rd2(LOG2_FILE);
+		ShvJournalBinFileReader rd3(LOG3_FILE);
+		size_t cnt = 0;
+		while(rd2.next()) {
+			QVERIFY(rd3.next());
+			QVERIFY(rd2.entry() == rd3.entry());
+			cnt++;
+		}
+		QVERIFY(!rd3.next());
+		QCOMPARE(cnt, entries.size());
+	}
+
+	void readBenchmark_data()
+	{
+		QTest::addColumn<bool>("isLog3");
+		QTest::newRow("log2") << false;
+		QTest::newRow("log3") << true;
+	}
+	/// time per record, records per second are printed too
+	void readBenchmark()
+	{
+		static constexpr int RECORD_CNT = 100000;
+		QFETCH(bool, isLog3);
+		const std::vector<ShvJournalEntry> entries = createEntries(RECORD_CNT);
+		if(isLog3)
+			writeFile<ShvJournalBinFileWriter>(LOG3_FILE, entries);
+		else
+			writeFile<ShvJournalFileWriter>(LOG2_FILE, entries);
+		QElapsedTimer tm;
+		tm.start();
+		int64_t cnt = isLog3? readFile<ShvJournalBinFileReader>(LOG3_FILE): readFile<ShvJournalFileReader>(LOG2_FILE);
+		qint64 elapsed = tm.nsecsElapsed();
+		QCOMPARE(cnt, static_cast<int64_t>(RECORD_CNT));
+		std::ifstream in(isLog3? LOG3_FILE: LOG2_FILE, std::ios::binary | std::ios::ate);
+		qDebug() << (isLog3? "log3": "log2") << "file size:" << static_cast<qint64>(in.tellg())
+				 << "records/s:" << static_cast<qint64>(1e9 * RECORD_CNT / elapsed);
+		QTest::setBenchmarkResult(static_cast<qreal>(elapsed) / RECORD_CNT, QTest::WalltimeNanoseconds);
+	}
+
+	void cleanupTestCase()
+	{
+		std::remove(LOG2_FILE.c_str());
+		std::remove(LOG3_FILE.c_str());
+	}
+};
+
+QTEST_MAIN(TestShvJournalBinFile)
+#include "tst_shvjournalbinfile.moc"
@@ -3,6 +3,8 @@
 #include <shv/core/utils/shvlogtypeinfo.h>
 #include <shv/core/utils/shvjournalentry.h>
 #include <shv/core/utils/shvlogfilereader.h>
+#include <shv/core/utils/shvlogrpcvaluereader.h>
+#include <shv/core/utils/shvlogwriter.h>
 #include <shv/core/utils/shvjournalfilewriter.h>
 #include <shv/core/utils/shvjournalfilereader.h>
 #include <shv/core/utils/shvmemoryjournal.h>
@@ -16,8 +18,11 @@
 #include <QtTest/QtTest>
 #include <QDebug>
 #include <QDir>
+#include <QElapsedTimer>
 
+#include <cstdio>
 #include <fstream>
+#include <thread>
 
 using namespace std;
 using namespace shv::core::utils;
@@ -385,6 +390,251 @@ private slots:
 		test1();
 	}
 
+	void seekTest()
+	{
+		string fn = TEST_DIR + "/seek.log2";
+		std::remove(fn.c_str());
+		std::remove((fn + ShvFileJournal::INDEX_FILE_EXT).c_str());
+		std::vector<ShvJournalEntry> entries;
+		{
+			QDir().mkpath(QString::fromStdString(TEST_DIR));
+			ShvJournalFileWriter wr(fn);
+			int64_t msec = RpcValue::DateTime::now().msecsSinceEpoch();
+			for (int i = 0; i < 20000; ++i) {
+				// some records share timestamp
+				msec += i % 3;
+				ShvJournalEntry e("temperature", RpcValue::Decimal(i, -2), ShvJournalEntry::DOMAIN_VAL_CHANGE, i % 0x100, ShvJournalEntry::SampleType::Continuous, msec);
+				wr.append(e);
+				entries.push_back(e);
+			}
+		}
+		ShvJournalFileReader::Index index = ShvJournalFileReader::readIndex(fn);
+		QVERIFY(index.size() > 10);
+		QVERIFY(index == ShvJournalFileReader::rebuildIndex(fn));
+		auto check_seek = [&entries, &fn]() {
+			for(size_t ix : {size_t(0), size_t(1), entries.size() / 3, entries.size() / 2 + 7, entries.size() - 1}) {
+				int64_t since = entries[ix].epochMsec;
+				while(ix > 0 && entries[ix - 1].epochMsec == since)
+					ix--;
+				ShvJournalFileReader rd(fn);
+				rd.seek(since);
+				int skipped = 0;
+				while(rd.next() && rd.entry().epochMsec < since)
+					skipped++;
+				// index stride is small part of the file
+				QVERIFY(skipped < 1000);
+				QVERIFY(rd.entry() == entries[ix]);
+			}
+		};
+		check_seek();
+		// missing index is rebuilt
+		std::remove((fn + ShvFileJournal::INDEX_FILE_EXT).c_str());
+		check_seek();
+		QVERIFY(index == ShvJournalFileReader::readIndex(fn));
+	}
+
+	void parallelGetLogTest()
+	{
+		const string journal_dir = TEST_DIR + "/parallel";
+		QDir(QString::fromStdString(journal_dir)).removeRecursively();
+		ShvFileJournal file_journal("testdev", snapshot_fn);
+		file_journal.setJournalDir(journal_dir);
+		file_journal.setFileSizeLimit(int64_t(16 * 1024));
+		file_journal.setJournalSizeLimit(int64_t(1024 * 1024 * 1024));
+		int64_t msec1 = RpcValue::DateTime::now().msecsSinceEpoch();
+		int64_t msec = msec1;
+		for (int i = 0; i < 20000; ++i) {
+			msec += i % 5;
+			for(const auto &kv : channels) {
+				if(i % kv.second.period == 0)
+					file_journal.append(ShvJournalEntry(kv.first, i, kv.second.domain, ShvJournalEntry::NO_SHORT_TIME, ShvJournalEntry::SampleType::Continuous, msec));
+			}
+		}
+		int64_t msec2 = msec;
+		const ShvFileJournal::JournalContext &ctx = file_journal.checkJournalContext();
+		QVERIFY(ctx.files.size() > 50);
+
+		std::vector<ShvGetLogParams> params_list;
+		{
+			ShvGetLogParams params;
+			params.recordCountLimit = 1000000;
+			params_list.push_back(params);
+			params.since = RpcValue::DateTime::fromMSecsSinceEpoch(msec1 + (msec2 - msec1) / 3);
+			params.until = RpcValue::DateTime::fromMSecsSinceEpoch(msec2 - (msec2 - msec1) / 3);
+			params_list.push_back(params);
+			params.withSnapshot = true;
+			params_list.push_back(params);
+			params.pathPattern = "vetra/**";
+			params_list.push_back(params);
+			params.pathPattern.clear();
+			params.recordCountLimit = 500;
+			params_list.push_back(params);
+			params.withSnapshot = false;
+			params.until = RpcValue();
+			params_list.push_back(params);
+		}
+		for(const ShvGetLogParams &params : params_list) {
+			RpcValue log1 = ShvFileJournal::getLog(ctx, params);
+			RpcValue log2 = ShvFileJournal::getLog(ctx, params, 4);
+			QVERIFY(log1.asList().size() > 0);
+			QVERIFY(log1.asList() == log2.asList());
+			ShvLogHeader h1 = ShvLogHeader::fromMetaData(log1.metaData());
+			ShvLogHeader h2 = ShvLogHeader::fromMetaData(log2.metaData());
+			QCOMPARE(h1.recordCount(), h2.recordCount());
+			QCOMPARE(h1.recordCountLimitHit(), h2.recordCountLimitHit());
+			QVERIFY(h1.until() == h2.until());
+			QVERIFY(h1.pathDict() == h2.pathDict());
+		}
+	}
+
+	void streamGetLogTest()
+	{
+		const string journal_dir = TEST_DIR + "/stream";
+		QDir(QString::fromStdString(journal_dir)).removeRecursively();
+		ShvFileJournal file_journal("testdev", snapshot_fn);
+		file_journal.setJournalDir(journal_dir);
+		file_journal.setFileSizeLimit(int64_t(16 * 1024));
+		file_journal.setJournalSizeLimit(int64_t(1024 * 1024 * 1024));
+		int64_t msec1 = RpcValue::DateTime::now().msecsSinceEpoch();
+		int64_t msec = msec1;
+		for (int i = 0; i < 5000; ++i) {
+			msec += i % 5;
+			for(const auto &kv : channels) {
+				if(i % kv.second.period == 0)
+					file_journal.append(ShvJournalEntry(kv.first, i, kv.second.domain, ShvJournalEntry::NO_SHORT_TIME, ShvJournalEntry::SampleType::Continuous, msec));
+			}
+		}
+		int64_t msec2 = msec;
+		ShvMemoryJournal memory_journal;
+		{
+			ShvGetLogParams params;
+			params.recordCountLimit = 1000000;
+			memory_journal.loadLog(file_journal.getLog(params));
+		}
+
+		std::vector<ShvGetLogParams> params_list;
+		{
+			ShvGetLogParams params;
+			params.recordCountLimit = 1000000;
+			params_list.push_back(params);
+			params.withPathsDict = false;
+			params_list.push_back(params);
+			params.withPathsDict = true;
+			params.since = RpcValue::DateTime::fromMSecsSinceEpoch(msec1 + (msec2 - msec1) / 3);
+			params.withSnapshot = true;
+			params_list.push_back(params);
+			params.recordCountLimit = 500;
+			params_list.push_back(params);
+		}
+		for(const ShvGetLogParams &params : params_list) {
+			for(AbstractShvJournal *journal : std::vector<AbstractShvJournal*>{&file_journal, &memory_journal}) {
+				RpcValue log = journal->getLog(params);
+				QVERIFY(log.asList().size() > 0);
+				std::string data;
+				{
+					ChainPackWriter wr(data);
+					ShvLogStreamWriter log_wr(wr);
+					journal->getLog(params, log_wr);
+				}
+				ShvLogRpcValueReader rd1(log);
+				ChainPackReader cprd(data.data(), data.size());
+				ShvLogFileReader rd2(&cprd);
+				// streamed log can be read as a whole too
+				ShvLogRpcValueReader rd3(RpcValue::fromChainPack(data));
+				QVERIFY(rd2.logHeader().recordCount() == 0);
+				int cnt = 0;
+				while(rd1.next()) {
+					QVERIFY(rd2.next());
+					QVERIFY(rd3.next());
+					QVERIFY(rd1.entry() == rd2.entry());
+					QVERIFY(rd1.entry() == rd3.entry());
+					cnt++;
+				}
+				QVERIFY(!rd2.next());
+				QVERIFY(!rd3.next());
+				for(const ShvLogHeader &h : {rd2.logHeader(), rd3.logHeader()}) {
+					QCOMPARE(h.recordCount(), cnt);
+					QCOMPARE(h.recordCount(), rd1.logHeader().recordCount());
+					QCOMPARE(h.recordCountLimitHit(), rd1.logHeader().recordCountLimitHit());
+					QVERIFY(h.since() == rd1.logHeader().since());
+					QVERIFY(h.until() == rd1.logHeader().until());
+					QVERIFY(h.pathDict() == rd1.logHeader().pathDict());
+				}
+			}
+		}
+	}
+
+	/// buffered records are written after delay even if nothing else is appended
+	void groupCommitDelayTest()
+	{
+		const string journal_dir = TEST_DIR + "/groupcommit";
+		QDir(QString::fromStdString(journal_dir)).removeRecursively();
+		QDir().mkpath(QString::fromStdString(journal_dir));
+		const string file_name = journal_dir + "/test.log";
+		auto disk_file_size = [&file_name]() {
+			return static_cast<int64_t>(std::ifstream(file_name, std::ios::binary | std::ios::ate).tellg());
+		};
+		ShvJournalFileWriter wr(file_name);
+		wr.setGroupCommit(1024 * 1024, 50);
+		int64_t msec = RpcValue::DateTime::now().msecsSinceEpoch();
+		wr.append(ShvJournalEntry("vetra/status", 1, ShvJournalEntry::DOMAIN_VAL_CHANGE, ShvJournalEntry::NO_SHORT_TIME, ShvJournalEntry::SampleType::Continuous, msec));
+		QVERIFY(wr.fileSize() > 0);
+		QCOMPARE(disk_file_size(), int64_t(0));
+		QElapsedTimer tm;
+		tm.start();
+		while(disk_file_size() == 0 && tm.elapsed() < 5000)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		QCOMPARE(disk_file_size(), static_cast<int64_t>(wr.fileSize()));
+		// next record is buffered again
+		wr.append(ShvJournalEntry("vetra/status", 2, ShvJournalEntry::DOMAIN_VAL_CHANGE, ShvJournalEntry::NO_SHORT_TIME, ShvJournalEntry::SampleType::Continuous, msec + 1));
+		QVERIFY(disk_file_size() < wr.fileSize());
+		tm.start();
+		while(disk_file_size() < wr.fileSize() && tm.elapsed() < 5000)
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+		QCOMPARE(disk_file_size(), static_cast<int64_t>(wr.fileSize()));
+		// group commit without delay does not need flush thread
+		wr.setGroupCommit(1024 * 1024, 0);
+		wr.append(ShvJournalEntry("vetra/status", 3, ShvJournalEntry::DOMAIN_VAL_CHANGE, ShvJournalEntry::NO_SHORT_TIME, ShvJournalEntry::SampleType::Continuous, msec + 2));
+		QVERIFY(disk_file_size() < wr.fileSize());
+		wr.sync();
+		QCOMPARE(disk_file_size(), static_cast<int64_t>(wr.fileSize()));
+	}
+
+	void appendBenchmark_data()
+	{
+		QTest::addColumn<int>("groupCommitSize");
+		QTest::newRow("flushEveryRecord") << 0;
+		QTest::newRow("groupCommit") << 64 * 1024;
+	}
+	/// time per append, appends per second are printed too
+	void appendBenchmark()
+	{
+		static constexpr int RECORD_CNT = 50000;
+		QFETCH(int, groupCommitSize);
+		const string journal_dir = TEST_DIR + "/append";
+		QDir(QString::fromStdString(journal_dir)).removeRecursively();
+		ShvFileJournal file_journal("testdev", nullptr);
+		file_journal.setJournalDir(journal_dir);
+		file_journal.setJournalSizeLimit(int64_t(1024 * 1024 * 1024));
+		file_journal.setGroupCommit(static_cast<size_t>(groupCommitSize), 1000);
+		NecroLog::setTopicsLogTresholds("ShvJournal:W");
+		int64_t msec1 = RpcValue::DateTime::now().msecsSinceEpoch();
+		QElapsedTimer tm;
+		tm.start();
+		for (int i = 0; i < RECORD_CNT; ++i)
+			file_journal.append(ShvJournalEntry("vetra/status", i, ShvJournalEntry::DOMAIN_VAL_CHANGE, ShvJournalEntry::NO_SHORT_TIME, ShvJournalEntry::SampleType::Continuous, msec1 + i));
+		file_journal.sync();
+		qint64 elapsed = tm.nsecsElapsed();
+		NecroLog::setTopicsLogTresholds("ShvJournal:D");
+		ShvGetLogParams params;
+		params.recordCountLimit = RECORD_CNT;
+		RpcValue log = file_journal.getLog(params);
+		QCOMPARE(static_cast<int>(log.asList().size()), RECORD_CNT);
+		QVERIFY(log.asList().back().asList().value(ShvLogHeader::Column::Value) == RpcValue(RECORD_CNT - 1));
+		qDebug() << "group commit size:" << groupCommitSize << "appends/s:" << static_cast<qint64>(1e9 * RECORD_CNT / elapsed);
+		QTest::setBenchmarkResult(static_cast<qreal>(elapsed) / RECORD_CNT, QTest::WalltimeNanoseconds);
+	}
+
 	void cleanupTestCase()
 	{
 		//qDebug("called after firstTest and secondTest");
@@ -2,9 +2,14 @@
 #include <shv/core/utils/shvlogheader.h>
 #include <shv/core/utils/shvjournalentry.h>
 #include <shv/core/utils/shvmemoryjournal.h>
+#include <shv/core/utils/patternmatcher.h>
+#include <shv/core/utils/shvlogrpcvaluereader.h>
 
 #include <QtTest/QtTest>
 #include <QDebug>
+#include <QElapsedTimer>
+
+#include <random>
 
 using namespace shv::core::utils;
 using namespace shv::chainpack;
@@ -62,6 +67,30 @@ private:
 
 		QVERIFY(log1.toList().size() == log2.toList().size());
 	}
+
+	/// journal with PATH_CNT paths, every 7th entry is out of order
+	static void fillJournal(ShvMemoryJournal &journal, std::vector<ShvJournalEntry> *expected, int entry_cnt)
+	{
+		static constexpr int PATH_CNT = 10;
+		std::mt19937 gen(1234);
+		std::uniform_int_distribution<int> value_dist(-1000, 1000);
+		for (int i = 0; i < entry_cnt; ++i) {
+			std::string path = "zone" + std::to_string(i % 2) + "/sensor" + std::to_string(i % PATH_CNT);
+			int64_t time = 1000 + i * 10;
+			if(i % 7 == 6)
+				time -= 1000 + (i % 5) * 10;
+			RpcValue value = (i % 11 == 0)? RpcValue("n/a"): RpcValue(value_dist(gen));
+			appendEntry(journal, path, value, time);
+			if(!expected)
+				continue;
+			ShvJournalEntry e(path, value, ShvJournalEntry::DOMAIN_VAL_CHANGE, ShvJournalEntry::NO_SHORT_TIME, ShvJournalEntry::SampleType::Continuous, time);
+			// reference of entries order, out of order entry is inserted after entries with the same time
+			auto it = std::upper_bound(expected->begin(), expected->end(), e, [](const ShvJournalEntry &e1, const ShvJournalEntry &e2) {
+				return e1.epochMsec < e2.epochMsec;
+			});
+			expected->insert(it, e);
+		}
+	}
 private slots:
 	void initTestCase()
 	{
@@ -71,6 +100,192 @@ private slots:
 		test1();
 	}
 
+	void outOfOrderTest()
+	{
+		ShvMemoryJournal journal;
+		std::vector<ShvJournalEntry> expected;
+		fillJournal(journal, &expected, 2000);
+		QCOMPARE(journal.size(), expected.size());
+		for (size_t i = 0; i < expected.size(); ++i) {
+			QCOMPARE(journal.at(i).epochMsec, expected[i].epochMsec);
+			QCOMPARE(journal.at(i).path, expected[i].path);
+			QVERIFY(journal.at(i).value == expected[i].value);
+		}
+		// entry inserted to the beginning shifts all the path indexes
+		const std::string path = "zone1/sensor3";
+		const size_t path_cnt = journal.pathEntryIndexes(path).size();
+		appendEntry(journal, path, 5000, 1);
+		QCOMPARE(journal.epochMsecAt(0), static_cast<int64_t>(1));
+		std::vector<size_t> ixs = journal.pathEntryIndexes(path);
+		QCOMPARE(ixs.size(), path_cnt + 1);
+		QCOMPARE(ixs.front(), static_cast<size_t>(0));
+		for(size_t ix : ixs)
+			QCOMPARE(journal.pathAt(ix), path);
+		QCOMPARE(journal.pathValueRange(path).max, 5000.);
+		QCOMPARE(journal.pathValueRange(path, 2).max, journal.pathValueRange(path, 1000).max);
+	}
+
+	/// entries() vector created on first call is kept in sync with appended entries
+	void entriesTest()
+	{
+		ShvMemoryJournal journal;
+		fillJournal(journal, nullptr, 100);
+		const std::vector<ShvJournalEntry> &entries = journal.entries();
+		QCOMPARE(entries.size(), journal.size());
+		fillJournal(journal, nullptr, 50);
+		appendEntry(journal, "foo/bar", 42, 1);
+		QCOMPARE(entries.size(), journal.size());
+		for (size_t i = 0; i < journal.size(); ++i)
+			QVERIFY(entries[i] == journal.entryAt(i));
+		QCOMPARE(journal.at(0).path, std::string("foo/bar"));
+
+		ShvMemoryJournal journal2 = journal;
+		QCOMPARE(journal2.entries().size(), journal.size());
+		QVERIFY(&journal2.entries() != &entries);
+		journal.clear();
+		QVERIFY(journal.entries().empty());
+		QCOMPARE(journal2.entries().size(), journal2.size());
+	}
+
+	void pathPatternGetLogTest_data()
+	{
+		QTest::addColumn<QString>("pattern");
+		QTest::addColumn<bool>("isRegEx");
+		QTest::newRow("path") << "zone1/sensor3" << false;
+		QTest::newRow("wildcard") << "zone0/*" << false;
+		QTest::newRow("regex") << "sensor[25]$" << true;
+	}
+	/// getLog using path index returns the same records as filtering of whole log
+	void pathPatternGetLogTest()
+	{
+		QFETCH(QString, pattern);
+		QFETCH(bool, isRegEx);
+		ShvMemoryJournal journal;
+		std::vector<ShvJournalEntry> expected;
+		fillJournal(journal, &expected, 2000);
+		ShvGetLogParams params;
+		params.since = RpcValue::DateTime::fromMSecsSinceEpoch(5000);
+		params.until = RpcValue::DateTime::fromMSecsSinceEpoch(15000);
+		params.withSnapshot = true;
+		params.withPathsDict = false;
+		params.recordCountLimit = 10000;
+		RpcValue::List all_log = journal.getLog(params).toList();
+		params.pathPattern = pattern.toStdString();
+		params.pathPatternType = isRegEx? ShvGetLogParams::PatternType::RegEx: ShvGetLogParams::PatternType::WildCard;
+		RpcValue::List log = journal.getLog(params).toList();
+		PatternMatcher pm(params);
+		RpcValue::List filtered_log;
+		for(const RpcValue &rec : all_log) {
+			const RpcValue path = rec.toList().value(ShvLogHeader::Column::Path);
+			if(pm.matchPath(path.asString()))
+				filtered_log.push_back(rec);
+		}
+		QVERIFY(!log.empty());
+		QCOMPARE(RpcValue(log).toCpon(), RpcValue(filtered_log).toCpon());
+	}
+
+	void pathQueryTest()
+	{
+		ShvMemoryJournal journal;
+		std::vector<ShvJournalEntry> expected;
+		fillJournal(journal, &expected, 5000);
+		const std::string path = "zone1/sensor3";
+		for(int64_t since : {0, 1000, 7777, 20000}) {
+			for(int64_t until : {0, 1000, 13001, 40000, 60000}) {
+				std::vector<size_t> ixs;
+				ShvMemoryJournal::ValueRange range;
+				for (size_t i = 0; i < expected.size(); ++i) {
+					const ShvJournalEntry &e = expected[i];
+					if(e.path != path || e.epochMsec < since || (until > 0 && e.epochMsec >= until))
+						continue;
+					ixs.push_back(i);
+					if(e.value.isInt())
+						range.add(e.value.toDouble());
+				}
+				QVERIFY(journal.pathEntryIndexes(path, since, until) == ixs);
+				ShvMemoryJournal::ValueRange range2 = journal.pathValueRange(path, since, until);
+				QCOMPARE(range2.isValid(), range.isValid());
+				if(range.isValid()) {
+					QCOMPARE(range2.min, range.min);
+					QCOMPARE(range2.max, range.max);
+				}
+			}
+		}
+		std::vector<ShvMemoryJournal::ValueBucket> buckets = journal.decimate(path, 2000, 42000, 37);
+		QCOMPARE(buckets.size(), static_cast<size_t>(37));
+		for(const ShvMemoryJournal::ValueBucket &bucket : buckets) {
+			int64_t until = (&bucket == &buckets.back())? 42000: (&bucket + 1)->sinceMsec;
+			QCOMPARE(bucket.count, journal.pathEntryIndexes(path, bucket.sinceMsec, until).size());
+			ShvMemoryJournal::ValueRange range = journal.pathValueRange(path, bucket.sinceMsec, until);
+			QCOMPARE(bucket.range.min, range.min);
+			QCOMPARE(bucket.range.max, range.max);
+		}
+		QVERIFY(journal.pathEntryIndexes("foo").empty());
+		QVERIFY(!journal.pathValueRange("foo").isValid());
+	}
+
+	void pathDictionaryTest()
+	{
+		auto dict = std::make_shared<ShvPathDictionary>();
+		ShvMemoryJournal journal1(dict);
+		ShvMemoryJournal journal2(dict);
+		appendEntry(journal1, "a/b", 1, 100);
+		appendEntry(journal2, "c", 2, 100);
+		appendEntry(journal2, "a/b", 3, 200);
+		QCOMPARE(dict->size(), static_cast<size_t>(2));
+		QCOMPARE(dict->id("a/b"), static_cast<uint32_t>(0));
+		QCOMPARE(dict->id("x"), ShvPathDictionary::NO_ID);
+		QCOMPARE(journal2.pathAt(1), std::string("a/b"));
+		QVERIFY(journal2.at(0) == ShvJournalEntry("c", 2, ShvJournalEntry::DOMAIN_VAL_CHANGE, ShvJournalEntry::NO_SHORT_TIME, ShvJournalEntry::SampleType::Continuous, 100));
+
+		ShvGetLogParams params;
+		params.withPathsDict = true;
+		ShvLogRpcValueReader rd(journal2.getLog(params));
+		std::vector<std::string> paths;
+		while(rd.next())
+			paths.push_back(rd.entry().path);
+		QVERIFY(paths == std::vector<std::string>({"c", "a/b"}));
+		QCOMPARE(rd.logHeader().pathDict().size(), static_cast<size_t>(2));
+	}
+
+	void pathQueryBenchmark_data()
+	{
+		QTest::addColumn<bool>("isIndexed");
+		QTest::newRow("scan") << false;
+		QTest::newRow("pyramid") << true;
+	}
+	/// min and max of one path in time range, scan is the way it had to be done without path index
+	void pathQueryBenchmark()
+	{
+		static constexpr int QUERY_CNT = 100;
+		QFETCH(bool, isIndexed);
+		ShvMemoryJournal journal;
+		fillJournal(journal, nullptr, 1000000);
+		const std::string path = "zone1/sensor3";
+		const std::vector<ShvJournalEntry> &entries = journal.entries();
+		double sum = 0;
+		QElapsedTimer tm;
+		tm.start();
+		for (int i = 0; i < QUERY_CNT; ++i) {
+			int64_t since = 1000 + i * 1000;
+			int64_t until = since + 5000000;
+			ShvMemoryJournal::ValueRange range;
+			if(isIndexed) {
+				range = journal.pathValueRange(path, since, until);
+			}
+			else {
+				for(const ShvJournalEntry &e : entries) {
+					if(e.epochMsec >= since && e.epochMsec < until && e.path == path && e.value.isInt())
+						range.add(e.value.toDouble());
+				}
+			}
+			sum += range.max - range.min;
+		}
+		qint64 elapsed = tm.nsecsElapsed();
+		QVERIFY(sum > 0);
+		QTest::setBenchmarkResult(static_cast<qreal>(elapsed) / QUERY_CNT, QTest::WalltimeNanoseconds);
+	}
+
 	void cleanupTestCase()
 	{
 		//qDebug("called after firstTest and secondTest");
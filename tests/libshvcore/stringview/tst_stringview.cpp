@@ -3,6 +3,8 @@
 #include <QtTest/QtTest>
 #include <QDebug>
 
+#include <unordered_map>
+
 using std::string;
 
 namespace {
@@ -150,6 +152,22 @@ private slots:
 		testStringView();
 	}
 
+	void hashTest()
+	{
+		std::string str("foo/bar/foo");
+		std::vector<shv::core::StringView> sl = shv::core::StringView(str).split('/');
+		std::hash<shv::core::StringView> hash;
+		QCOMPARE(hash(sl[0]), hash(sl[2]));
+		QVERIFY(hash(sl[0]) != hash(sl[1]));
+		QCOMPARE(hash(shv::core::StringView()), hash(shv::core::StringView(str, 4, 0)));
+
+		std::string key("bar");
+		std::unordered_map<shv::core::StringView, int> map;
+		map[shv::core::StringView(key)] = 1;
+		QVERIFY(map.find(sl[1]) != map.end());
+		QVERIFY(map.find(sl[0]) == map.end());
+	}
+
 	void cleanupTestCase()
 	{
 		//qDebug("called after firstTest and secondTest");
@@ -4,4 +4,6 @@ CONFIG += ordered
 unix {
 SUBDIRS += \
 	shvjournal \
+	shvnode \
+	socketrpcconnection \
 }
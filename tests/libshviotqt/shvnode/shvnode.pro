@@ -0,0 +1,8 @@
+include ( ../test_libshviotqt.pri )
+
+TARGET = tst_shvnode
+
+
+SOURCES += \
+    $${TARGET}.cpp \
+
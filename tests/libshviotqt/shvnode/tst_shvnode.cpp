@@ -0,0 +1,248 @@
+#include <shv/iotqt/node/shvnode.h>
+#include <shv/iotqt/node/shvnodetree.h>
+#include <shv/core/exception.h>
+#include <shv/core/utils/shvpath.h>
+#include <shv/chainpack/rpcmessage.h>
+#include <shv/chainpack/rpc.h>
+
+#include <QtTest/QtTest>
+#include <QDebug>
+#include <QElapsedTimer>
+
+using namespace shv::iotqt::node;
+namespace cp = shv::chainpack;
+
+namespace {
+
+/// records requests instead of handling them, like mount point of device on broker does
+class RecordingNode : public ShvNode
+{
+	using Super = ShvNode;
+public:
+	RecordingNode(const std::string &node_id, ShvNode *parent) : Super(node_id, parent) {}
+
+	void handleRawRpcRequest(cp::RpcValue::MetaData &&meta, std::string &&data) override
+	{
+		Q_UNUSED(data)
+		shvPaths.push_back(cp::RpcMessage::shvPath(meta).toString());
+	}
+
+	std::vector<std::string> shvPaths;
+};
+
+/// provides child which is not in children index, like nodes created on demand
+class VirtualParentNode : public ShvNode
+{
+	using Super = ShvNode;
+public:
+	VirtualParentNode(const std::string &node_id, ShvNode *parent) : Super(node_id, parent), virtualChild("virtual", nullptr)
+	{
+		new ShvNode("leaf", &virtualChild);
+	}
+
+	using Super::childNode;
+	ShvNode* childNode(const StringView &name, bool throw_exc = true) const override
+	{
+		if(name == "virtual")
+			return const_cast<RecordingNode*>(&virtualChild);
+		return Super::childNode(name, throw_exc);
+	}
+
+	RecordingNode virtualChild;
+};
+
+cp::RpcRequest ls_request(const std::string &shv_path)
+{
+	cp::RpcRequest rq;
+	rq.setRequestId(1);
+	rq.setMethod(cp::Rpc::METH_LS);
+	rq.setShvPath(shv_path);
+	rq.setAccessGrant(cp::Rpc::ROLE_READ);
+	rq.setProtocolType(cp::Rpc::ProtocolType::ChainPack);
+	return rq;
+}
+
+/// data part of raw message as it comes from socket
+std::string raw_data(const cp::RpcRequest &rq)
+{
+	cp::RpcValue body = rq.value();
+	body.setMetaData(cp::RpcValue::MetaData());
+	return body.toChainPack();
+}
+
+/// routing the way it was done before, shv path is split, rejoined and written to meta data
+/// and response is created on every level
+void route_per_level(ShvNode *nd, cp::RpcValue::MetaData &&meta, std::string &&data)
+{
+	const std::string shv_path_str = cp::RpcMessage::shvPath(meta).toString();
+	shv::core::StringViewList shv_path = shv::core::utils::ShvPath::split(shv_path_str);
+	cp::RpcResponse resp = cp::RpcResponse::forRequest(meta);
+	if(!shv_path.empty()) {
+		ShvNode *child = nd->childNode(shv_path.at(0).toString(), false);
+		if(child) {
+			cp::RpcMessage::setShvPath(meta, shv::core::StringView::join(++shv_path.begin(), shv_path.end(), '/'));
+			route_per_level(child, std::move(meta), std::move(data));
+			return;
+		}
+	}
+	nd->handleRawRpcRequest(std::move(meta), std::move(data));
+}
+
+}
+
+class TestShvNode: public QObject
+{
+	Q_OBJECT
+private slots:
+	void childNodeTest()
+	{
+		ShvRootNode root(nullptr);
+		ShvNode *a = new ShvNode("a", &root);
+		ShvNode *b = new ShvNode(&root);
+		b->setNodeId("b");
+		QCOMPARE(root.childNode("a", false), a);
+		QCOMPARE(root.childNode("b", false), b);
+		QVERIFY(root.childNode("x", false) == nullptr);
+		QVERIFY_EXCEPTION_THROWN(root.childNode("x"), shv::core::Exception);
+
+		std::string path("x/a/y");
+		shv::core::StringViewList lst = shv::core::utils::ShvPath::split(path);
+		QCOMPARE(root.childNode(lst[1], false), a);
+
+		// rename
+		a->setNodeId("c");
+		QVERIFY(root.childNode("a", false) == nullptr);
+		QCOMPARE(root.childNode("c", false), a);
+
+		// reparent
+		b->setParentNode(a);
+		QVERIFY(root.childNode("b", false) == nullptr);
+		QCOMPARE(a->childNode("b", false), b);
+		b->setParent(&root);
+		QVERIFY(a->childNode("b", false) == nullptr);
+		QCOMPARE(root.childNode("b", false), b);
+
+		// delete
+		delete b;
+		QVERIFY(root.childNode("b", false) == nullptr);
+		QVERIFY(root.childNames() == ShvNode::StringList{"c"});
+	}
+
+	void duplicateIdTest()
+	{
+		ShvRootNode root(nullptr);
+		ShvNode *d1 = new ShvNode("d", &root);
+		ShvNode *d2 = new ShvNode("d", &root);
+		QCOMPARE(root.childNode("d", false), d1);
+		delete d1;
+		QCOMPARE(root.childNode("d", false), d2);
+		delete d2;
+		QVERIFY(root.childNode("d", false) == nullptr);
+	}
+
+	void nodeTreeTest()
+	{
+		ShvNodeTree tree;
+		ShvNode *nd = new ShvNode(nullptr);
+		QVERIFY(tree.mount("x/y/z", nd));
+		ShvNode nd2(nullptr);
+		QVERIFY(!tree.mount("x/y/z", &nd2));
+		QCOMPARE(tree.cd("x/y/z"), nd);
+		std::string rest;
+		QCOMPARE(tree.cd("x/y/z/w/v", &rest), nd);
+		QVERIFY(rest == "w/v");
+	}
+
+	void routingTest()
+	{
+		ShvNodeTree tree;
+		RecordingNode *device = new RecordingNode("device", tree.mkdir("a/b"));
+		std::vector<cp::RpcMessage> responses;
+		connect(tree.root(), &ShvNode::sendRpcMessage, [&responses](const cp::RpcMessage &msg) {
+			responses.push_back(msg);
+		});
+
+		// reimplemented handler gets path relative to its node
+		cp::RpcRequest rq = ls_request("a/b/device/x/y");
+		tree.root()->handleRawRpcRequest(cp::RpcValue::MetaData(rq.metaData()), raw_data(rq));
+		QVERIFY(device->shvPaths == std::vector<std::string>{"x/y"});
+		QVERIFY(responses.empty());
+
+		// method of plain node in the middle of the tree
+		rq = ls_request("a/b");
+		tree.root()->handleRawRpcRequest(cp::RpcValue::MetaData(rq.metaData()), raw_data(rq));
+		QCOMPARE(responses.size(), static_cast<size_t>(1));
+		QCOMPARE(cp::RpcResponse(responses[0]).result().toCpon(), std::string("[\"device\"]"));
+
+		tree.root()->handleRpcRequest(ls_request("a"));
+		QCOMPARE(responses.size(), static_cast<size_t>(2));
+		QCOMPARE(cp::RpcResponse(responses[1]).result().toCpon(), std::string("[\"b\"]"));
+
+		// path which does not exist
+		tree.root()->handleRpcRequest(ls_request("a/x/y"));
+		QCOMPARE(responses.size(), static_cast<size_t>(3));
+		QVERIFY(cp::RpcResponse(responses[2]).isError());
+	}
+
+	/// reimplemented childNode() is used for routing
+	void virtualChildTest()
+	{
+		ShvNodeTree tree;
+		VirtualParentNode *parent = new VirtualParentNode("parent", tree.root());
+		QVERIFY(parent->childNode(std::string("virtual"), false) == &parent->virtualChild);
+		const std::string path("virtual");
+		const shv::core::StringViewList shv_path = shv::core::utils::ShvPath::split(path);
+		QVERIFY(parent->childNames(shv_path) == ShvNode::StringList{"leaf"});
+		QVERIFY(parent->hasChildren(shv_path).toBool());
+		cp::RpcRequest rq = ls_request("parent/virtual/x");
+		tree.root()->handleRawRpcRequest(cp::RpcValue::MetaData(rq.metaData()), raw_data(rq));
+		QVERIFY(parent->virtualChild.shvPaths == std::vector<std::string>{"x"});
+	}
+
+	void routingBenchmark_data()
+	{
+		QTest::addColumn<bool>("isPerLevel");
+		QTest::newRow("per-level") << true;
+		QTest::newRow("single-pass") << false;
+	}
+	/// ls request to node on depth 8, every level has 100 siblings
+	void routingBenchmark()
+	{
+		static constexpr int DEPTH = 8;
+		static constexpr int FAN_OUT = 100;
+		static constexpr int REQUEST_CNT = 20000;
+		QFETCH(bool, isPerLevel);
+		ShvNodeTree tree;
+		std::string shv_path;
+		for (int level = 0; level < DEPTH; ++level) {
+			ShvNode *parent = tree.cd(shv_path);
+			for (int i = 0; i < FAN_OUT; ++i)
+				new ShvNode("node" + std::to_string(i), parent);
+			if(!shv_path.empty())
+				shv_path += '/';
+			shv_path += "node" + std::to_string(FAN_OUT / 2);
+		}
+		int response_cnt = 0;
+		connect(tree.root(), &ShvNode::sendRpcMessage, [&response_cnt](const cp::RpcMessage &msg) {
+			if(!cp::RpcResponse(msg).isError())
+				response_cnt++;
+		});
+		const cp::RpcRequest rq = ls_request(shv_path);
+		const std::string data = raw_data(rq);
+		QElapsedTimer tm;
+		tm.start();
+		for (int i = 0; i < REQUEST_CNT; ++i) {
+			cp::RpcValue::MetaData meta(rq.metaData());
+			if(isPerLevel)
+				route_per_level(tree.root(), std::move(meta), std::string(data));
+			else
+				tree.root()->handleRawRpcRequest(std::move(meta), std::string(data));
+		}
+		qint64 elapsed = tm.nsecsElapsed();
+		QCOMPARE(response_cnt, REQUEST_CNT);
+		QTest::setBenchmarkResult(static_cast<qreal>(elapsed) / REQUEST_CNT, QTest::WalltimeNanoseconds);
+	}
+};
+
+QTEST_MAIN(TestShvNode)
+#include "tst_shvnode.moc"
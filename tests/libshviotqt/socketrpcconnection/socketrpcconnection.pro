@@ -0,0 +1,10 @@
+include ( ../test_libshviotqt.pri )
+
+QT += network
+
+TARGET = tst_socketrpcconnection
+
+
+SOURCES += \
+    $${TARGET}.cpp \
+
@@ -0,0 +1,132 @@
+#include <shv/iotqt/rpc/socket.h>
+#include <shv/iotqt/rpc/socketrpcconnection.h>
+#include <shv/chainpack/rpcdriver.h>
+#include <shv/chainpack/rpcmessage.h>
+
+#include <QtTest/QtTest>
+#include <QDebug>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include <string>
+#include <vector>
+
+using namespace shv::iotqt::rpc;
+namespace cp = shv::chainpack;
+
+namespace {
+
+/// connection over real TCP socket, as broker has for its clients
+class TestConnection : public SocketRpcConnection
+{
+public:
+	TestConnection(QTcpSocket *socket)
+	{
+		setProtocolType(cp::Rpc::ProtocolType::ChainPack);
+		setSocket(new TcpSocket(socket));
+	}
+
+	void close() override { closeSocket(); }
+	void abort() override { abortSocket(); }
+	void sendMessage(const cp::RpcMessage &rpc_msg) override { sendRpcValue(rpc_msg.value()); }
+	void onRpcMessageReceived(const cp::RpcMessage &msg) override { Q_UNUSED(msg) }
+
+	qint64 socketBytesToWrite() { return socket()->bytesToWrite(); }
+	qint64 socketMaxBytesToWrite() { return socket()->maxBytesToWrite(); }
+};
+
+/// decodes data read by peer socket
+class ReceiverRpcDriver : public cp::RpcDriver
+{
+public:
+	ReceiverRpcDriver()
+	{
+		setProtocolType(cp::Rpc::ProtocolType::ChainPack);
+	}
+
+	void receiveData(std::string &&data) { onBytesRead(std::move(data)); }
+
+	std::vector<cp::RpcValue> receivedMessages;
+protected:
+	bool isOpen() override { return true; }
+	void writeMessageBegin() override {}
+	void writeMessageEnd() override {}
+	int64_t writeBytes(const char *bytes, size_t length) override { Q_UNUSED(bytes) return static_cast<int64_t>(length); }
+	void onRpcValueReceived(const cp::RpcValue &msg) override { receivedMessages.push_back(msg); }
+	void onProcessReadDataException(std::exception &e) override { qWarning() << "process read data exception:" << e.what(); }
+};
+
+cp::RpcValue create_signal(int n, const std::string &payload)
+{
+	cp::RpcSignal sig;
+	sig.setMethod(cp::Rpc::SIG_VAL_CHANGED);
+	sig.setShvPath("test/node/" + std::to_string(n % 100) + "/status");
+	sig.setParams(cp::RpcValue::List{n, payload});
+	return sig.value();
+}
+}
+
+class TestSocketRpcConnection : public QObject
+{
+	Q_OBJECT
+private slots:
+	/// peer does not read, data pile up in socket buffers and then in send queue, where watermarks apply
+	void slowPeerTest()
+	{
+		static constexpr int MSG_CNT = 5000;
+		static constexpr size_t HIGH_WATERMARK = 1024 * 1024;
+		const std::string payload(10 * 1024, 'x');
+
+		QTcpServer server;
+		QVERIFY(server.listen(QHostAddress::LocalHost));
+		QTcpSocket peer;
+		// peer reads only this much from kernel buffer
+		peer.setReadBufferSize(4096);
+		peer.connectToHost(server.serverAddress(), server.serverPort());
+		QVERIFY(peer.waitForConnected(1000));
+		QVERIFY(server.waitForNewConnection(1000));
+		TestConnection conn(server.nextPendingConnection());
+		QVERIFY(conn.isSocketConnected());
+
+		cp::RpcDriver::SendQueueLimits limits;
+		limits.highWatermarkBytes = HIGH_WATERMARK;
+		limits.overflowPolicy = cp::RpcDriver::SendQueueOverflowPolicy::DropOldestSignals;
+		conn.setSendQueueLimits(limits);
+
+		cp::RpcRequest rq;
+		rq.setRequestId(1);
+		rq.setMethod("foo");
+		conn.sendRpcValue(rq.value());
+		for (int i = 0; i < MSG_CNT; ++i) {
+			conn.sendRpcValue(create_signal(i, payload));
+			QVERIFY(conn.sendQueueBytes() <= HIGH_WATERMARK);
+			if(i % 10 == 0)
+				QCoreApplication::processEvents();
+		}
+		// 50MB cannot fit to socket buffers, so signals were dropped from send queue
+		QVERIFY(conn.writeStats().droppedMessages > 0);
+		QVERIFY(conn.sendQueueLength() > 0);
+		// socket wrapper accepts only up to its limit plus single write batch
+		QVERIFY(conn.socketBytesToWrite() <= conn.socketMaxBytesToWrite()
+				+ static_cast<qint64>(cp::RpcDriver::writeBatchMaxBytes() + 2 * payload.size()));
+
+		// peer starts to read, whole send queue is delivered then
+		ReceiverRpcDriver receiver;
+		peer.setReadBufferSize(0);
+		auto read_peer = [&peer, &receiver]() {
+			QByteArray ba = peer.readAll();
+			if(!ba.isEmpty())
+				receiver.receiveData(ba.toStdString());
+		};
+		QTRY_VERIFY_WITH_TIMEOUT((read_peer(), conn.sendQueueLength() == 0 && conn.socketBytesToWrite() == 0), 10000);
+		QTRY_VERIFY_WITH_TIMEOUT((read_peer(), !receiver.receivedMessages.empty()
+				&& cp::RpcSignal(receiver.receivedMessages.back()).params().toList().at(0) == cp::RpcValue(MSG_CNT - 1)), 10000);
+
+		// request is never dropped
+		QVERIFY(cp::RpcMessage(receiver.receivedMessages.front()).isRequest());
+		QCOMPARE(static_cast<uint64_t>(receiver.receivedMessages.size()) + conn.writeStats().droppedMessages, static_cast<uint64_t>(MSG_CNT) + 1);
+	}
+};
+
+QTEST_MAIN(TestSocketRpcConnection)
+#include "tst_socketrpcconnection.moc"
@@ -1,5 +1,6 @@
 CONFIG += testcase # enable make check
 CONFIG += c++11
+include( $$PWD/../libshvchainpack/rpcvalueflatmap.pri )
 #QT -= core
 QT += testlib # enable test framework
 
@@ -5,4 +5,5 @@ SUBDIRS += \
 	libshvchainpack \
 	libshvcore \
 	libshviotqt \
+	libshvbroker \
 
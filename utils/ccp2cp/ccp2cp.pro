@@ -1,4 +1,5 @@
 TEMPLATE = app
+include( $$PWD/../../libshvchainpack/rpcvalueflatmap.pri )
 
 QT -= core widgets gui
 